@@ -0,0 +1,89 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Benchmark
+{
+    using System;
+
+    [BenchmarkClass]
+    public class FunctionCall
+    {
+        private LuaBridge lua;
+
+        private LuaFunction f;
+
+        private object[][] args1;
+        private object[][] args16;
+        private object[][] args256;
+        private object[][] args4096;
+
+        private object[] results;
+
+        [ClassInitialize]
+        public void Initialize()
+        {
+            lua = new LuaBridge();
+
+            f = lua.Do("return function(x, y) return x + y end")[0] as LuaFunction;
+
+            args1 = MakeArgumentLists(1);
+            args16 = MakeArgumentLists(16);
+            args256 = MakeArgumentLists(256);
+            args4096 = MakeArgumentLists(4096);
+
+            results = new object[4096];
+        }
+
+        private static object[][] MakeArgumentLists( int count )
+        {
+            var argumentLists = new object[count][];
+
+            for (int i = 0; i < count; ++i)
+                argumentLists[i] = new object[] { i, 1 };
+
+            return argumentLists;
+        }
+
+        [ClassCleanup]
+        public void Cleanup()
+        {
+            lua.Dispose();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void Call()
+        {
+            f.CallExpectingResults(1, 1, 1);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void CallBatch1()
+        {
+            f.CallBatch(1, args1, results);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 16)]
+        public void CallBatch16()
+        {
+            f.CallBatch(1, args16, results);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 256)]
+        public void CallBatch256()
+        {
+            f.CallBatch(1, args256, results);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 4096)]
+        public void CallBatch4096()
+        {
+            f.CallBatch(1, args4096, results);
+        }
+    }
+}
@@ -0,0 +1,118 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Benchmark
+{
+    using System;
+    using System.Collections.Generic;
+    using System.Diagnostics;
+
+    [BenchmarkClass]
+    public class GarbageCollection
+    {
+        private LuaBridge incremental;
+        private LuaBridge generational;
+        private LuaBridge idleStepped;
+
+        private LuaFunction incrementalWork;
+        private LuaFunction generationalWork;
+        private LuaFunction idleSteppedWork;
+
+        private readonly List<long> incrementalLatencies = new List<long>();
+        private readonly List<long> generationalLatencies = new List<long>();
+        private readonly List<long> idleSteppedLatencies = new List<long>();
+
+        // short-lived garbage, and a ring of long-lived tables that keeps the heap large
+        private const string work = @"
+            local live, n = {}, 0
+            return function()
+                for i = 1, 200 do
+                    local t = { i, i * 0.5, 'x' .. i }
+                    n = n % 4096 + 1
+                    if i % 16 == 0 then live[n] = t end
+                end
+            end";
+
+        private static readonly TimeSpan idleTime = TimeSpan.FromMilliseconds(0.2);
+
+        [ClassInitialize]
+        public void Initialize()
+        {
+            incremental = new LuaBridge();
+            incrementalWork = incremental.Do(work)[0] as LuaFunction;
+
+            generational = new LuaBridge();
+            generational.GarbageCollectorMode = GarbageCollectorMode.Generational;
+            generationalWork = generational.Do(work)[0] as LuaFunction;
+
+            idleStepped = new LuaBridge();
+            idleSteppedWork = idleStepped.Do(work)[0] as LuaFunction;
+        }
+
+        [ClassCleanup]
+        public void Cleanup()
+        {
+            Report("Incremental", incrementalLatencies);
+            Report("Generational", generationalLatencies);
+            Report("IncrementalIdleStepped", idleSteppedLatencies);
+
+            incremental.Dispose();
+            generational.Dispose();
+            idleStepped.Dispose();
+        }
+
+        private static void Report( string name, List<long> latencies )
+        {
+            if (latencies.Count == 0)
+                return;
+
+            latencies.Sort();
+
+            Console.WriteLine("{0} latency:", name);
+
+            foreach (double percentile in new[] { 50, 90, 99, 99.9, 100 })
+            {
+                int index = Math.Min(latencies.Count - 1, (int)(latencies.Count * percentile / 100));
+                double microseconds = latencies[index] * 1e6 / Stopwatch.Frequency;
+
+                Console.WriteLine("\tp{0}  {1:F1} us", percentile, microseconds);
+            }
+        }
+
+        private static void Tick( LuaFunction work, List<long> latencies )
+        {
+            long start = Stopwatch.GetTimestamp();
+
+            work.Call();
+
+            latencies.Add(Stopwatch.GetTimestamp() - start);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void Incremental()
+        {
+            Tick(incrementalWork, incrementalLatencies);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void Generational()
+        {
+            Tick(generationalWork, generationalLatencies);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void IncrementalIdleStepped()
+        {
+            Tick(idleSteppedWork, idleSteppedLatencies);
+
+            // the rest of the frame is idle, so collect during it
+            idleStepped.StepGarbageUntil(DateTime.UtcNow + idleTime);
+        }
+    }
+}
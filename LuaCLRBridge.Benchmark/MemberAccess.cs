@@ -0,0 +1,99 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Benchmark
+{
+    using System;
+
+    [BenchmarkClass]
+    public class MemberAccess
+    {
+        private LuaBridge lua;
+
+        private LuaFunction o_get_field;
+        private LuaFunction o_set_field;
+        private LuaFunction o_get_property;
+        private LuaFunction o_set_property;
+        private LuaFunction r_get_property;
+        private LuaFunction r_set_property;
+
+        [ClassInitialize]
+        public void Initialize()
+        {
+            lua = new LuaBridge();
+
+            lua["o"] = new MembersClass();
+            lua["r"] = new ReflectedMembersClass();
+            lua["p1"] = 1;
+
+            o_get_field = lua.Load("local x for i = 0, 10 do x = o.field end");
+            o_set_field = lua.Load("for i = 0, 10 do o.field = p1 end");
+            o_get_property = lua.Load("local x for i = 0, 10 do x = o.Property end");
+            o_set_property = lua.Load("for i = 0, 10 do o.Property = p1 end");
+
+            // accessed through reflection because the type is not visible
+            r_get_property = lua.Load("local x for i = 0, 10 do x = r.Property end");
+            r_set_property = lua.Load("for i = 0, 10 do r.Property = p1 end");
+        }
+
+        [ClassCleanup]
+        public void Cleanup()
+        {
+            lua.Dispose();
+        }
+
+        public class MembersClass
+        {
+            public int field;
+
+            public int Property { get; set; }
+        }
+
+        class ReflectedMembersClass
+        {
+            public int Property { get; set; }
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 10)]
+        public void GetField()
+        {
+            o_get_field.Call();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 10)]
+        public void SetField()
+        {
+            o_set_field.Call();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 10)]
+        public void GetProperty()
+        {
+            o_get_property.Call();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 10)]
+        public void SetProperty()
+        {
+            o_set_property.Call();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 10)]
+        public void GetReflectedProperty()
+        {
+            r_get_property.Call();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = 10)]
+        public void SetReflectedProperty()
+        {
+            r_set_property.Call();
+        }
+    }
+}
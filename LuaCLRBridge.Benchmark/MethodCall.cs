@@ -39,7 +39,7 @@ namespace LuaCLRBridge.Benchmark
             lua.Dispose();
         }
 
-        class MethodsClass
+        public class MethodsClass
         {
             public void f1( int i ) { }
 
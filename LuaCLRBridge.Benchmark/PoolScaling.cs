@@ -0,0 +1,89 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Benchmark
+{
+    using System;
+    using System.Collections.Concurrent;
+    using System.Diagnostics;
+    using System.Threading.Tasks;
+
+    [BenchmarkClass]
+    public class PoolScaling
+    {
+        private const int evaluations = 1024;
+
+        private IntPtr processorAffinity;
+
+        private LuaBridgePool pool;
+
+        private ConcurrentDictionary<LuaBridge, LuaFunction> work = new ConcurrentDictionary<LuaBridge, LuaFunction>();
+
+        [ClassInitialize]
+        public void Initialize()
+        {
+            // scaling cannot be measured on the single processor that the other benchmarks are run on
+            var process = Process.GetCurrentProcess();
+            processorAffinity = process.ProcessorAffinity;
+            process.ProcessorAffinity = new IntPtr((1L << Math.Min(Environment.ProcessorCount, 63)) - 1);
+
+            pool = new LuaBridgePool(16, bridge =>
+                {
+                    work[bridge] = bridge.Do("return function() local s = 0 for i = 1, 1000 do s = s + i end return s end")[0] as LuaFunction;
+                });
+        }
+
+        [ClassCleanup]
+        public void Cleanup()
+        {
+            pool.Dispose();
+
+            Process.GetCurrentProcess().ProcessorAffinity = processorAffinity;
+        }
+
+        private void Evaluate( int threads )
+        {
+            Parallel.For(0, evaluations, new ParallelOptions { MaxDegreeOfParallelism = threads }, i =>
+                {
+                    using (var lease = pool.Acquire())
+                        work[lease.Bridge].Call();
+                });
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = evaluations)]
+        public void Threads1()
+        {
+            Evaluate(1);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = evaluations)]
+        public void Threads2()
+        {
+            Evaluate(2);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = evaluations)]
+        public void Threads4()
+        {
+            Evaluate(4);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = evaluations)]
+        public void Threads8()
+        {
+            Evaluate(8);
+        }
+
+        [BenchmarkMethod(secondsToRun: 3, IterationsPerCall = evaluations)]
+        public void Threads16()
+        {
+            Evaluate(16);
+        }
+    }
+}
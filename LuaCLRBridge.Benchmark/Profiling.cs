@@ -0,0 +1,58 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Benchmark
+{
+    using System;
+
+    [BenchmarkClass]
+    public class Profiling
+    {
+        private InstrumentedLuaBridge unprofiled;
+        private InstrumentedLuaBridge profiled;
+
+        private LuaFunction unprofiledWork;
+        private LuaFunction profiledWork;
+
+        private const string work = "return function() local t = {} for i = 1, 10000 do t[i % 64 + 1] = i * 0.5 end end";
+
+        [ClassInitialize]
+        public void Initialize()
+        {
+            unprofiled = new InstrumentedLuaBridge(Instrumentations.Profiling);
+            unprofiledWork = unprofiled.Do(work)[0] as LuaFunction;
+
+            profiled = new InstrumentedLuaBridge(Instrumentations.Profiling);
+            profiledWork = profiled.Do(work)[0] as LuaFunction;
+
+            profiled.StartProfiling(TimeSpan.FromMilliseconds(1));
+        }
+
+        [ClassCleanup]
+        public void Cleanup()
+        {
+            profiled.StopProfiling();
+
+            unprofiled.Dispose();
+            profiled.Dispose();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void Unprofiled()
+        {
+            unprofiledWork.Call();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void Profiled1kHz()
+        {
+            profiledWork.Call();
+        }
+    }
+}
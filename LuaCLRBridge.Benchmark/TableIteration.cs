@@ -0,0 +1,66 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Benchmark
+{
+    using System;
+
+    [BenchmarkClass]
+    public class TableIteration
+    {
+        private LuaBridge lua;
+
+        private LuaTable table;
+
+        private double sum;
+
+        [ClassInitialize]
+        public void Initialize()
+        {
+            lua = new LuaBridge();
+
+            // a small table, of the sort iterated many times over
+            table = lua.Do("return { 1, 2, 3, 4, 5, 6, 7, 8, x = 1, y = 2 }")[0] as LuaTable;
+        }
+
+        [ClassCleanup]
+        public void Cleanup()
+        {
+            table.Dispose();
+            lua.Dispose();
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void Enumerator()
+        {
+            foreach (var entry in table)
+                if (entry.Value is double)
+                    sum += (double)entry.Value;
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void RawPairs()
+        {
+            foreach (var entry in table.RawPairs())
+                if (entry.Value is double)
+                    sum += (double)entry.Value;
+        }
+
+        [BenchmarkMethod(secondsToRun: 3)]
+        public void ForEach()
+        {
+            table.ForEach<double>(Add);
+        }
+
+        private void Add( double value )
+        {
+            sum += value;
+        }
+    }
+}
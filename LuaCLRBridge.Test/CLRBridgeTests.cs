@@ -379,6 +379,65 @@ namespace LuaCLRBridge.Test
             }
         }
 
+        [TestMethod]
+        public void TestPrimitiveArrayToTable()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var arrays = new object[]
+                {
+                    new double[] { 1.5, -2.5, Double.PositiveInfinity },
+                    new float[] { 0.25f, 1, 2 },
+                    new int[] { Int32.MinValue, 0, Int32.MaxValue },
+                    new byte[] { 255, 0, 1 },
+                    new bool[] { true, false, true },
+                    new string[] { "a", null, "\u00e9" },
+                    new uint[] { UInt32.MaxValue, 0, 1 },
+                    new List<double> { 3, 2, 1 },
+                };
+
+                var expected = new object[][]
+                {
+                    new object[] { 1.5, -2.5, Double.PositiveInfinity, null },
+                    new object[] { 0.25, 1.0, 2.0, null },
+                    new object[] { (double)Int32.MinValue, 0.0, (double)Int32.MaxValue, null },
+                    new object[] { 255.0, 0.0, 1.0, null },
+                    new object[] { true, false, true, null },
+                    new object[] { "a", null, "\u00e9", null },
+                    new object[] { (double)UInt32.MaxValue, 0.0, 1.0, null },
+                    new object[] { 3.0, 2.0, 1.0, null },
+                };
+
+                for (int i = 0; i < arrays.Length; ++i)
+                {
+                    lua["x"] = arrays[i];
+
+                    var r = lua.Do("local t = CLR.ToTable(x) return t[1], t[2], t[3], t[4]");
+
+                    AssertElementsAreEqual(expected[i], r);
+                }
+
+                lua["d"] = arrays[0];
+                lua["i"] = arrays[2];
+
+                var r3 = lua.Do("local t = CLR.ToTable(d, 3) return t[1], t[2], t[3], t[4], t[5]");
+
+                AssertElementsAreEqual(new object[] { null, null, 1.5, -2.5, Double.PositiveInfinity }, r3);
+
+                var r0 = lua.Do("local t = CLR.ToTable(i, 0) return t[0], t[1], t[2], t[3]");
+
+                AssertElementsAreEqual(new object[] { (double)Int32.MinValue, 0.0, (double)Int32.MaxValue, null }, r0);
+            }
+        }
+
+        private static void AssertElementsAreEqual( object[] expected, object[] actual )
+        {
+            Assert.AreEqual(expected.Length, actual.Length);
+
+            for (int i = 0; i < expected.Length; ++i)
+                Assert.AreEqual(expected[i], actual[i], String.Format("Element {0}", i));
+        }
+
         [TestMethod]
         public void TestSetToTable()
         {
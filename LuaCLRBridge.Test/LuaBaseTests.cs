@@ -78,5 +78,46 @@ namespace LuaCLRBridge.Test
                 Assert.IsTrue(tString.StartsWith("table: "));
             }
         }
+
+        [TestMethod]
+        public void LuaBaseSharesReference()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                int references = lua.LuaReferenceCount;
+                int objects = lua.ReferencedLuaObjectCount;
+
+                lua.Do("t = {}");
+
+                var t1 = lua["t"] as LuaTable;
+                var t2 = lua["t"] as LuaTable;
+
+                Assert.AreEqual(references + 2, lua.LuaReferenceCount);
+                Assert.AreEqual(objects + 1, lua.ReferencedLuaObjectCount);
+
+                // the reference outlives the first LuaBase of the Lua object
+                t1.Dispose();
+                t2["x"] = 1;
+                Assert.AreEqual(1.0, lua.Do("return t.x")[0]);
+
+                t2.Dispose();
+                Assert.AreEqual(references, lua.LuaReferenceCount);
+                Assert.AreEqual(objects, lua.ReferencedLuaObjectCount);
+
+                var r = lua.Do("local u = {} return u, u, {}, function() end");
+
+                Assert.AreEqual(references + 4, lua.LuaReferenceCount);
+                Assert.AreEqual(objects + 3, lua.ReferencedLuaObjectCount);
+                Assert.IsTrue(lua.LuaReferenceCapacity >= lua.ReferencedLuaObjectCount);
+                Assert.AreEqual(r[0], r[1]);
+                Assert.AreNotEqual(r[0], r[2]);
+
+                foreach (LuaBase value in r)
+                    value.Dispose();
+
+                Assert.AreEqual(references, lua.LuaReferenceCount);
+                Assert.AreEqual(objects, lua.ReferencedLuaObjectCount);
+            }
+        }
     }
 }
@@ -0,0 +1,169 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Test
+{
+    using System;
+    using System.Threading;
+    using System.Threading.Tasks;
+    using LuaCLRBridge;
+    using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+    [TestClass]
+    public class LuaBridgePoolTests
+    {
+        [TestMethod]
+        public void InitializeIdentically()
+        {
+            using (var pool = new LuaBridgePool(3, bridge => bridge.Do("function f(x) return x * 2 end")))
+            {
+                Assert.AreEqual(3, pool.Size);
+
+                var leases = new LuaBridgeLease[3];
+
+                for (int i = 0; i < leases.Length; ++i)
+                    leases[i] = pool.Acquire();
+
+                for (int i = 0; i < leases.Length; ++i)
+                {
+                    for (int j = 0; j < i; ++j)
+                        Assert.AreNotEqual(leases[i].Bridge, leases[j].Bridge);
+
+                    var r = leases[i].Bridge.Do("return f(" + i + ")");
+
+                    Assert.AreEqual(1, r.Length);
+                    Assert.AreEqual((double)(i * 2), r[0]);
+                }
+
+                foreach (var lease in leases)
+                    lease.Dispose();
+            }
+        }
+
+        [TestMethod]
+        public void TryAcquireWhenAllLeased()
+        {
+            using (var pool = new LuaBridgePool(1, null))
+            {
+                LuaBridgeLease lease;
+
+                Assert.IsTrue(pool.TryAcquire(out lease));
+
+                using (lease)
+                {
+                    LuaBridgeLease other;
+
+                    Assert.IsFalse(pool.TryAcquire(out other));
+                    Assert.IsNull(other);
+                }
+
+                Assert.IsTrue(pool.TryAcquire(out lease));
+
+                lease.Dispose();
+                lease.Dispose();  // no effect
+
+                try
+                {
+                    var bridge = lease.Bridge;
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(ObjectDisposedException));
+                }
+            }
+        }
+
+        [TestMethod]
+        public void AcquireConcurrently()
+        {
+            using (var pool = new LuaBridgePool(4, bridge => bridge.Do("n = 0")))
+            {
+                Parallel.For(0, 400, i =>
+                    {
+                        using (var lease = pool.Acquire())
+                            lease.Bridge.Do("n = n + 1");
+                    });
+
+                double total = 0;
+
+                for (int i = 0; i < pool.Size; ++i)
+                {
+                    LuaBridgeLease lease;
+
+                    Assert.IsTrue(pool.TryAcquire(out lease));
+
+                    total += (double)lease.Bridge["n"];
+                }
+
+                Assert.AreEqual(400.0, total);
+            }
+        }
+
+        [TestMethod]
+        public void AcquireAgainPrefersLastLeased()
+        {
+            using (var pool = new LuaBridgePool(4, null))
+            {
+                LuaBridge first;
+
+                using (var lease = pool.Acquire())
+                    first = lease.Bridge;
+
+                for (int i = 0; i < 10; ++i)
+                    using (var lease = pool.Acquire())
+                        Assert.AreSame(first, lease.Bridge);
+            }
+        }
+
+        [TestMethod]
+        public void DisposeWhileAcquiring()
+        {
+            var pool = new LuaBridgePool(1, null);
+
+            var lease = pool.Acquire();
+
+            Exception exception = null;
+            var thread = new Thread(() =>
+                {
+                    try
+                    {
+                        pool.Acquire();
+                    }
+                    catch (Exception ex)
+                    {
+                        exception = ex;
+                    }
+                });
+
+            thread.Start();
+
+            // let the thread wait for the leased Lua state
+            while (thread.ThreadState != ThreadState.WaitSleepJoin)
+                Thread.Sleep(1);
+
+            pool.Dispose();
+
+            Assert.IsTrue(thread.Join(TimeSpan.FromSeconds(10)));
+            Assert.IsInstanceOfType(exception, typeof(ObjectDisposedException));
+
+            lease.Dispose();  // no effect
+
+            try
+            {
+                pool.Acquire();
+                Assert.Fail();
+            }
+            catch (Exception ex)
+            {
+                Assert.IsInstanceOfType(ex, typeof(ObjectDisposedException));
+            }
+        }
+    }
+}
@@ -0,0 +1,112 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Test
+{
+    using System;
+    using LuaCLRBridge;
+    using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+    [TestClass]
+    public class LuaBridgeTemplateTests
+    {
+        [TestMethod]
+        public void ReplayStepsInOrder()
+        {
+            var template = new LuaBridgeTemplate();
+
+            template.AddLib("_G");
+            template.AddLib("string");
+            template.AddGlobal("scale", 3);
+            template.AddChunk("function f(x) return x * scale end", "bootstrap");
+            template.AddChunk("g = string.rep('a', f(2))");
+
+            using (var bridge1 = template.CreateBridge())
+            using (var bridge2 = template.CreateBridge())
+            {
+                bridge1.Do("scale = 10");
+
+                Assert.AreEqual(40.0, bridge1.Do("return f(4)")[0]);
+                Assert.AreEqual(12.0, bridge2.Do("return f(4)")[0]);
+                Assert.AreEqual("aaaaaa", bridge2["g"]);
+                Assert.AreEqual("function", bridge2.Do("return type(tostring)")[0]);
+                Assert.IsNotNull(bridge2["CLR"]);
+            }
+        }
+
+        [TestMethod]
+        public void AddChunkCompilerError()
+        {
+            var template = new LuaBridgeTemplate();
+
+            try
+            {
+                template.AddChunk("function f(", "broken");
+                Assert.Fail();
+            }
+            catch (Exception ex)
+            {
+                Assert.IsInstanceOfType(ex, typeof(LuaCompilerException));
+            }
+        }
+
+        [TestMethod]
+        public void CreateBridgeRuntimeError()
+        {
+            var template = new LuaBridgeTemplate();
+
+            template.AddChunk("error('bootstrap failed')");
+
+            try
+            {
+                template.CreateBridge();
+                Assert.Fail();
+            }
+            catch (Exception ex)
+            {
+                Assert.IsInstanceOfType(ex, typeof(LuaRuntimeException));
+            }
+        }
+
+        [TestMethod]
+        public void AddGlobalLuaValue()
+        {
+            var template = new LuaBridgeTemplate();
+
+            using (var bridge = new LuaBridge())
+            using (var table = bridge.NewTable())
+            {
+                try
+                {
+                    template.AddGlobal("t", table);
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(ArgumentException));
+                }
+            }
+        }
+
+        [TestMethod]
+        public void CreatePoolFromTemplate()
+        {
+            var template = new LuaBridgeTemplate(clrBridge: String.Empty);
+
+            template.AddChunk("function f(x) return x + 1 end");
+
+            using (var pool = new LuaBridgePool(2, template.CreateBridge, null))
+            using (var lease = pool.Acquire())
+            {
+                Assert.AreEqual(2.0, lease.Bridge.Do("return f(1)")[0]);
+                Assert.IsNull(lease.Bridge["CLR"]);
+            }
+        }
+    }
+}
@@ -11,6 +11,7 @@ namespace LuaCLRBridge.Test
 {
     using System;
     using System.IO;
+    using System.Runtime.CompilerServices;
     using System.Text;
     using System.Threading;
     using System.Threading.Tasks;
@@ -56,6 +57,48 @@ namespace LuaCLRBridge.Test
             }
         }
 
+        [TestMethod]
+        public void LoadFile()
+        {
+            string path = Path.GetTempFileName();
+
+            try
+            {
+                File.WriteAllText(path, "return 'test'");
+
+                // not sandboxed, since the sandbox does not permit access to files
+                using (var lua = new LuaBridge())
+                {
+                    lua.LoadLib("_G");
+
+                    var r = lua.LoadFile(path).Call();
+
+                    Assert.AreEqual(1, r.Length);
+                    Assert.AreEqual("test", r[0] as string);
+
+                    File.WriteAllText(path, String.Empty);
+
+                    Assert.AreEqual(0, lua.LoadFile(path).Call().Length);
+
+                    File.WriteAllText(path, "error('failed')");
+
+                    try
+                    {
+                        lua.LoadFile(path, "=script").Call();
+                        Assert.Fail();
+                    }
+                    catch (LuaRuntimeException ex)
+                    {
+                        Assert.IsTrue(ex.Message.Contains("script:1: failed"), ex.Message);
+                    }
+                }
+            }
+            finally
+            {
+                File.Delete(path);
+            }
+        }
+
         [TestMethod]
         public void DumpFunction()
         {
@@ -97,6 +140,289 @@ namespace LuaCLRBridge.Test
             }
         }
 
+        [TestMethod]
+        public void GarbageCollectorControls()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                Assert.AreEqual(GarbageCollectorMode.Incremental, lua.GarbageCollectorMode);
+                Assert.IsTrue(lua.IsGarbageCollectorRunning);
+
+                lua.GarbageCollectorPause = 150;
+                lua.GarbageCollectorStepMultiplier = 400;
+                lua.GarbageCollectorMajorIncrement = 50;
+
+                Assert.AreEqual(150, lua.GarbageCollectorPause);
+                Assert.AreEqual(400, lua.GarbageCollectorStepMultiplier);
+                Assert.AreEqual(50, lua.GarbageCollectorMajorIncrement);
+
+                lua.StopGarbageCollector();
+                Assert.IsFalse(lua.IsGarbageCollectorRunning);
+
+                lua.RestartGarbageCollector();
+                Assert.IsTrue(lua.IsGarbageCollectorRunning);
+
+                lua.Do("local t = {} for i = 1, 10000 do t[i] = {} end");
+
+                bool finished = false;
+                for (int i = 0; i < 1000000 && !finished; ++i)
+                    finished = lua.StepGarbage(0);
+                Assert.IsTrue(finished);
+
+                Assert.IsFalse(lua.StepGarbageUntil(DateTime.UtcNow.AddSeconds(-1)));
+                Assert.IsTrue(lua.StepGarbageUntil(DateTime.UtcNow.AddMinutes(1)));
+
+                lua.GarbageCollectorMode = GarbageCollectorMode.Generational;
+                Assert.AreEqual(GarbageCollectorMode.Generational, lua.GarbageCollectorMode);
+                Assert.IsTrue(lua.StepGarbage(0));
+
+                lua.GarbageCollectorMode = GarbageCollectorMode.Incremental;
+                Assert.AreEqual(GarbageCollectorMode.Incremental, lua.GarbageCollectorMode);
+
+                try
+                {
+                    lua.StepGarbage(-1);
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(ArgumentOutOfRangeException));
+                }
+            }
+        }
+
+        public class CrossHeapHolder
+        {
+            public LuaFunction Callback { get; set; }
+        }
+
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        private static WeakReference CreateCrossHeapCycle( LuaBridge lua )
+        {
+            var holder = new CrossHeapHolder();
+
+            lua["holder"] = holder;
+            holder.Callback = lua.Do("local h = holder holder = nil return function() return h end")[0] as LuaFunction;
+
+            return new WeakReference(holder);
+        }
+
+        [TestMethod]
+        public void CollectCrossHeapCycles()
+        {
+            // not sandboxed, since the CLI objects must be in the application domain of the Lua state
+            using (var lua = new LuaBridge())
+            {
+                int objects = lua.CLIObjectCount;
+                int references = lua.LuaReferenceCount;
+
+                WeakReference cycle = CreateCrossHeapCycle(lua);
+
+                lua["kept"] = new CrossHeapHolder();
+                var table = lua.Do("local t = { kept } kept = nil return t")[0] as LuaTable;
+
+                GC.Collect();
+                GC.WaitForPendingFinalizers();
+                lua.CollectGarbage();
+
+                Assert.IsTrue(cycle.IsAlive);
+
+                Assert.IsTrue(lua.CollectCrossHeapCycles() >= 1);
+
+                Assert.IsFalse(cycle.IsAlive);
+                Assert.IsInstanceOfType(table[1], typeof(CrossHeapHolder));
+
+                // the Lua side of the cycle is collected once the LuaFunction has been finalized
+                GC.WaitForPendingFinalizers();
+                lua.DrainDeferredUnrefs(int.MaxValue);
+                lua.CollectGarbage();
+
+                // only the table and the CLI object that it holds are left
+                Assert.AreEqual(references + 1, lua.LuaReferenceCount);
+                Assert.AreEqual(objects + 1, lua.CLIObjectCount);
+                Assert.IsInstanceOfType(table[1], typeof(CrossHeapHolder));
+            }
+        }
+
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        private static WeakReference CreateWeakTableCycle( LuaBridge lua, string mode )
+        {
+            var holder = new CrossHeapHolder();
+
+            lua["holder"] = holder;
+            lua["mode"] = mode;
+            holder.Callback = lua.Do(@"
+                local h = holder
+                holder = nil
+                local weak = setmetatable({}, { __mode = mode })
+                weak[h] = h
+                weaks = weaks or {}
+                weaks[#weaks + 1] = weak
+                return function() return h end")[0] as LuaFunction;
+
+            return new WeakReference(holder);
+        }
+
+        [TestMethod]
+        public void CollectCrossHeapCyclesWeakTables()
+        {
+            // not sandboxed, since the CLI objects must be in the application domain of the Lua state
+            using (var lua = new LuaBridge())
+            {
+                var cycles = new[]
+                {
+                    CreateWeakTableCycle(lua, "k"),
+                    CreateWeakTableCycle(lua, "v"),
+                    CreateWeakTableCycle(lua, "kv"),
+                };
+
+                lua.CollectCrossHeapCycles();
+
+                // Lua may still read the CLI objects from the weak tables, so they are kept
+                foreach (WeakReference cycle in cycles)
+                    Assert.IsTrue(cycle.IsAlive);
+
+                for (int i = 0; i < cycles.Length; ++i)
+                {
+                    object[] r = lua.Do(string.Format("local k, v = next(weaks[{0}]) return k, v", i + 1));
+
+                    Assert.AreSame(cycles[i].Target, r[0]);
+                    Assert.AreSame(cycles[i].Target, r[1]);
+                }
+            }
+        }
+
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        private static WeakReference CreateCalledCrossHeapCycle( LuaBridge lua )
+        {
+            var holder = new CrossHeapHolder();
+
+            lua["holder"] = holder;
+            holder.Callback = lua.Do("local h = holder holder = nil h:GetHashCode() return function() return h end")[0] as LuaFunction;
+
+            return new WeakReference(holder);
+        }
+
+        [TestMethod]
+        public void CollectCrossHeapCyclesThroughCaches()
+        {
+            // not sandboxed, since the CLI objects and delegates must be in the application domain of the Lua state
+            using (var lua = new LuaBridge())
+            {
+                // the userdata and the members of the CLI object are cached by the bridge, which must not keep it
+                WeakReference cycle = CreateCalledCrossHeapCycle(lua);
+
+                lua["kept"] = new CrossHeapHolder();
+                lua.Do("kept:GetHashCode()");
+
+                var function = lua.Do("f = function() end return f")[0] as LuaFunction;
+                Action action = function.ToDelegate<Action>();
+
+                Assert.IsTrue(lua.CollectCrossHeapCycles() >= 1);
+
+                Assert.IsFalse(cycle.IsAlive);
+
+                // but what the caches hold for live keys is kept
+                Assert.IsInstanceOfType(lua.Do("return kept:GetHashCode()")[0], typeof(double));
+                Assert.AreSame(action, function.ToDelegate<Action>());
+            }
+        }
+
+        [TestMethod]
+        public void CollectCrossHeapCyclesAutomatically()
+        {
+            // not sandboxed, since the CLI objects must be in the application domain of the Lua state
+            using (var lua = new LuaBridge())
+            {
+                lua.CrossHeapCollectionThreshold = 100;
+                Assert.AreEqual(100, lua.CrossHeapCollectionThreshold);
+
+                var cycles = new WeakReference[200];
+                for (int i = 0; i < cycles.Length; ++i)
+                    cycles[i] = CreateCrossHeapCycle(lua);
+
+                int alive = 0;
+                foreach (WeakReference cycle in cycles)
+                    if (cycle.IsAlive)
+                        ++alive;
+
+                Assert.IsTrue(alive < cycles.Length);
+
+                try
+                {
+                    lua.CrossHeapCollectionThreshold = -1;
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(ArgumentOutOfRangeException));
+                }
+            }
+        }
+
+        private static LuaTable[] NewTables( LuaBridge lua, int count )
+        {
+            var tables = new LuaTable[count];
+            for (int i = 0; i < count; ++i)
+                tables[i] = lua.NewTable();
+            return tables;
+        }
+
+        private static void ReleaseOnOtherThread( LuaTable[] tables )
+        {
+            // the Lua state is locked by this thread, so the other thread defers unreferencing
+            var thread = new Thread(() =>
+            {
+                foreach (LuaTable table in tables)
+                    table.Dispose();
+            });
+
+            thread.Start();
+            thread.Join();
+        }
+
+        [TestMethod]
+        public void DrainDeferredUnrefs()
+        {
+            // not sandboxed, since the delegate must be in the application domain of the Lua state
+            using (var lua = new LuaBridge())
+            {
+                lua.DeferredUnrefBudget = 1;
+                Assert.AreEqual(1, lua.DeferredUnrefBudget);
+
+                LuaTable[] tables = NewTables(lua, 1000);
+
+                lua["release"] = new Action(() => ReleaseOnOtherThread(tables));
+                lua.Do("release()");
+
+                Assert.AreEqual(1000L, lua.TotalDeferredUnrefCount);
+                Assert.AreEqual(1000, lua.PeakDeferredUnrefCount);
+
+                // each unlock unreferences no more than the budget
+                int pending = lua.DeferredUnrefCount;
+                Assert.IsTrue(pending > 900 && pending < 1000);
+
+                // the unlock after the drain unreferences one more
+                Assert.AreEqual(500, lua.DrainDeferredUnrefs(500));
+                lua.DeferredUnrefBudget = 0;
+                Assert.AreEqual(pending - 501, lua.DeferredUnrefCount);
+
+                Assert.AreEqual(pending - 501, lua.DrainDeferredUnrefs(int.MaxValue));
+                Assert.AreEqual(0, lua.DeferredUnrefCount);
+                Assert.AreEqual(1000, lua.PeakDeferredUnrefCount);
+
+                try
+                {
+                    lua.DrainDeferredUnrefs(-1);
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(ArgumentOutOfRangeException));
+                }
+            }
+        }
+
         [TestMethod]
         public void GetSetEnvironment()
         {
@@ -179,6 +505,27 @@ namespace LuaCLRBridge.Test
             }
         }
 
+        [TestMethod]
+        public void NestedExceptionStackTrace()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                try
+                {
+                    lua.Do("function inner() error('x') end\nlocal g = CLR.NewDelegate(CLR.Type['System.Action'], inner) g()");
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    string stackTrace = ex.StackTrace;
+
+                    Assert.IsTrue(stackTrace.Contains("in function 'inner'"));
+                    Assert.IsTrue(stackTrace.Contains("in main chunk"));
+                    Assert.AreEqual(stackTrace.IndexOf("in main chunk", StringComparison.Ordinal), stackTrace.LastIndexOf("in main chunk", StringComparison.Ordinal));
+                }
+            }
+        }
+
         [TestMethod]
         public void StackOverflow1()
         {
@@ -250,6 +597,244 @@ namespace LuaCLRBridge.Test
             Assert.IsTrue(lua.MemoryAllocatedSize == UIntPtr.Zero);
         }
 
+        [TestMethod]
+        public void InstrumentedBridgePoolMemory()
+        {
+            InstrumentedLuaBridge lua;
+
+            using (lua = CreateInstrumentedLuaBridge(Instrumentations.MemoryPooling))
+            {
+                var preTableAllocated = lua.MemoryAllocatedSize;
+                Assert.IsTrue((ulong)preTableAllocated > 0);
+
+                lua.Do("t = {} for i = 1, 1000 do t[i] = tostring(i) end");
+
+                var postTableAllocated = lua.MemoryAllocatedSize;
+                Assert.IsTrue((ulong)preTableAllocated < (ulong)postTableAllocated);
+
+                var sizeClasses = lua.GetMemorySizeClasses();
+                long blocksInUse = 0;
+
+                for (int i = 0; i < sizeClasses.Length; ++i)
+                {
+                    if (i > 0)
+                        Assert.IsTrue(sizeClasses[i - 1].BlockSize < sizeClasses[i].BlockSize);
+
+                    blocksInUse += sizeClasses[i].BlocksInUse;
+                }
+
+                Assert.IsTrue(blocksInUse >= 1000);
+            }
+
+            Assert.IsTrue(lua.MemoryAllocatedSize == UIntPtr.Zero);
+        }
+
+        [TestMethod]
+        public void InstrumentedBridgeMemoryLimit()
+        {
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.MemoryPooling))
+            {
+                lua.MemoryLimit = new UIntPtr((ulong)lua.MemoryAllocatedSize + 64 * 1024);
+
+                try
+                {
+                    lua.Do("t = {} for i = 1, 100000 do t[i] = i end");
+
+                    Assert.Fail();
+                }
+                catch (LuaRuntimeException ex)
+                {
+                    Assert.IsTrue(ex.Message.Contains("not enough memory"), ex.Message);
+                }
+
+                lua.MemoryLimit = UIntPtr.Zero;
+
+                lua.Do("t = {} for i = 1, 100000 do t[i] = i end");
+            }
+
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.MemoryMonitoring))
+            {
+                try
+                {
+                    lua.GetMemorySizeClasses();
+
+                    Assert.Fail();
+                }
+                catch (InvalidOperationException)
+                {
+                }
+            }
+        }
+
+        [TestMethod]
+        public void InstrumentedBridgeMemorySoftLimit()
+        {
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.MemoryMonitoring | Instrumentations.Interruption))
+            {
+                lua.LoadLib("_G");
+                lua.Do("collectgarbage('stop')");
+
+                ulong softLimit = (ulong)lua.MemoryAllocatedSize + 256 * 1024;
+                lua.MemorySoftLimit = new UIntPtr(softLimit);
+
+                lua.Do("for i = 1, 200000 do local t = { i } end");
+
+                Assert.IsTrue((ulong)lua.MemoryAllocatedSize < softLimit + 256 * 1024);
+            }
+
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.MemoryMonitoring))
+            {
+                try
+                {
+                    lua.MemorySoftLimit = new UIntPtr(1024 * 1024);
+
+                    Assert.Fail();
+                }
+                catch (InvalidOperationException)
+                {
+                }
+            }
+        }
+
+        [TestMethod]
+        public void InstrumentedBridgeProfile()
+        {
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.Profiling))
+            {
+                lua.LoadLib("_G");
+                lua.LoadLib("os");
+
+                lua.Do("function spin( timespan ) local start = os.clock() while os.clock() - start < timespan do end end", "=profiled");
+
+                lua.StartProfiling(TimeSpan.FromMilliseconds(1));
+                lua.Do("spin(0.5)");
+                lua.StopProfiling();
+
+                string folded = lua.GetFoldedStacks();
+                long total = 0;
+
+                foreach (string line in folded.Split(new[] { '\n' }, StringSplitOptions.RemoveEmptyEntries))
+                {
+                    int space = line.LastIndexOf(' ');
+                    total += long.Parse(line.Substring(space + 1));
+                }
+
+                Assert.IsTrue(total > 0);
+                Assert.IsTrue(folded.Contains("spin profiled:1"), folded);
+
+                lua.ClearProfile();
+
+                Assert.AreEqual(String.Empty, lua.GetFoldedStacks());
+
+                // profiling alone does not enable cancellation
+                try
+                {
+                    lua.Cancel("cancelled");
+
+                    Assert.Fail();
+                }
+                catch (InvalidOperationException)
+                {
+                }
+            }
+
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.None))
+            {
+                try
+                {
+                    lua.StartProfiling(TimeSpan.FromMilliseconds(1));
+
+                    Assert.Fail();
+                }
+                catch (InvalidOperationException)
+                {
+                }
+            }
+        }
+
+        [TestMethod]
+        public void InstrumentedBridgeBoundaryTiming()
+        {
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.BoundaryTiming))
+            {
+                lua["sb"] = new StringBuilder();
+                lua["span"] = TimeSpan.FromSeconds(1);
+
+                lua.Do("for i = 1, 10 do sb:Append('x') end sb.Length = sb.Length - 5 span = span + span");
+
+                var function = lua.Do("return function( x ) return x + 1 end", "=timed")[0] as LuaFunction;
+
+                Assert.AreEqual(2.0, function.Call(1.0)[0]);
+                Assert.AreEqual(3.0, function.ToDelegate<Func<double, double>>()(2.0));
+
+                object[] batchResults = function.CallBatch(1, new[] { new object[] { 3.0 }, new object[] { 4.0 } });
+
+                Assert.AreEqual(4.0, batchResults[0]);
+                Assert.AreEqual(5.0, batchResults[1]);
+
+                BoundaryTimingStatistics[] timings = lua.GetBoundaryTimings();
+
+                Assert.AreEqual(10, FindBoundaryTiming(timings, BoundaryKind.Method, "System.Text.StringBuilder.Append").Count);
+                Assert.AreEqual(1, FindBoundaryTiming(timings, BoundaryKind.Get, "System.Text.StringBuilder.Length").Count);
+                Assert.AreEqual(1, FindBoundaryTiming(timings, BoundaryKind.Set, "System.Text.StringBuilder.Length").Count);
+                Assert.AreEqual(1, FindBoundaryTiming(timings, BoundaryKind.Operator, "System.TimeSpan.op_Addition").Count);
+
+                BoundaryTimingStatistics luaFunction = FindBoundaryTiming(timings, BoundaryKind.LuaFunction, "timed:1");
+
+                Assert.AreEqual(4, luaFunction.Count);
+                Assert.IsTrue(luaFunction.MaxTime <= luaFunction.TotalTime);
+
+                lua.ResetBoundaryTimings();
+
+                Assert.AreEqual(0, lua.GetBoundaryTimings().Length);
+            }
+
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.None))
+            {
+                try
+                {
+                    lua.GetBoundaryTimings();
+
+                    Assert.Fail();
+                }
+                catch (InvalidOperationException)
+                {
+                }
+            }
+        }
+
+        [TestMethod]
+        public void InstrumentedBridgeBoundaryTimingOfExitedThreads()
+        {
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.BoundaryTiming))
+            {
+                var function = lua.Do("return function( x ) return x + 1 end", "=timed")[0] as LuaFunction;
+
+                for (int i = 0; i < 10; ++i)
+                {
+                    var thread = new Thread(() => function.Call(1.0));
+                    thread.Start();
+                    thread.Join();
+
+                    Assert.AreEqual(i + 1, FindBoundaryTiming(lua.GetBoundaryTimings(), BoundaryKind.LuaFunction, "timed:1").Count);
+                }
+
+                lua.ResetBoundaryTimings();
+
+                Assert.AreEqual(0, lua.GetBoundaryTimings().Length);
+            }
+        }
+
+        private static BoundaryTimingStatistics FindBoundaryTiming( BoundaryTimingStatistics[] timings, BoundaryKind kind, string name )
+        {
+            foreach (BoundaryTimingStatistics timing in timings)
+                if (timing.Kind == kind && timing.Name == name)
+                    return timing;
+
+            Assert.Fail(String.Format("No timing of {0} {1}", kind, name));
+            return default(BoundaryTimingStatistics);
+        }
+
         [TestMethod]
         public void InstrumentedBridgeCancel()
         {
@@ -307,5 +892,42 @@ namespace LuaCLRBridge.Test
                 Assert.AreEqual("pass!", r[0] as string);
             }
         }
+
+        [TestMethod]
+        public void InstrumentedBridgeInterjectDeferredUnrefs()
+        {
+            // not sandboxed, since the delegates must be in the application domain of the Lua state
+            using (var lua = new InstrumentedLuaBridge(Instrumentations.Interruption))
+            {
+                lua.DeferredUnrefBudget = 0;
+                lua.InterjectDeferredUnrefs = true;
+                Assert.IsTrue(lua.InterjectDeferredUnrefs);
+
+                LuaTable[] tables = NewTables(lua, 1000);
+
+                lua.LoadLib("os");
+                lua["release"] = new Action(() => ReleaseOnOtherThread(tables));
+                lua["pending"] = new Func<int>(() => lua.DeferredUnrefCount);
+
+                // interjections unreference the tables in batches while the Lua code keeps the Lua state locked
+                lua.Do("release() local start = os.clock() while pending() >= 256 and os.clock() - start < 5 do end");
+
+                Assert.AreEqual(1000L, lua.TotalDeferredUnrefCount);
+                Assert.IsTrue(lua.DeferredUnrefCount < 256);
+            }
+
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.None))
+            {
+                try
+                {
+                    lua.InterjectDeferredUnrefs = true;
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(InvalidOperationException));
+                }
+            }
+        }
     }
 }
@@ -0,0 +1,174 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Test
+{
+    using System;
+    using System.Collections.Generic;
+    using System.IO;
+    using LuaCLRBridge;
+    using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+    [TestClass]
+    public class LuaChunkBundleTests
+    {
+        private static byte[] Compile( string buff, string name )
+        {
+            using (var lua = new LuaBridge(String.Empty))
+            using (var function = lua.Load(buff, name))
+            using (var stream = new MemoryStream())
+            {
+                function.Dump(stream);
+                return stream.ToArray();
+            }
+        }
+
+        private static string WriteBundle()
+        {
+            string path = Path.GetTempFileName();
+
+            var chunks = new List<KeyValuePair<string, byte[]>>
+            {
+                new KeyValuePair<string, byte[]>("answer", Compile("return 42", "=answer")),
+                new KeyValuePair<string, byte[]>("greeting", Compile("return { greet = function( name ) return 'hello ' .. name end }", "=greeting")),
+            };
+
+            using (var stream = File.Create(path))
+                LuaChunkBundle.Write(stream, chunks);
+
+            return path;
+        }
+
+        [TestMethod]
+        public void LoadFromBundle()
+        {
+            string path = WriteBundle();
+
+            try
+            {
+                using (var bundle = LuaChunkBundle.Open(path))
+                using (var lua = new LuaBridge())
+                {
+                    Assert.AreEqual(2, bundle.Names.Count);
+                    Assert.AreEqual("answer", bundle.Names[0]);
+                    Assert.IsTrue(bundle.Contains("greeting"));
+                    Assert.IsFalse(bundle.Contains("missing"));
+
+                    using (var function = bundle.Load(lua, "answer"))
+                        Assert.AreEqual(42.0, function.Call()[0]);
+
+                    try
+                    {
+                        bundle.Load(lua, "missing");
+                        Assert.Fail();
+                    }
+                    catch (KeyNotFoundException)
+                    {
+                    }
+                }
+            }
+            finally
+            {
+                File.Delete(path);
+            }
+        }
+
+        [TestMethod]
+        public void PreloadBundle()
+        {
+            string path = WriteBundle();
+
+            try
+            {
+                using (var bundle = LuaChunkBundle.Open(path))
+                using (var lua = new LuaBridge())
+                {
+                    try
+                    {
+                        bundle.Preload(lua);
+                        Assert.Fail();
+                    }
+                    catch (InvalidOperationException)
+                    {
+                    }
+
+                    lua.LoadLib("package");
+
+                    bundle.Preload(lua);
+                    bundle.Dispose();
+
+                    Assert.AreEqual("hello world", lua.Do("return require('greeting').greet('world')")[0]);
+                    Assert.AreEqual(42.0, lua.Do("return require('answer')")[0]);
+                }
+            }
+            finally
+            {
+                File.Delete(path);
+            }
+        }
+
+        [TestMethod]
+        public void LoadCorruptChunkFromBundle()
+        {
+            string path = WriteBundle();
+
+            try
+            {
+                // the last chunk ends the file
+                byte[] contents = File.ReadAllBytes(path);
+                contents[contents.Length - 1] ^= 0xff;
+                File.WriteAllBytes(path, contents);
+
+                using (var bundle = LuaChunkBundle.Open(path))
+                using (var lua = new LuaBridge())
+                {
+                    using (var function = bundle.Load(lua, "answer"))
+                        Assert.AreEqual(42.0, function.Call()[0]);
+
+                    try
+                    {
+                        bundle.Load(lua, "greeting");
+                        Assert.Fail();
+                    }
+                    catch (InvalidDataException)
+                    {
+                    }
+                }
+            }
+            finally
+            {
+                File.Delete(path);
+            }
+        }
+
+        [TestMethod]
+        public void OpenInvalidBundle()
+        {
+            string path = Path.GetTempFileName();
+
+            try
+            {
+                File.WriteAllText(path, "return 'not a bundle'");
+
+                try
+                {
+                    LuaChunkBundle.Open(path).Dispose();
+                    Assert.Fail();
+                }
+                catch (InvalidDataException)
+                {
+                }
+            }
+            finally
+            {
+                File.Delete(path);
+            }
+        }
+    }
+}
@@ -0,0 +1,197 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge.Test
+{
+    using System;
+    using System.IO;
+    using LuaCLRBridge;
+    using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+    [TestClass]
+    public class LuaChunkCacheTests
+    {
+        [TestMethod]
+        public void LoadFromCache()
+        {
+            var cache = new LuaChunkCache();
+
+            using (var lua1 = new LuaBridge())
+            using (var lua2 = new LuaBridge())
+            {
+                lua1.ChunkCache = cache;
+                lua2.ChunkCache = cache;
+
+                Assert.AreEqual(3.0, lua1.Do("return 1 + 2", "sum")[0]);
+                Assert.AreEqual(3.0, lua2.Do("return 1 + 2", "sum")[0]);
+                Assert.AreEqual(3.0, lua2.Do("return 1 + 2", "other")[0]);
+
+                Assert.AreEqual(1, cache.Hits);
+                Assert.AreEqual(2, cache.Misses);
+                Assert.AreEqual(2, cache.Count);
+
+                try
+                {
+                    lua1.Load("return +", "broken");
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(LuaCompilerException));
+                }
+
+                Assert.AreEqual(2, cache.Count);
+            }
+        }
+
+        [TestMethod]
+        public void LoadFromPersistedCache()
+        {
+            string directory = Path.Combine(Path.GetTempPath(), Path.GetRandomFileName());
+
+            try
+            {
+                using (var lua = new LuaBridge())
+                {
+                    lua.ChunkCache = new LuaChunkCache(directory);
+
+                    Assert.AreEqual(6.0, lua.Do("return 2 * 3", "product")[0]);
+                }
+
+                Assert.AreEqual(1, Directory.GetFiles(directory, "*.luac").Length);
+
+                var cache = new LuaChunkCache(directory);
+
+                using (var lua = new LuaBridge())
+                {
+                    lua.ChunkCache = cache;
+
+                    Assert.AreEqual(6.0, lua.Do("return 2 * 3", "product")[0]);
+                }
+
+                Assert.AreEqual(1, cache.Hits);
+                Assert.AreEqual(0, cache.Misses);
+            }
+            finally
+            {
+                Directory.Delete(directory, recursive: true);
+            }
+        }
+
+        [TestMethod]
+        public void RecompileMismatchedHeader()
+        {
+            string directory = Path.Combine(Path.GetTempPath(), Path.GetRandomFileName());
+
+            try
+            {
+                using (var lua = new LuaBridge())
+                {
+                    lua.ChunkCache = new LuaChunkCache(directory);
+
+                    lua.Do("return 2 * 3", "product");
+                }
+
+                // corrupt the version in the header
+                string path = Directory.GetFiles(directory, "*.luac")[0];
+                byte[] chunk = File.ReadAllBytes(path);
+                chunk[4] = 0x51;
+                File.WriteAllBytes(path, chunk);
+
+                var cache = new LuaChunkCache(directory);
+
+                using (var lua = new LuaBridge())
+                {
+                    lua.ChunkCache = cache;
+
+                    Assert.AreEqual(6.0, lua.Do("return 2 * 3", "product")[0]);
+                }
+
+                Assert.AreEqual(0, cache.Hits);
+                Assert.AreEqual(1, cache.Misses);
+                Assert.AreNotEqual(0x51, File.ReadAllBytes(path)[4]);
+            }
+            finally
+            {
+                Directory.Delete(directory, recursive: true);
+            }
+        }
+
+        [TestMethod]
+        public void RecompileTruncatedChunk()
+        {
+            string directory = Path.Combine(Path.GetTempPath(), Path.GetRandomFileName());
+
+            try
+            {
+                using (var lua = new LuaBridge())
+                {
+                    lua.ChunkCache = new LuaChunkCache(directory);
+
+                    lua.Do("local t = { 1, 2, 3 } return t[1] + t[2] + t[3]", "sum");
+                }
+
+                // the header is intact, but the content is cut short
+                string path = Directory.GetFiles(directory, "*.luac")[0];
+                byte[] chunk = File.ReadAllBytes(path);
+                Array.Resize(ref chunk, chunk.Length / 2);
+                File.WriteAllBytes(path, chunk);
+
+                var cache = new LuaChunkCache(directory);
+
+                using (var lua = new LuaBridge())
+                {
+                    lua.ChunkCache = cache;
+
+                    Assert.AreEqual(6.0, lua.Do("local t = { 1, 2, 3 } return t[1] + t[2] + t[3]", "sum")[0]);
+                }
+
+                Assert.AreEqual(0, cache.Hits);
+                Assert.AreEqual(1, cache.Misses);
+                Assert.IsTrue(File.ReadAllBytes(path).Length > chunk.Length);
+            }
+            finally
+            {
+                Directory.Delete(directory, recursive: true);
+            }
+        }
+
+        [TestMethod]
+        public void EvictBeyondCapacity()
+        {
+            var cache = new LuaChunkCache(null, 4);
+
+            Assert.AreEqual(4, cache.Capacity);
+
+            using (var lua = new LuaBridge())
+            {
+                lua.ChunkCache = cache;
+
+                for (int i = 0; i < 10; ++i)
+                    Assert.AreEqual((double)i, lua.Do("return " + i, "chunk")[0]);
+
+                Assert.AreEqual(4, cache.Count);
+                Assert.AreEqual(10, cache.Misses);
+
+                Assert.AreEqual(9.0, lua.Do("return 9", "chunk")[0]);
+                Assert.AreEqual(1, cache.Hits);
+            }
+
+            try
+            {
+                new LuaChunkCache(null, 0);
+                Assert.Fail();
+            }
+            catch (Exception ex)
+            {
+                Assert.IsInstanceOfType(ex, typeof(ArgumentOutOfRangeException));
+            }
+        }
+    }
+}
@@ -110,6 +110,66 @@ namespace LuaCLRBridge.Test
             }
         }
 
+        [TestMethod]
+        public void FunctionCallBatch()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var f = lua.Do("return function(x, y) return y, x end")[0] as LuaFunction;
+
+                var r = f.CallBatch(2, new[] { new object[] { "a", 1 }, new object[] { "b" }, null });
+
+                Assert.AreEqual(6, r.Length);
+                Assert.AreEqual(1.0, r[0]);
+                Assert.AreEqual("a", r[1]);
+                Assert.IsNull(r[2]);
+                Assert.AreEqual("b", r[3]);
+                Assert.IsNull(r[4]);
+                Assert.IsNull(r[5]);
+            }
+        }
+
+#if NO_SANDBOX
+        [TestMethod]
+        public void FunctionCallBatchIntoArray()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var f = lua.Do("return function(x) return x * 2 end")[0] as LuaFunction;
+
+                var results = new object[4];
+
+                f.CallBatch(1, new[] { new object[] { 1 }, new object[] { 2 }, new object[] { 3 } }, results);
+
+                Assert.AreEqual(2.0, results[0]);
+                Assert.AreEqual(4.0, results[1]);
+                Assert.AreEqual(6.0, results[2]);
+                Assert.IsNull(results[3]);
+            }
+        }
+#endif
+
+        [TestMethod]
+        public void FunctionCallBatchThrows()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var f = lua.Do("n = 0 return function(x) n = n + 1 return 1 / x end")[0] as LuaFunction;
+
+                try
+                {
+                    f.CallBatch(1, new[] { new object[] { 1 }, new object[] { "x" }, new object[] { 3 } });
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(LuaRuntimeException));
+                }
+
+                Assert.AreEqual(2.0, lua["n"]);
+            }
+        }
+
         [TestMethod]
         public void FunctionAlreadyDisposed()
         {
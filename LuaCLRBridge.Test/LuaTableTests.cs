@@ -109,6 +109,157 @@ namespace LuaCLRBridge.Test
             }
         }
 
+        [TestMethod]
+        public void IterateTableRaw()
+        {
+            // not sandboxed, since the enumerator must be in the application domain of the Lua state
+            using (var lua = new LuaBridge())
+            {
+                var t = lua.Do("return { 10, 20, 30, x = 'a', y = true }")[0] as LuaTable;
+
+                var entries = new Dictionary<object, object>();
+                foreach (var entry in t.RawPairs())
+                    entries.Add(entry.Key, entry.Value);
+
+                Assert.AreEqual(5, entries.Count);
+                Assert.AreEqual(20.0, entries[2.0]);
+                Assert.AreEqual("a", entries["x"]);
+                Assert.AreEqual(true, entries["y"]);
+
+                var e = t.RawPairs();
+
+                Assert.IsTrue(e.MoveNext());
+                var first = e.Current;
+
+                while (e.MoveNext())
+                    ;
+
+                Assert.IsFalse(e.MoveNext());
+
+                e.Reset();
+
+                Assert.IsTrue(e.MoveNext());
+                Assert.AreEqual(first, e.Current);
+
+                // the previous key need not still be in the table
+                int count = 0;
+                foreach (var entry in t.RawPairs())
+                {
+                    t[entry.Key] = null;
+                    ++count;
+                }
+
+                Assert.AreEqual(5, count);
+                Assert.IsTrue(t.IsEmpty);
+            }
+        }
+
+        [TestMethod]
+        public void IterateTableWhileRehashing()
+        {
+            // not sandboxed, since the enumerator must be in the application domain of the Lua state
+            using (var lua = new LuaBridge())
+            {
+                var t = lua.Do("return { 10, 20, 30, x = 'a', y = true }")[0] as LuaTable;
+
+                // changing existing pairs does not move them
+                int count = 0;
+                foreach (var entry in t.RawPairs())
+                {
+                    t[entry.Key] = entry.Value is double ? (object)((double)entry.Value + 1) : entry.Value;
+                    ++count;
+                }
+
+                Assert.AreEqual(5, count);
+                Assert.AreEqual(21.0, t[2.0]);
+
+                // adding enough keys that the table must be rehashed does
+                try
+                {
+                    int key = 0;
+                    foreach (var entry in t.RawPairs())
+                        for (int i = 0; i < 100; ++i)
+                            t["k" + key++] = i;
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(InvalidOperationException));
+                }
+
+                try
+                {
+                    int key = 0;
+                    foreach (var entry in t)
+                        for (int i = 0; i < 100; ++i)
+                            t["m" + key++] = i;
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(InvalidOperationException));
+                }
+
+                try
+                {
+                    int key = 0;
+                    t.ForEach((object k, object v) =>
+                    {
+                        for (int i = 0; i < 100; ++i)
+                            t["n" + key++] = i;
+                    });
+                    Assert.Fail();
+                }
+                catch (Exception ex)
+                {
+                    Assert.IsInstanceOfType(ex, typeof(InvalidOperationException));
+                }
+
+                // the table is still usable
+                Assert.AreEqual(21.0, t[2.0]);
+                Assert.AreEqual(0.0, t["k0"]);
+            }
+        }
+
+        [TestMethod]
+        public void TableForEach()
+        {
+            // not sandboxed, since the action must be in the application domain of the Lua state
+            using (var lua = new LuaBridge())
+            {
+                var t = lua.Do("return { 1, 2, 3, 4.5, x = 10, y = 'b', [true] = 100 }")[0] as LuaTable;
+
+                double sum = 0;
+                t.ForEach<int, double>(( key, value ) => sum += key * value);
+                Assert.AreEqual(1 * 1 + 2 * 2 + 3 * 3 + 4 * 4.5, sum);
+
+                var strings = new Dictionary<string, object>();
+                t.ForEach<string, object>(( key, value ) => strings.Add(key, value));
+                Assert.AreEqual(2, strings.Count);
+                Assert.AreEqual(10.0, strings["x"]);
+                Assert.AreEqual("b", strings["y"]);
+
+                double total = 0;
+                t.ForEach<double>(( value ) => total += value);
+                Assert.AreEqual(1 + 2 + 3 + 4.5 + 10 + 100, total);
+
+                // the action may use the Lua state
+                t.ForEach<string, string>(( key, value ) => lua[key + "2"] = value + value);
+                Assert.AreEqual("bb", lua["y2"]);
+
+                try
+                {
+                    t.ForEach<object, object>(( key, value ) => { throw new InvalidOperationException(); });
+                    Assert.Fail();
+                }
+                catch (InvalidOperationException)
+                {
+                }
+
+                Assert.AreEqual(7, t.Count);
+            }
+        }
+
         [TestMethod]
         public void TableToArrayPrimitive()
         {
@@ -139,6 +290,23 @@ namespace LuaCLRBridge.Test
             }
         }
 
+        [TestMethod]
+        public void TableToArrayLarge()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var r = lua.Do("local a = {} for i = 1, 1000 do a[i] = { i } end a[500] = a[1] return a");
+
+                object[] os = (r[0] as LuaTable).RawToArray();
+                Assert.AreEqual(1000, os.Length);
+
+                for (int i = 0; i < os.Length; ++i)
+                    Assert.AreEqual(i == 499 ? 1.0 : i + 1.0, (os[i] as LuaTable)[1]);
+
+                Assert.AreEqual(os[0], os[499]);
+            }
+        }
+
         [TestMethod]
         public void NewTable()
         {
@@ -549,6 +549,37 @@ namespace LuaCLRBridge.Test.ObjectTranslator
             }
         }
 
+        [TestMethod]
+        public void ReuseCollectedObjectSlots()
+        {
+            using (var lua = new LuaBridge())
+            {
+                lua["o"] = new Tuple<bool, string>(true, "test");
+                lua["T"] = new CLRStaticContext(typeof(Object));
+
+                for (int i = 0; i < 3; ++i)
+                {
+                    lua.Do("t = {} for i = 1, 1000 do t[i] = T() end");
+
+                    lua["t"] = null;
+                    lua.Do("collectgarbage()");
+                }
+
+                lua["s"] = new Tuple<int>(42);
+
+                Tuple<bool, string> o = lua["o"] as Tuple<bool, string>;
+
+                Assert.IsNotNull(o);
+                Assert.AreEqual(true, o.Item1);
+                Assert.AreEqual("test", o.Item2);
+
+                Tuple<int> s = lua["s"] as Tuple<int>;
+
+                Assert.IsNotNull(s);
+                Assert.AreEqual(42, s.Item1);
+            }
+        }
+
         private LuaCFunction GenerateDelegate( bool value )
         {
             return delegate( IntPtr L )
@@ -86,6 +86,52 @@ namespace LuaCLRBridge.Test.ObjectTranslator
             }
         }
 
+        [Serializable]
+        public struct ValueTypeField
+        {
+            public double y;
+        }
+
+        [TestMethod]
+        public void GetSetValueTypeField()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                lua["x"] = new ValueTypeField { y = 1 };
+
+                var r = lua.Do("local y = x.y; x.y = 2; return y, x.y");
+
+                Assert.AreEqual(2, r.Length);
+                Assert.AreEqual((double)1, r[0]);
+                Assert.AreEqual((double)2, r[1]);
+            }
+        }
+
+        [Serializable]
+        public class StaticFields
+        {
+            public const int c = 3;
+            public static readonly int ro = 4;
+            public static double y;
+        }
+
+        [TestMethod]
+        public void GetSetStaticFields()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                lua["T"] = new CLRStaticContext(typeof(StaticFields));
+
+                var r = lua.Do("T.y = 2; return T.c, T.ro, T.y, T.y");
+
+                Assert.AreEqual(4, r.Length);
+                Assert.AreEqual((double)StaticFields.c, r[0]);
+                Assert.AreEqual((double)StaticFields.ro, r[1]);
+                Assert.AreEqual((double)2, r[2]);
+                Assert.AreEqual((double)2, r[3]);
+            }
+        }
+
         [Serializable]
         private class DelegateField
         {
@@ -54,6 +54,84 @@ namespace LuaCLRBridge.Test.ObjectTranslator
             }
         }
 
+        [Serializable]
+        private class RepeatedlyAccessedMembers
+        {
+            public int field;
+            public int Property { get; set; }
+        }
+
+        [TestMethod]
+        public void GetSetMembersRepeatedly()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var x = new RepeatedlyAccessedMembers();
+                var y = new RepeatedlyAccessedMembers();
+
+                lua["x"] = x;
+                lua["y"] = y;
+
+                var r = lua.Do("for i = 1, 100 do x.field = i; y.Property = x.field * 2 end return x.field, y.Property, y.field, x.Property");
+
+                Assert.AreEqual(4, r.Length);
+                Assert.AreEqual(100.0, r[0]);
+                Assert.AreEqual(200.0, r[1]);
+                Assert.AreEqual(0.0, r[2]);
+                Assert.AreEqual(0.0, r[3]);
+                Assert.AreEqual(100, x.field);
+                Assert.AreEqual(200, y.Property);
+            }
+        }
+
+        [Serializable]
+        private class LongNamedMembers
+        {
+            public int fieldWithANameLongerThanTheLimitForInternedLuaStrings;
+            public int y;
+        }
+
+        [TestMethod]
+        public void GetSetMembersAfterManyNames()
+        {
+            using (var lua = CreateInstrumentedLuaBridge(Instrumentations.None))
+            {
+                var x = new LongNamedMembers();
+
+                lua["x"] = x;
+
+                var r = lua.Do(@"
+                    local missing = 0
+                    for i = 1, 5000 do
+                        if not pcall(function() return x['y' .. i] end) then missing = missing + 1 end
+                        if not pcall(function() x['y' .. i] = i end) then missing = missing + 1 end
+                    end
+                    return missing");
+
+                Assert.AreEqual(10000.0, r[0]);
+
+                // names that resolve to no member are not kept
+                int names = lua.InternedMemberNameCount;
+
+                r = lua.Do(@"
+                    x.y = 1
+                    x.fieldWithANameLongerThanTheLimitForInternedLuaStrings = 2
+                    return x.y, x['field' .. 'WithANameLongerThanTheLimitForInternedLuaStrings']");
+
+                Assert.AreEqual(2, r.Length);
+                Assert.AreEqual(1.0, r[0]);
+                Assert.AreEqual(2.0, r[1]);
+
+                // the names of the members are kept despite the misses, and are then reused
+                Assert.AreEqual(names + 2, lua.InternedMemberNameCount);
+
+                r = lua.Do("for i = 1, 10 do x.y = x.y + x.fieldWithANameLongerThanTheLimitForInternedLuaStrings end return x.y");
+
+                Assert.AreEqual(names + 2, lua.InternedMemberNameCount);
+                Assert.AreEqual(21.0, r[0]);
+            }
+        }
+
         #region Constructors
 
         [Serializable]
@@ -128,6 +128,38 @@ namespace LuaCLRBridge.Test.ObjectTranslator
             }
         }
 
+        [TestMethod]
+        public void SpecialNameHintsDoNotAffectUnhintedResolution()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                SpecialName x = new SpecialName(2);
+                SpecialName y = new SpecialName(3);
+
+                lua["c"] = new CLRStaticContext(typeof(SpecialName));
+                lua["x"] = x;
+                lua["y"] = y;
+
+                for (int i = 0; i < 2; ++i)
+                {
+                    try
+                    {
+                        lua.Do("return c.op_Addition(x, y)");
+
+                        Assert.Fail();
+                    }
+                    catch (MissingMemberException)
+                    {
+                    }
+
+                    var r = lua.Do("return c{SpecialName = true}.op_Addition(x, y)");
+
+                    Assert.AreEqual(1, r.Length);
+                    Assert.AreEqual(x + y, r[0]);
+                }
+            }
+        }
+
         [Serializable]
         private struct NonSpecialName
         {
@@ -1292,6 +1292,51 @@ namespace LuaCLRBridge.Test.ObjectTranslator
                 Assert.AreEqual((double)1, r[0]);
             }
         }
+
+        [Serializable]
+        private class NumericValueOverloadedMethods
+        {
+            public string f( byte b ) { return MethodBase.GetCurrentMethod().MethodFormat("({0})", b); }
+            public string f( string s ) { return MethodBase.GetCurrentMethod().MethodFormat("({0})", s); }
+
+            public string g( params int[] x ) { return MethodBase.GetCurrentMethod().MethodFormat("({0})", new[] { x }); }
+        }
+
+        [TestMethod]
+        public void CallOverloadedMethodsRepeatedlyWithDifferentNumericValues()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var x = new NumericValueOverloadedMethods();
+
+                lua["x"] = x;
+
+                // the applicable overloads depend on the numeric values, not only on their Lua type
+                foreach (var chunk in new[] { "return x.f(1.5)", "return x.f(256)", "return x.g(1, 2.5)" })
+                {
+                    for (int i = 0; i < 2; ++i)
+                    {
+                        var r = lua.Do("return x.f(1), x.f('y'), x.f(255), x.g(1, 2)");
+
+                        Assert.AreEqual(4, r.Length);
+                        Assert.AreEqual(x.f((byte)1), r[0]);
+                        Assert.AreEqual(x.f("y"), r[1]);
+                        Assert.AreEqual(x.f((byte)255), r[2]);
+                        Assert.AreEqual(x.g(1, 2), r[3]);
+
+                        try
+                        {
+                            lua.Do(chunk);
+                            Assert.Fail();
+                        }
+                        catch (MissingMethodException)
+                        {
+                            // expected
+                        }
+                    }
+                }
+            }
+        }
     }
 
     internal static class MethodCallHelpers
@@ -38,6 +38,92 @@ namespace LuaCLRBridge.Test.ObjectTranslator
             }
         }
 
+        [TestMethod]
+        public void CallMethodRepeatedly()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var x = new Method();
+                var y = new Method();
+
+                lua["x"] = x;
+                lua["y"] = y;
+
+                // the method group is reused for the same target and member, but not across targets
+                var r = lua.Do("return rawequal(x.f, x.f), rawequal(x.f, y.f), rawequal(x.f, x.f{'Boolean'})");
+
+                Assert.AreEqual(3, r.Length);
+                Assert.AreEqual(true, r[0]);
+                Assert.AreEqual(false, r[1]);
+                Assert.AreEqual(false, r[2]);
+
+                r = lua.Do("local s = '' for i = 1, 10 do s = x.f(i % 2 == 0) end return s, x.f{'Boolean'}(false), x.f(true)");
+
+                Assert.AreEqual(3, r.Length);
+                Assert.AreEqual(x.f(false), r[0]);
+                Assert.AreEqual(x.f(false), r[1]);
+                Assert.AreEqual(x.f(true), r[2]);
+            }
+        }
+
+
+        public enum TypedEnum
+        {
+            A,
+            B,
+        }
+
+        [Serializable]
+        public class TypedMethods
+        {
+            public int Add( int i, double d ) { return i + (int)d; }
+            public string Concat( string s, char c, bool z ) { return (s ?? "null") + c + z; }
+            public TypedEnum Next( TypedEnum e ) { return e + 1; }
+            public object Identity( object o ) { return o; }
+            public int Count( LuaTable t ) { return t.RawToArray().Length; }
+            public object Call( LuaFunction f ) { return f.Call()[0]; }
+            public static byte Static( byte b, float f, long l ) { return (byte)(b + f + l); }
+        }
+
+        [TestMethod]
+        public void CallTypedMethods()
+        {
+            using (var lua = CreateLuaBridge())
+            {
+                var x = new TypedMethods();
+
+                lua["x"] = x;
+                lua["X"] = new CLRStaticContext(typeof(TypedMethods));
+                lua["e"] = TypedEnum.A;
+
+                var r = lua.Do("return x.Add(1, 2.5), x.Concat('s', 65, true), x.Concat(nil, 66, false), x.Next(e), x.Identity(1), x.Identity('o'), x.Count({ 1, 2, 3 }), x.Call(function() return 4 end), X.Static(1, 2, 3)");
+
+                Assert.AreEqual(9, r.Length);
+                Assert.AreEqual((double)x.Add(1, 2.5), r[0]);
+                Assert.AreEqual(x.Concat("s", 'A', true), r[1]);
+                Assert.AreEqual(x.Concat(null, 'B', false), r[2]);
+                Assert.AreEqual(TypedEnum.B, r[3]);
+                Assert.AreEqual((double)1, r[4]);
+                Assert.AreEqual("o", r[5]);
+                Assert.AreEqual((double)3, r[6]);
+                Assert.AreEqual((double)4, r[7]);
+                Assert.AreEqual((double)TypedMethods.Static(1, 2, 3), r[8]);
+
+                // arguments that are not passed unchanged are bound as before
+                foreach (var chunk in new[] { "x.Add(1.5, 2)", "x.Add(1)", "x.Add('1', 2)", "x.Concat(1, 65, true)", "X.Static(256, 0, 0)" })
+                {
+                    try
+                    {
+                        lua.Do(chunk);
+                        Assert.Fail();
+                    }
+                    catch (MissingMethodException)
+                    {
+                        // expected
+                    }
+                }
+            }
+        }
 
         [Serializable]
         private class MethodRef
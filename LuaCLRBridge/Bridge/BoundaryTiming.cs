@@ -0,0 +1,337 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Generic;
+    using System.Diagnostics;
+    using System.Threading;
+
+    /// <summary>
+    /// Specifies the kind of a crossing between Lua and the CLR.
+    /// </summary>
+    public enum BoundaryKind
+    {
+        /// <summary>A CLI method or constructor invoked from Lua.</summary>
+        Method,
+
+        /// <summary>A CLI field or property (or indexed property) gotten from Lua.</summary>
+        Get,
+
+        /// <summary>A CLI field or property (or indexed property) set from Lua.</summary>
+        Set,
+
+        /// <summary>A CLI operator overload invoked from Lua.</summary>
+        Operator,
+
+        /// <summary>A Lua function called from the CLR.</summary>
+        LuaFunction,
+    }
+
+    /// <summary>
+    /// Represents the timing of the crossings between Lua and the CLR through a single member or function.
+    /// </summary>
+    [Serializable]
+    public struct BoundaryTimingStatistics
+    {
+        private readonly BoundaryKind _kind;
+
+        private readonly string _name;
+
+        private readonly long _count;
+
+        private readonly TimeSpan _totalTime;
+
+        private readonly TimeSpan _maxTime;
+
+        internal BoundaryTimingStatistics( BoundaryKind kind, string name, long count, TimeSpan totalTime, TimeSpan maxTime )
+        {
+            _kind = kind;
+            _name = name;
+            _count = count;
+            _totalTime = totalTime;
+            _maxTime = maxTime;
+        }
+
+        /// <summary>
+        /// Gets the kind of the crossings.
+        /// </summary>
+        public BoundaryKind Kind
+        {
+            get { return _kind; }
+        }
+
+        /// <summary>
+        /// Gets the name of the CLI member (qualified by the type through which it was accessed) or the
+        /// location where the Lua function is defined.
+        /// </summary>
+        public string Name
+        {
+            get { return _name; }
+        }
+
+        /// <summary>
+        /// Gets the number of crossings that completed.
+        /// </summary>
+        public long Count
+        {
+            get { return _count; }
+        }
+
+        /// <summary>
+        /// Gets the total time of the crossings.
+        /// </summary>
+        public TimeSpan TotalTime
+        {
+            get { return _totalTime; }
+        }
+
+        /// <summary>
+        /// Gets the time of the longest crossing.
+        /// </summary>
+        public TimeSpan MaxTime
+        {
+            get { return _maxTime; }
+        }
+    }
+
+    /// <summary>
+    /// Counts and times the crossings between Lua and the CLR.
+    /// </summary>
+    /// <remarks>
+    /// Each thread records into its own table, which only that thread modifies, so that recording does not
+    /// contend with other threads; readers lock each table briefly while copying it.  The tables of threads
+    /// that have exited are folded into one whenever another thread starts recording or the timing is read,
+    /// so that a host that starts many threads does not keep a table for each.  Times are inclusive:
+    /// a CLI method that calls back into Lua includes the time of the Lua function.
+    /// </remarks>
+    internal sealed class BoundaryTiming : IDisposable
+    {
+        private struct Key : IEquatable<Key>
+        {
+            internal readonly BoundaryKind _kind;
+
+            internal readonly Type _type;
+
+            internal readonly string _name;
+
+            internal Key( BoundaryKind kind, Type type, string name )
+            {
+                _kind = kind;
+                _type = type;
+                _name = name;
+            }
+
+            public bool Equals( Key other )
+            {
+                return _kind == other._kind && _type == other._type && String.Equals(_name, other._name);
+            }
+
+            public override bool Equals( object obj )
+            {
+                return obj is Key && Equals((Key)obj);
+            }
+
+            public override int GetHashCode()
+            {
+                int hash = (int)_kind;
+
+                if (_type != null)
+                    hash = hash * 31 + _type.GetHashCode();
+                if (_name != null)
+                    hash = hash * 31 + _name.GetHashCode();
+
+                return hash;
+            }
+        }
+
+        private sealed class Counter
+        {
+            internal long _count;
+
+            internal long _total;
+
+            internal long _max;
+        }
+
+        /// <summary>
+        /// The table of each thread that has recorded, with the thread.
+        /// </summary>
+        private readonly List<KeyValuePair<Thread, Dictionary<Key, Counter>>> _tables = new List<KeyValuePair<Thread, Dictionary<Key, Counter>>>();
+
+        /// <summary>
+        /// The tables of the threads that have exited, combined; guarded by the lock of <see cref="_tables"/>.
+        /// </summary>
+        private readonly Dictionary<Key, Counter> _exitedTable = new Dictionary<Key, Counter>();
+
+        private readonly ThreadLocal<Dictionary<Key, Counter>> _table;
+
+        internal BoundaryTiming()
+        {
+            _table = new ThreadLocal<Dictionary<Key, Counter>>(NewTable);
+        }
+
+        private Dictionary<Key, Counter> NewTable()
+        {
+            var table = new Dictionary<Key, Counter>();
+
+            lock (_tables)
+            {
+                FoldExitedTables();
+
+                _tables.Add(new KeyValuePair<Thread, Dictionary<Key, Counter>>(Thread.CurrentThread, table));
+            }
+
+            return table;
+        }
+
+        /// <summary>
+        /// Moves the tables of the threads that have exited into <see cref="_exitedTable"/>; called with the
+        /// lock of <see cref="_tables"/> held.
+        /// </summary>
+        private void FoldExitedTables()
+        {
+            int kept = 0;
+
+            for (int i = 0; i < _tables.Count; ++i)
+            {
+                KeyValuePair<Thread, Dictionary<Key, Counter>> entry = _tables[i];
+
+                if (entry.Key.IsAlive)
+                {
+                    _tables[kept++] = entry;
+                }
+                else
+                {
+                    // a thread that has exited no longer records into its table
+                    Combine(_exitedTable, entry.Value);
+                }
+            }
+
+            _tables.RemoveRange(kept, _tables.Count - kept);
+        }
+
+        private static void Combine( Dictionary<Key, Counter> combined, Dictionary<Key, Counter> table )
+        {
+            foreach (KeyValuePair<Key, Counter> entry in table)
+            {
+                Counter counter;
+                if (!combined.TryGetValue(entry.Key, out counter))
+                {
+                    counter = new Counter();
+                    combined.Add(entry.Key, counter);
+                }
+
+                counter._count += entry.Value._count;
+                counter._total += entry.Value._total;
+                counter._max = Math.Max(counter._max, entry.Value._max);
+            }
+        }
+
+        /// <summary>
+        /// Gets the current time, for passing to <see cref="Record"/>.
+        /// </summary>
+        internal static long Now
+        {
+            get { return Stopwatch.GetTimestamp(); }
+        }
+
+        /// <summary>
+        /// Records a crossing that has completed.
+        /// </summary>
+        /// <param name="kind">The kind of the crossing.</param>
+        /// <param name="type">The type through which the member was accessed, or <c>null</c>.</param>
+        /// <param name="name">The name of the member or function.</param>
+        /// <param name="start">The time at which the crossing started, from <see cref="Now"/>.</param>
+        internal void Record( BoundaryKind kind, Type type, string name, long start )
+        {
+            long elapsed = Stopwatch.GetTimestamp() - start;
+
+            Dictionary<Key, Counter> table = _table.Value;
+            var key = new Key(kind, type, name);
+
+            lock (table)
+            {
+                Counter counter;
+                if (!table.TryGetValue(key, out counter))
+                {
+                    counter = new Counter();
+                    table.Add(key, counter);
+                }
+
+                counter._count += 1;
+                counter._total += elapsed;
+                if (elapsed > counter._max)
+                    counter._max = elapsed;
+            }
+        }
+
+        /// <summary>
+        /// Combines the tables of all threads.
+        /// </summary>
+        /// <returns>The timing of each member or function, in order of decreasing total time.</returns>
+        internal BoundaryTimingStatistics[] GetStatistics()
+        {
+            var combined = new Dictionary<Key, Counter>();
+
+            lock (_tables)
+            {
+                FoldExitedTables();
+
+                Combine(combined, _exitedTable);
+
+                foreach (KeyValuePair<Thread, Dictionary<Key, Counter>> entry in _tables)
+                    lock (entry.Value)
+                        Combine(combined, entry.Value);
+            }
+
+            var statistics = new List<BoundaryTimingStatistics>(combined.Count);
+
+            foreach (KeyValuePair<Key, Counter> entry in combined)
+            {
+                Key key = entry.Key;
+                string name = key._type != null ? key._type.FullName + "." + key._name : key._name;
+
+                statistics.Add(new BoundaryTimingStatistics(key._kind, name, entry.Value._count, ToTimeSpan(entry.Value._total), ToTimeSpan(entry.Value._max)));
+            }
+
+            statistics.Sort(( x, y ) => y.TotalTime.CompareTo(x.TotalTime));
+
+            return statistics.ToArray();
+        }
+
+        /// <summary>
+        /// Discards the timing of all threads.
+        /// </summary>
+        internal void Reset()
+        {
+            lock (_tables)
+            {
+                FoldExitedTables();
+
+                _exitedTable.Clear();
+
+                foreach (KeyValuePair<Thread, Dictionary<Key, Counter>> entry in _tables)
+                    lock (entry.Value)
+                        entry.Value.Clear();
+            }
+        }
+
+        private static TimeSpan ToTimeSpan( long timestamps )
+        {
+            return TimeSpan.FromTicks((long)(timestamps * ((double)TimeSpan.TicksPerSecond / Stopwatch.Frequency)));
+        }
+
+        public void Dispose()
+        {
+            _table.Dispose();
+        }
+    }
+}
@@ -225,7 +225,7 @@ namespace LuaCLRBridge
             if (dictionary == null)
                 throw new ArgumentNullException("dictionary");
 
-            LuaTable table = LuaTable.Create(_objectTranslator);
+            LuaTable table = LuaTable.Create(_objectTranslator, 0, dictionary.Count);
 
             using (var lockedMainL = _objectTranslator.LockedMainState)
             {
@@ -235,12 +235,13 @@ namespace LuaCLRBridge
 
                 table.Push(L);
 
+                // the new table has no metatable, so entries are set raw
                 foreach (var entry in dictionary)
                 {
                     _objectTranslator.PushObject(L, entry.Key);
                     _objectTranslator.PushObject(L, entry.Value);
 
-                    LuaWrapper.lua_settable(L, -3);
+                    LuaWrapper.lua_rawset(L, -3);
                 }
 
                 LuaWrapper.lua_pop(L, 1);  // table
@@ -263,23 +264,34 @@ namespace LuaCLRBridge
             if (list == null)
                 throw new ArgumentNullException("list");
 
+            Array array = list as Array;
+
+            if (array == null && IsBulkElementType(typeof(T)))
+            {
+                var elements = new T[list.Count];
+                list.CopyTo(elements, 0);
+                array = elements;
+            }
+
+            if (array != null)
+                return ToTable(array, initialIndex);
+
             LuaTable table = LuaTable.Create(_objectTranslator, list.Count, 0);
 
             using (var lockedMainL = _objectTranslator.LockedMainState)
             {
                 var L = lockedMainL._L;
 
-                ObjectTranslator.CheckStack(L, 3);  // table + index + element
+                ObjectTranslator.CheckStack(L, 2);  // table + element
 
                 table.Push(L);
 
                 int index = initialIndex;
                 foreach (var element in list)
                 {
-                    LuaWrapper.lua_pushinteger(L, index);
                     _objectTranslator.PushObject(L, element);
 
-                    LuaWrapper.lua_settable(L, -3);
+                    LuaWrapper.lua_rawseti(L, -2, index);
 
                     ++index;
                 }
@@ -315,16 +327,18 @@ namespace LuaCLRBridge
             {
                 var L = lockedMainL._L;
 
-                ObjectTranslator.CheckStack(L, 3);  // table + index + value
+                ObjectTranslator.CheckStack(L, 2);  // table + value
 
                 table.Push(L);
 
-                for (int index = 0; index < length; ++index)
+                if (!TrySetArray(L, array, initialIndex))
                 {
-                    LuaWrapper.lua_pushinteger(L, index + initialIndex);
-                    _objectTranslator.PushObject(L, array.GetValue(index));
+                    for (int index = 0; index < length; ++index)
+                    {
+                        _objectTranslator.PushObject(L, array.GetValue(index));
 
-                    LuaWrapper.lua_settable(L, -3);
+                        LuaWrapper.lua_rawseti(L, -2, index + initialIndex);
+                    }
                 }
 
                 LuaWrapper.lua_pop(L, 1);  // table
@@ -346,7 +360,7 @@ namespace LuaCLRBridge
             if (set == null)
                 throw new ArgumentNullException("set");
 
-            LuaTable table = LuaTable.Create(_objectTranslator);
+            LuaTable table = LuaTable.Create(_objectTranslator, 0, set.Count);
 
             using (var lockedMainL = _objectTranslator.LockedMainState)
             {
@@ -361,7 +375,7 @@ namespace LuaCLRBridge
                     _objectTranslator.PushObject(L, element);
                     LuaWrapper.lua_pushvalue(L, -1);
 
-                    LuaWrapper.lua_settable(L, -3);
+                    LuaWrapper.lua_rawset(L, -3);
                 }
 
                 LuaWrapper.lua_pop(L, 1);  // table
@@ -370,6 +384,54 @@ namespace LuaCLRBridge
             return table;
         }
 
+        /// <summary>
+        /// Determines whether arrays of a type are translated to tables in a single native call.
+        /// </summary>
+        private static bool IsBulkElementType( Type type )
+        {
+            return type == typeof(double) || type == typeof(float) || type == typeof(int) ||
+                type == typeof(byte) || type == typeof(bool) || type == typeof(string);
+        }
+
+        /// <summary>
+        /// Sets the elements of an array of a primitive type or strings into the array part of the new table
+        /// on the top of the stack in a single native call, without boxing them.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="array">The one-dimensional array.</param>
+        /// <param name="initialIndex">The table index of the first element from the array.</param>
+        /// <returns><c>true</c> if the elements were set; <c>false</c> if they must be set individually.
+        ///     </returns>
+        [SecurityCritical]
+        private bool TrySetArray( IntPtr L, Array array, int initialIndex )
+        {
+            // the elements before the initial index are also allocated in the array part, so it must be dense
+            if (initialIndex < 1 || initialIndex - 1 > array.Length || array.Length > Int32.MaxValue - (initialIndex - 1) || array.GetLowerBound(0) != 0)
+                return false;
+
+            int first = initialIndex - 1;
+
+            // the types are compared exactly, since the runtime treats (e.g.) uint[] as an int[]
+            Type type = array.GetType();
+
+            if (type == typeof(double[]))
+                LuaWrapper.luaW_setarray(L, (double[])array, first);
+            else if (type == typeof(float[]))
+                LuaWrapper.luaW_setarray(L, (float[])array, first);
+            else if (type == typeof(int[]))
+                LuaWrapper.luaW_setarray(L, (int[])array, first);
+            else if (type == typeof(byte[]))
+                LuaWrapper.luaW_setarray(L, (byte[])array, first);
+            else if (type == typeof(bool[]))
+                LuaWrapper.luaW_setarray(L, (bool[])array, first);
+            else if (type == typeof(string[]))
+                LuaWrapper.luaW_setarray(L, (string[])array, first, _objectTranslator.Encoding);
+            else
+                return false;
+
+            return true;
+        }
+
         #endregion
 
         #region Types
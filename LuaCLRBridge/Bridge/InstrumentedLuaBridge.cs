@@ -31,16 +31,26 @@ namespace LuaCLRBridge
         None = 0,
 
         /// <summary>A hook for interrupting script execution will be set.</summary>
-        Interruption,
+        Interruption = 1,
 
         /// <summary>Memory allocation will be monitored.</summary>
-        MemoryMonitoring,
+        MemoryMonitoring = 2,
+
+        /// <summary>Memory allocation will be monitored, and small blocks will be allocated from pools of
+        /// same-sized blocks.</summary>
+        MemoryPooling = 4,
+
+        /// <summary>A hook for sampling the Lua call stack will be set.</summary>
+        Profiling = 8,
+
+        /// <summary>Calls between Lua and the CLR will be counted and timed.</summary>
+        BoundaryTiming = 16,
     }
 
     /// <summary>
     /// Represents the main thread of a Lua state with optional instrumentation.
     /// </summary>
-    public sealed class InstrumentedLuaBridge : LuaBridge
+    public sealed partial class InstrumentedLuaBridge : LuaBridge
     {
         private bool _disposed = false;
 
@@ -49,6 +59,15 @@ namespace LuaCLRBridge
 
         private readonly LuaInterjector _interjector;
 
+        /// <summary>
+        /// Whether the <see cref="Instrumentations.Interruption"/> flag was specified, which enables the
+        /// members that cancel or interject through <see cref="_interjector"/>.  The
+        /// <see cref="Instrumentations.Profiling"/> flag alone sets the hook only for sampling.
+        /// </summary>
+        private readonly bool _interruptible;
+
+        private readonly BoundaryTiming _boundaryTiming;
+
         /// <summary>
         /// Initializes a new instance of the <see cref="InstrumentedLuaBridge"/> class with a new Lua state
         /// with optional instrumentation.
@@ -64,32 +83,63 @@ namespace LuaCLRBridge
         ///     iso-8859-1 is used.</param>
         [SecuritySafeCritical]
         public InstrumentedLuaBridge( Instrumentations instrumentations, string clrBridge = null, Encoding encoding = null )
-            : this(instrumentations.HasFlag(Instrumentations.MemoryMonitoring), null, clrBridge, encoding)
+            : this(instrumentations.HasFlag(Instrumentations.MemoryMonitoring) || instrumentations.HasFlag(Instrumentations.MemoryPooling),
+                   instrumentations.HasFlag(Instrumentations.MemoryPooling), null, clrBridge, encoding)
         {
-            if (instrumentations.HasFlag(Instrumentations.Interruption))
+            _interruptible = instrumentations.HasFlag(Instrumentations.Interruption);
+
+            if (_interruptible || instrumentations.HasFlag(Instrumentations.Profiling))
             {
                 using (var lockedL = LockedState)
                 {
                     var L = lockedL._L;
 
-                    _interjector = LuaHelper.luaH_setnewinterjectionhook(L);
+                    _interjector = LuaHelper.luaH_setnewinterjectionhook(L, _allocTracker);
                 }
             }
+
+            if (instrumentations.HasFlag(Instrumentations.Profiling))
+                InitializeProfiling();
+
+            if (instrumentations.HasFlag(Instrumentations.BoundaryTiming))
+            {
+                _boundaryTiming = new BoundaryTiming();
+                _state._objectTranslator._boundaryTiming = _boundaryTiming;
+            }
         }
 
         [SecuritySafeCritical]
-        private InstrumentedLuaBridge( bool instrumentMemory, LuaAllocTracker allocTracker, string clrBridge, Encoding encoding )
-            : base(instrumentMemory ? LuaHelper.luaH_newstate(out allocTracker) : LuaWrapper.luaL_newstate(), clrBridge, encoding)
+        private InstrumentedLuaBridge( bool instrumentMemory, bool poolMemory, LuaAllocTracker allocTracker, string clrBridge, Encoding encoding )
+            : base(instrumentMemory ? LuaHelper.luaH_newstate(poolMemory, out allocTracker) : LuaWrapper.luaL_newstate(), clrBridge, encoding)
         {
             _allocTracker = allocTracker;
+
+            if (_allocTracker != null)
+            {
+                var objectTranslator = _state._objectTranslator;
+
+                objectTranslator._objectTableResized = ObjectTableResized;
+                ObjectTableResized(objectTranslator.ObjectTableSize);
+            }
+        }
+
+        /// <summary>
+        /// Counts the object table toward the memory limits, since the CLI objects it references are kept alive
+        /// by the Lua state.
+        /// </summary>
+        /// <param name="size">The size in bytes of the object table.</param>
+        [SecurityCritical]
+        private void ObjectTableResized( long size )
+        {
+            _allocTracker.External = new UIntPtr((ulong)size);
         }
 
         /// <summary>
         /// Gets the size of memory currently allocated for the Lua state.
         /// </summary>
-        /// <exception cref="InvalidOperationException">If the
-        ///     <see cref="Instrumentations.MemoryMonitoring"/> flag was not specified at construction.
-        ///     </exception>
+        /// <exception cref="InvalidOperationException">If neither the
+        ///     <see cref="Instrumentations.MemoryMonitoring"/> flag nor the
+        ///     <see cref="Instrumentations.MemoryPooling"/> flag was specified at construction.</exception>
         [CLSCompliant(false)]
         public UIntPtr MemoryAllocatedSize
         {
@@ -103,6 +153,192 @@ namespace LuaCLRBridge
             }
         }
 
+        /// <summary>
+        /// Gets or sets the most memory that may be allocated for the Lua state, or zero for no limit.
+        /// </summary>
+        /// <exception cref="InvalidOperationException">If neither the
+        ///     <see cref="Instrumentations.MemoryMonitoring"/> flag nor the
+        ///     <see cref="Instrumentations.MemoryPooling"/> flag was specified at construction.</exception>
+        /// <remarks>
+        /// <para>An allocation that would exceed the limit fails, and Lua raises a "not enough memory" error
+        /// after collecting garbage and retrying it.  Lowering the limit below <see cref="MemoryAllocatedSize"/>
+        /// does not free any memory.</para>
+        /// <para>The limit applies to <see cref="MemoryAllocatedSize"/> plus the table in which the bridge
+        /// keeps the CLI objects that are referenced from Lua.</para>
+        /// </remarks>
+        [CLSCompliant(false)]
+        public UIntPtr MemoryLimit
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                if (_allocTracker == null)
+                    throw new InvalidOperationException();
+                else
+                    return _allocTracker.Limit;
+            }
+
+            [SecuritySafeCritical]
+            set
+            {
+                if (_allocTracker == null)
+                    throw new InvalidOperationException();
+                else
+                    _allocTracker.Limit = value;
+            }
+        }
+
+        /// <summary>
+        /// Gets or sets the memory beyond which the Lua state collects garbage as soon as possible, or zero for
+        /// no limit.
+        /// </summary>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.Interruption"/>
+        ///     flag and either the <see cref="Instrumentations.MemoryMonitoring"/> flag or the
+        ///     <see cref="Instrumentations.MemoryPooling"/> flag were not specified at construction.
+        ///     </exception>
+        /// <remarks>
+        /// <para>An allocation that exceeds the soft limit enables the interjection hook, which then does a step
+        /// of garbage collection in proportion to the excess before the next Lua instruction.  The allocation
+        /// itself succeeds.</para>
+        /// <para>The soft limit applies to the same memory as <see cref="MemoryLimit"/>, which should be
+        /// higher.</para>
+        /// </remarks>
+        [CLSCompliant(false)]
+        public UIntPtr MemorySoftLimit
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                if (_allocTracker == null || !_interruptible)
+                    throw new InvalidOperationException();
+                else
+                    return _allocTracker.SoftLimit;
+            }
+
+            [SecuritySafeCritical]
+            set
+            {
+                if (_allocTracker == null || !_interruptible)
+                    throw new InvalidOperationException();
+                else
+                    _allocTracker.SoftLimit = value;
+            }
+        }
+
+        /// <summary>
+        /// Gets or sets whether Lua objects waiting to be unreferenced (see
+        /// <see cref="LuaBridgeBase.DrainDeferredUnrefs"/>) are also unreferenced by interjections while Lua
+        /// code runs, a batch at a time.
+        /// </summary>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.Interruption"/>
+        ///     flag was not specified at construction.</exception>
+        /// <remarks>
+        /// This keeps the Lua objects from piling up while long-running Lua code keeps the Lua state locked.
+        /// </remarks>
+        public bool InterjectDeferredUnrefs
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                if (!_interruptible)
+                    throw new InvalidOperationException();
+                else
+                    return _state._objectTranslator._deferredUnrefsBacklogged != null;
+            }
+
+            [SecuritySafeCritical]
+            set
+            {
+                if (!_interruptible)
+                    throw new InvalidOperationException();
+                else
+                    _state._objectTranslator._deferredUnrefsBacklogged = value ? DeferredUnrefsBacklogged : (Action)null;
+            }
+        }
+
+        /// <summary>
+        /// Interjects a batch of deferred unreferences; called on the thread that deferred an unreference.
+        /// </summary>
+        [SecurityCritical]
+        private void DeferredUnrefsBacklogged()
+        {
+            var objectTranslator = _state._objectTranslator;
+
+            // interjections run while the Lua state is locked by the thread running Lua code
+            _interjector.Interject(( L ) => objectTranslator.DrainBackloggedDeferredUnrefs());
+        }
+
+        /// <summary>
+        /// Gets the number of names of CLI members that have been decoded from Lua strings and are reused
+        /// whenever the members are indexed again.
+        /// </summary>
+        /// <remarks>
+        /// Names are kept only once they resolve to members, up to a limit.
+        /// </remarks>
+        public int InternedMemberNameCount
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    return _state._objectTranslator.MemberNameCount;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the statistics of each size class of the memory pools of the Lua state.
+        /// </summary>
+        /// <returns>The statistics of the size classes, in order of block size.</returns>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.MemoryPooling"/>
+        ///     flag was not specified at construction.</exception>
+        [SecuritySafeCritical]
+        public LuaAllocSizeClass[] GetMemorySizeClasses()
+        {
+            if (_allocTracker == null || !_allocTracker.Pooled)
+                throw new InvalidOperationException();
+            else
+                return _allocTracker.GetSizeClasses();
+        }
+
+        /// <summary>
+        /// Gets the count, total time, and longest time of the calls between Lua and the CLR through each
+        /// CLI member and Lua function.
+        /// </summary>
+        /// <returns>The timing of each CLI member and Lua function, in order of decreasing total time.
+        ///     </returns>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.BoundaryTiming"/>
+        ///     flag was not specified at construction.</exception>
+        /// <remarks>
+        /// <para>CLI members are timed when they are invoked, gotten, or set from Lua (including operator
+        /// overloads); Lua functions are timed when they are called from the CLR, either directly or through a
+        /// delegate from <see cref="LuaFunctionBase.ToDelegate(Type)"/>.  Only calls that complete without an error
+        /// are counted.</para>
+        /// <para>Times are inclusive of nested calls.  The timing may be read while Lua code runs on other
+        /// threads.</para>
+        /// </remarks>
+        public BoundaryTimingStatistics[] GetBoundaryTimings()
+        {
+            if (_boundaryTiming == null)
+                throw new InvalidOperationException();
+            else
+                return _boundaryTiming.GetStatistics();
+        }
+
+        /// <summary>
+        /// Discards the timing of the calls between Lua and the CLR.
+        /// </summary>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.BoundaryTiming"/>
+        ///     flag was not specified at construction.</exception>
+        public void ResetBoundaryTimings()
+        {
+            if (_boundaryTiming == null)
+                throw new InvalidOperationException();
+            else
+                _boundaryTiming.Reset();
+        }
+
         /// <summary>
         /// Releases the unmanaged resources used by the <see cref="InstrumentedLuaBridge"/> and optionally
         /// releases the managed resources.
@@ -117,8 +353,19 @@ namespace LuaCLRBridge
 
             _disposed = true;
 
+            if (disposeManaged)
+                StopProfilingTimer();
+
             base.Dispose(disposeManaged);
 
+            if (disposeManaged)
+            {
+                DisposeProfiling();
+
+                if (_boundaryTiming != null)
+                    _boundaryTiming.Dispose();
+            }
+
             if (_allocTracker != null)
                 Debug.Assert(MemoryAllocatedSize == UIntPtr.Zero, "Allocated memory should be zero at disposal.");
         }
@@ -132,7 +379,7 @@ namespace LuaCLRBridge
         [SecuritySafeCritical]
         public void Cancel( string message )
         {
-            if (_interjector == null)
+            if (!_interruptible)
                 throw new InvalidOperationException();
             else
                 _interjector.Cancel(message, Encoding);
@@ -151,7 +398,7 @@ namespace LuaCLRBridge
         [SecuritySafeCritical]
         public void Interject( Interjection interjection )
         {
-            if (_interjector == null)
+            if (!_interruptible)
                 throw new InvalidOperationException();
             else
                 _interjector.Interject(( L ) => interjection(this));
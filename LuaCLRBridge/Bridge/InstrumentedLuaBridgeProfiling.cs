@@ -0,0 +1,216 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Generic;
+    using System.Security;
+    using System.Text;
+    using System.Threading;
+    using Lua;
+
+    public sealed partial class InstrumentedLuaBridge
+    {
+        /* A timer periodically requests a sample, which enables the hook of the Lua state; the hook captures the
+           call stack into a fixed ring of samples without allocating, and disables itself.  Between samples the
+           hook is disabled, so Lua runs at full speed.  Captured samples are drained into folded stacks (frames
+           from outermost to innermost, separated by semicolons) and counted. */
+
+        private const int _samplerCapacity = 256;
+
+        [SecurityCritical]
+        private LuaSampler _sampler;
+
+        /// <summary>
+        /// Whether the ring of samples has been freed, after the Lua state was closed.
+        /// </summary>
+        private bool _samplerClosed = false;
+
+        private Timer _samplingTimer;
+
+        /// <summary>
+        /// The number of samples of each folded stack.
+        /// </summary>
+        private readonly Dictionary<string, long> _profile = new Dictionary<string, long>(StringComparer.Ordinal);
+
+        [SecurityCritical]
+        private void InitializeProfiling()
+        {
+            var objectTranslator = _state._objectTranslator;
+
+            _sampler = new LuaSampler(_samplerCapacity, objectTranslator.ObjectMetatableRef, objectTranslator.GetCFunctionDelegate, Encoding);
+            _interjector.Sampler = _sampler;
+        }
+
+        /// <summary>
+        /// Starts sampling the call stack of the main thread of the Lua state.
+        /// </summary>
+        /// <param name="samplingInterval">The time between samples.</param>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.Profiling"/> flag
+        ///     was not specified at construction.</exception>
+        /// <exception cref="ArgumentOutOfRangeException">If <paramref name="samplingInterval"/> is not
+        ///     positive.</exception>
+        /// <remarks>
+        /// The resolution of the interval is that of the system timer.  Samples are only taken while Lua code
+        /// runs in the main thread.
+        /// </remarks>
+        [SecuritySafeCritical]
+        public void StartProfiling( TimeSpan samplingInterval )
+        {
+            if (_sampler == null)
+                throw new InvalidOperationException();
+            if (samplingInterval <= TimeSpan.Zero)
+                throw new ArgumentOutOfRangeException("samplingInterval");
+
+            StopProfilingTimer();
+
+            _samplingTimer = new Timer(RequestSample, null, samplingInterval, samplingInterval);
+        }
+
+        /// <summary>
+        /// Stops sampling the call stack of the main thread of the Lua state.
+        /// </summary>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.Profiling"/> flag
+        ///     was not specified at construction.</exception>
+        [SecuritySafeCritical]
+        public void StopProfiling()
+        {
+            if (_sampler == null)
+                throw new InvalidOperationException();
+
+            StopProfilingTimer();
+        }
+
+        /// <summary>
+        /// Gets the samples of the call stack of the main thread of the Lua state as folded stacks, the input
+        /// format of flame graph tools.
+        /// </summary>
+        /// <returns>A line for each distinct call stack: its frames from outermost to innermost separated by
+        ///     semicolons, a space, and the number of samples of the call stack.</returns>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.Profiling"/> flag
+        ///     was not specified at construction.</exception>
+        /// <remarks>
+        /// A Lua function is named by its name where it was called, its source, and the line where it is
+        /// defined; a CLR function by the method of its delegate.
+        /// </remarks>
+        [SecuritySafeCritical]
+        public string GetFoldedStacks()
+        {
+            if (_sampler == null)
+                throw new InvalidOperationException();
+
+            lock (_profile)
+            {
+                DrainSamples();
+
+                var stacks = new List<string>(_profile.Keys);
+                stacks.Sort(StringComparer.Ordinal);
+
+                var folded = new StringBuilder();
+
+                foreach (string stack in stacks)
+                    folded.Append(stack).Append(' ').Append(_profile[stack]).Append('\n');
+
+                return folded.ToString();
+            }
+        }
+
+        /// <summary>
+        /// Discards the samples of the call stack that have been taken.
+        /// </summary>
+        /// <exception cref="InvalidOperationException">If the <see cref="Instrumentations.Profiling"/> flag
+        ///     was not specified at construction.</exception>
+        [SecuritySafeCritical]
+        public void ClearProfile()
+        {
+            if (_sampler == null)
+                throw new InvalidOperationException();
+
+            lock (_profile)
+            {
+                DrainSamples();
+
+                _profile.Clear();
+            }
+        }
+
+        /// <summary>
+        /// Requests a sample from the hook, and drains the samples before the ring of samples fills.
+        /// </summary>
+        /// <param name="state">Not used.</param>
+        [SecuritySafeCritical]
+        private void RequestSample( object state )
+        {
+            _interjector.RequestSample();
+
+            if (_sampler.Count >= _sampler.Capacity / 2)
+            {
+                lock (_profile)
+                    DrainSamples();
+            }
+        }
+
+        /// <summary>
+        /// Counts the samples captured by the hook.
+        /// </summary>
+        /// <remarks>
+        /// The caller must hold the lock of <see cref="_profile"/>.
+        /// </remarks>
+        [SecurityCritical]
+        private void DrainSamples()
+        {
+            if (_samplerClosed)
+                return;
+
+            foreach (string stack in _sampler.Drain())
+            {
+                long count;
+                _profile.TryGetValue(stack, out count);
+                _profile[stack] = count + 1;
+            }
+        }
+
+        /// <summary>
+        /// Stops the sampling timer and waits for any request in progress, so that no request reaches a closed
+        /// Lua state.
+        /// </summary>
+        private void StopProfilingTimer()
+        {
+            if (_samplingTimer == null)
+                return;
+
+            using (var stopped = new ManualResetEvent(false))
+            {
+                if (_samplingTimer.Dispose(stopped))
+                    stopped.WaitOne();
+            }
+
+            _samplingTimer = null;
+        }
+
+        /// <summary>
+        /// Drains the last samples and frees the ring of samples once the Lua state is closed.
+        /// </summary>
+        [SecurityCritical]
+        private void DisposeProfiling()
+        {
+            if (_sampler == null)
+                return;
+
+            lock (_profile)
+            {
+                DrainSamples();
+
+                _sampler.Dispose();
+                _samplerClosed = true;
+            }
+        }
+    }
+}
@@ -23,9 +23,6 @@ namespace LuaCLRBridge
     /// </remarks>
     public abstract class LuaBase : MarshalByRefObject, IDisposable
     {
-        [SecurityCritical]
-        private static readonly int _refTable = LuaWrapper.LUA_REGISTRYINDEX;
-
         [SecurityCritical]
         private bool _disposed = false;
 
@@ -35,9 +32,19 @@ namespace LuaCLRBridge
         [SecurityCritical]
         internal readonly ObjectTranslator _objectTranslator;
 
+        /// <summary>
+        /// The slot of the Lua object in the table of references of the object translator.
+        /// </summary>
         [SecurityCritical]
         private readonly int _ref;
 
+        /// <summary>
+        /// The owner of the slot, which is shared with the other <see cref="LuaBase"/> objects of the Lua object
+        /// and kept alive by them.
+        /// </summary>
+        [SecurityCritical]
+        internal readonly ObjectTranslator.RefOwner _refOwner;
+
         [SuppressMessage("Microsoft.Performance", "CA1810:InitializeReferenceTypeStaticFieldsInline", Justification = "Security attribute.")]
         [SecuritySafeCritical]
         static LuaBase()
@@ -50,10 +57,7 @@ namespace LuaCLRBridge
         {
             _objectTranslator = objectTranslator;
 
-            ObjectTranslator.CheckStack(L, 1);
-
-            LuaWrapper.lua_pushvalue(L, index);
-            _ref = LuaWrapper.luaL_ref(L, _refTable);
+            _ref = objectTranslator.Ref(L, index, out _refOwner);
         }
 
         /// <summary>
@@ -100,11 +104,11 @@ namespace LuaCLRBridge
                         {
                             var L = lockedMainL._L;
 
-                            LuaWrapper.luaL_unref(L, _refTable, _ref);
+                            _objectTranslator.Unref(L, _ref);
                         }
                         else
                         {
-                            _objectTranslator.DeferUnref(_refTable, _ref);
+                            _objectTranslator.DeferUnref(_ref);
                         }
                     }
                 }
@@ -179,8 +183,7 @@ namespace LuaCLRBridge
 
                 ObjectTranslator.CheckStack(L, 3);  // stackCollector + luaToString + self
 
-                LuaWrapper.lua_pushinteger(L, LuaWrapper.luaW_countlevels(L));
-                LuaWrapper.lua_pushcclosure(L, _objectTranslator._stackCollector, 1);
+                _objectTranslator.PushStackCollector(L);
 
                 LuaWrapper.lua_pushcfunction(L, _objectTranslator._luaToString);
 
@@ -209,13 +212,6 @@ namespace LuaCLRBridge
             }
         }
 
-        [SecurityCritical]
-        internal bool IsSameReference( LuaBase that )
-        {
-            return this._objectTranslator == that._objectTranslator &&
-                this._ref == that._ref;
-        }
-
         /// <summary>
         /// Pushes the represented object onto the stack of a specified Lua state.
         /// </summary>
@@ -236,7 +232,7 @@ namespace LuaCLRBridge
             if (!_objectTranslator.HasSameMainState(L))
                 throw new ArgumentException("Cannot transfer Lua objects between different states");
 
-            LuaWrapper.lua_rawgeti(L, _refTable, _ref);
+            _objectTranslator.PushRef(L, _ref);
         }
     }
 }
@@ -10,6 +10,7 @@
 namespace LuaCLRBridge
 {
     using System;
+    using System.Collections.Concurrent;
     using System.Collections.Generic;
     using System.Diagnostics;
     using System.Globalization;
@@ -25,6 +26,14 @@ namespace LuaCLRBridge
     {
         public static readonly LuaBinder Instance = new LuaBinder();
 
+        /* Determining the applicable and better candidates of a method group is expensive (parameter reflection,
+           type inference, and pairwise comparison), but its outcome depends only on the method group, the runtime
+           types of the arguments, and -- for Lua numbers and functions, which may be coerced -- a classification
+           of the argument values.  The best candidates are cached by these so that repeated calls with arguments
+           of the same shape only change the argument types. */
+        private readonly ConcurrentDictionary<MethodBindingKey, CandidateMethod[]> _methodBindings =
+            new ConcurrentDictionary<MethodBindingKey, CandidateMethod[]>();
+
         private LuaBinder()
         {
             // nothing to do
@@ -127,13 +136,41 @@ namespace LuaCLRBridge
 
             state = null;  // this implementation does not reorder
 
-            List<CandidateMethod> candidates = new List<CandidateMethod>();
-
             Type[] argTypes = new Type[args.Length];
             for (int i = 0; i < args.Length; ++i)
                 if (args[i] != null)
                     argTypes[i] = args[i].GetType();
 
+            var key = new MethodBindingKey(match, argTypes, ClassifyArgumentValues(args, argTypes));
+
+            CandidateMethod[] candidates;
+            if (!_methodBindings.TryGetValue(key, out candidates))
+            {
+                candidates = DetermineBestCandidates(match, args, argTypes);
+                candidates = _methodBindings.GetOrAdd(key, candidates);
+            }
+
+            switch (candidates.Length)
+            {
+                case 0:
+                    throw new MissingMethodException();
+
+                case 1:
+                    CandidateMethod candidate = candidates[0];
+
+                    ChangeArgumentTypes(candidate.Method, candidate.Parameters, candidate.ParamArrayType, ref args, argTypes);
+
+                    return candidate.Method;
+
+                default:
+                    throw new AmbiguousMatchException();
+            }
+        }
+
+        private static CandidateMethod[] DetermineBestCandidates( MethodBase[] match, object[] args, Type[] argTypes )
+        {
+            List<CandidateMethod> candidates = new List<CandidateMethod>();
+
             #region Determine applicable methods
 
             for (int mi = 0; mi < match.Length; ++mi)
@@ -288,21 +325,7 @@ namespace LuaCLRBridge
 
             #endregion
 
-            switch (candidates.Count)
-            {
-                case 0:
-                    throw new MissingMethodException();
-
-                case 1:
-                    CandidateMethod candidate = candidates[0];
-
-                    ChangeArgumentTypes(candidate.Method, candidate.Parameters, candidate.ParamArrayType, ref args, argTypes);
-
-                    return candidate.Method;
-
-                default:
-                    throw new AmbiguousMatchException();
-            }
+            return candidates.ToArray();
         }
 
         public override object ChangeType( object value, Type type, CultureInfo culture )
@@ -782,8 +805,84 @@ namespace LuaCLRBridge
             return null;
         }
 
+        /// <summary>
+        /// Classifies the argument values whose applicability to a parameter depends on more than their type.
+        /// </summary>
+        /// <param name="args">The arguments.</param>
+        /// <param name="argTypes">The types of the arguments.</param>
+        /// <returns>The classes of the arguments; or <c>null</c> if no argument value needs to be classified.
+        ///     </returns>
+        private static int[] ClassifyArgumentValues( object[] args, Type[] argTypes )
+        {
+            int[] argClasses = null;
+
+            for (int i = 0; i < args.Length; ++i)
+            {
+                int argClass;
+
+                if (argTypes[i] == typeof(double))
+                    argClass = ClassifyLuaNumeric((double)args[i]);
+                else if (argTypes[i] == typeof(LuaFunction))
+                    argClass = ClassifyLuaFunction(args[i] as LuaFunction);
+                else
+                    continue;
+
+                if (argClasses == null)
+                    argClasses = new int[args.Length];
+
+                argClasses[i] = argClass;
+            }
+
+            return argClasses;
+        }
+
+        // must agree with CanCoerceLuaFunction
+        private static int ClassifyLuaFunction( LuaFunction value )
+        {
+            Delegate delegateValue = value.AsDelegate();
+            Type delegateType = delegateValue == null ? null : delegateValue.GetType();
+
+            return
+                delegateType == typeof(LuaCFunction) ? 1 :
+                delegateType == typeof(LuaSafeCFunction) ? 2 :
+                0;
+        }
+
+        // must agree with CanCoerceLuaNumeric; one bit per numeric type to which the value can be coerced
+        private static int ClassifyLuaNumeric( double value )
+        {
+            int numericClass = 0;
+
+            if (Math.Abs(value) <= Single.MaxValue || Double.IsInfinity(value) || Double.IsNaN(value))
+                numericClass |= 1 << 0;
+
+            if (value % 1 == 0)
+            {
+                if (value >= Int64.MinValue && value <= Int64.MaxValue)
+                    numericClass |= 1 << 1;
+                if (value >= UInt64.MinValue && value <= UInt64.MaxValue)
+                    numericClass |= 1 << 2;
+                if (value >= Int32.MinValue && value <= Int32.MaxValue)
+                    numericClass |= 1 << 3;
+                if (value >= UInt32.MinValue && value <= UInt32.MaxValue)
+                    numericClass |= 1 << 4;
+                if (value >= Int16.MinValue && value <= Int16.MaxValue)
+                    numericClass |= 1 << 5;
+                if (value >= UInt16.MinValue && value <= UInt16.MaxValue)
+                    numericClass |= 1 << 6;
+                if (value >= SByte.MinValue && value <= SByte.MaxValue)
+                    numericClass |= 1 << 7;
+                if (value >= Byte.MinValue && value <= Byte.MaxValue)
+                    numericClass |= 1 << 8;
+                if (value >= Char.MinValue && value <= Char.MaxValue)
+                    numericClass |= 1 << 9;
+            }
+
+            return numericClass;
+        }
+
         // deviation from C# implicit conversion
-        private static bool CanCoerceLuaNumeric( double value, Type targetType )
+        internal static bool CanCoerceLuaNumeric( double value, Type targetType )
         {
             if (!targetType.IsPrimitive && targetType.IsNullable())
                 targetType = Nullable.GetUnderlyingType(targetType);
@@ -1304,6 +1403,74 @@ namespace LuaCLRBridge
             public Type ParamArrayType;
         }
 
+        /// <summary>
+        /// Identifies the binding of a method group to arguments of a particular shape.
+        /// </summary>
+        private struct MethodBindingKey : IEquatable<MethodBindingKey>
+        {
+            private readonly MethodBase[] _match;
+            private readonly Type[] _argTypes;
+            private readonly int[] _argClasses;
+            private readonly int _hashCode;
+
+            public MethodBindingKey( MethodBase[] match, Type[] argTypes, int[] argClasses )
+            {
+                this._match = match;
+                this._argTypes = argTypes;
+                this._argClasses = argClasses;
+
+                int hash = argTypes.Length;
+
+                foreach (MethodBase method in match)
+                    hash = hash * 31 + method.GetHashCode();
+
+                foreach (Type argType in argTypes)
+                    hash = hash * 31 + (argType == null ? 0 : argType.GetHashCode());
+
+                if (argClasses != null)
+                    foreach (int argClass in argClasses)
+                        hash = hash * 31 + argClass;
+
+                this._hashCode = hash;
+            }
+
+            public bool Equals( MethodBindingKey other )
+            {
+                if (_hashCode != other._hashCode ||
+                    _match.Length != other._match.Length ||
+                    _argTypes.Length != other._argTypes.Length ||
+                    (_argClasses == null) != (other._argClasses == null))
+                {
+                    return false;
+                }
+
+                for (int i = 0; i < _match.Length; ++i)
+                    if (!_match[i].Equals(other._match[i]))
+                        return false;
+
+                for (int i = 0; i < _argTypes.Length; ++i)
+                    if (_argTypes[i] != other._argTypes[i])
+                        return false;
+
+                if (_argClasses != null)
+                    for (int i = 0; i < _argClasses.Length; ++i)
+                        if (_argClasses[i] != other._argClasses[i])
+                            return false;
+
+                return true;
+            }
+
+            public override bool Equals( object obj )
+            {
+                return obj is MethodBindingKey && Equals((MethodBindingKey)obj);
+            }
+
+            public override int GetHashCode()
+            {
+                return _hashCode;
+            }
+        }
+
         private static class TypeInferer
         {
             private enum Bound
@@ -14,6 +14,7 @@ namespace LuaCLRBridge
     using System.Diagnostics;
     using System.Diagnostics.CodeAnalysis;
     using System.IO;
+    using System.IO.MemoryMappedFiles;
     using System.Runtime.InteropServices;
     using System.Security;
     using System.Text;
@@ -22,7 +23,7 @@ namespace LuaCLRBridge
     /// <summary>
     /// Represents a thread of a Lua state.
     /// </summary>
-    public abstract class LuaBridgeBase : MarshalByRefObject, IDisposable
+    public abstract partial class LuaBridgeBase : MarshalByRefObject, IDisposable
     {
         [SecurityCritical]
         private static readonly Dictionary<string, IntPtr> _libs = new Dictionary<string, IntPtr>
@@ -211,6 +212,28 @@ namespace LuaCLRBridge
             _disposed = true;
         }
 
+        /// <summary>
+        /// Gets or sets the cache of compiled text chunks used by <see cref="Load(string, string)"/> and
+        /// <see cref="Do"/>, or <c>null</c> to compile every text chunk.
+        /// </summary>
+        /// <remarks>
+        /// The cache is shared by all threads of the Lua state, and may be shared with other Lua states.
+        /// </remarks>
+        public LuaChunkCache ChunkCache
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                return _state._objectTranslator._chunkCache;
+            }
+
+            [SecuritySafeCritical]
+            set
+            {
+                _state._objectTranslator._chunkCache = value;
+            }
+        }
+
         /// <summary>
         /// Executes a Lua text chunk.
         /// </summary>
@@ -241,8 +264,13 @@ namespace LuaCLRBridge
             {
                 var L = lockedL._L;
                 var objectTranslator = lockedL._objectTranslator;
+                var chunkCache = objectTranslator._chunkCache;
+
+                LuaStatus status = chunkCache != null ?
+                    chunkCache.Load(L, buff, name, Encoding) :
+                    LuaWrapper.luaW_loadbufferx(L, buff, name, "t", Encoding, Encoding);
 
-                if (LuaWrapper.luaW_loadbufferx(L, buff, name, "t", Encoding, Encoding) != LuaStatus.LUA_OK)
+                if (status != LuaStatus.LUA_OK)
                 {
                     object error = objectTranslator.PopObject(L);
                     Debug.Assert(!(error is Exception), "Loading Lua script string should only produce Lua error.");
@@ -291,6 +319,87 @@ namespace LuaCLRBridge
             }
         }
 
+        /// <summary>
+        /// Loads a Lua chunk from native memory, reading it in place as a single block.
+        /// </summary>
+        /// <param name="buff">The address of the Lua chunk.</param>
+        /// <param name="length">The length in bytes of the Lua chunk.</param>
+        /// <param name="name">The name of the chunk (used in error messages).</param>
+        /// <param name="mode">The acceptable chunk formats ("t" for text, "b" for binary, or "bt" for
+        ///     either).</param>
+        /// <returns>The Lua function that will execute the chunk.</returns>
+        /// <exception cref="ArgumentNullException">If <paramref name="buff"/> is zero and
+        ///     <paramref name="length"/> is not.</exception>
+        /// <exception cref="ArgumentOutOfRangeException">If <paramref name="length"/> is negative.
+        ///     </exception>
+        /// <exception cref="LuaCompilerException">If there was a Lua error while compiling the chunk.
+        ///     </exception>
+        /// <remarks>
+        /// The memory must remain valid until this method returns; the Lua function does not refer to it.
+        /// </remarks>
+        [SecurityCritical]
+        public LuaFunction Load( IntPtr buff, long length, string name = "<memory>", string mode = "bt" )
+        {
+            if (buff == IntPtr.Zero && length != 0)
+                throw new ArgumentNullException("buff");
+            if (length < 0)
+                throw new ArgumentOutOfRangeException("length");
+
+            using (var lockedL = LockedState)
+            {
+                var L = lockedL._L;
+                var objectTranslator = lockedL._objectTranslator;
+
+                if (LuaWrapper.luaW_loadbufferx(L, buff, new UIntPtr((ulong)length), name, mode, Encoding) != LuaStatus.LUA_OK)
+                {
+                    object error = objectTranslator.PopObject(L);
+                    Debug.Assert(!(error is Exception), "Loading Lua chunk should only produce Lua error.");
+                    throw new LuaCompilerException(error.ToString());
+                }
+
+                LuaFunction f = new LuaFunction(objectTranslator, L, -1);
+                LuaWrapper.lua_pop(L, 1);
+
+                return f;
+            }
+        }
+
+        /// <summary>
+        /// Loads a Lua chunk from a file by mapping the file into memory.
+        /// </summary>
+        /// <param name="path">The path of the file.</param>
+        /// <param name="name">The name of the chunk (used in error messages), or <c>null</c> for "@"
+        ///     followed by <paramref name="path"/>.</param>
+        /// <param name="mode">The acceptable chunk formats ("t" for text, "b" for binary, or "bt" for
+        ///     either).</param>
+        /// <returns>The Lua function that will execute the chunk.</returns>
+        /// <exception cref="ArgumentNullException">If <paramref name="path"/> is <c>null</c>.</exception>
+        /// <exception cref="LuaCompilerException">If there was a Lua error while compiling the chunk.
+        ///     </exception>
+        /// <remarks>
+        /// The file is not copied into a managed buffer or translated into a <see cref="String"/>; Lua reads
+        /// the mapped file directly.  Unlike luaL_loadfile, a first line that starts with '#' is not skipped.
+        /// </remarks>
+        [SecuritySafeCritical]
+        public LuaFunction LoadFile( string path, string name = null, string mode = "bt" )
+        {
+            if (path == null)
+                throw new ArgumentNullException("path");
+
+            if (name == null)
+                name = "@" + path;
+
+            long length = new FileInfo(path).Length;
+
+            // an empty file cannot be mapped
+            if (length == 0)
+                return Load(IntPtr.Zero, 0, name, mode);
+
+            using (var file = MemoryMappedFile.CreateFromFile(path, FileMode.Open, null, 0, MemoryMappedFileAccess.Read))
+            using (var view = file.CreateViewAccessor(0, length, MemoryMappedFileAccess.Read))
+                return Load(view.SafeMemoryMappedViewHandle.DangerousGetHandle(), length, name, mode);
+        }
+
         /// <summary>
         /// Loads a Lua built-in library.
         /// </summary>
@@ -376,20 +485,6 @@ namespace LuaCLRBridge
 
         #endregion
 
-        /// <summary>
-        /// Performs a full garbage-collection cycle.
-        /// </summary>
-        [SecuritySafeCritical]
-        public void CollectGarbage()
-        {
-            using (var lockedL = LockedState)
-            {
-                var L = lockedL._L;
-
-                LuaWrapper.lua_gc(L, LuaGCOption.LUA_GCCOLLECT, 0);
-            }
-        }
-
         /// <summary>
         /// Pushes a specified CLI object onto the stack of a specified Lua state.
         /// </summary>
@@ -0,0 +1,470 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Diagnostics;
+    using System.Security;
+    using Lua;
+
+    /// <summary>
+    /// Specifies the mode of the Lua garbage collector.
+    /// </summary>
+    public enum GarbageCollectorMode
+    {
+        /// <summary>Each cycle traverses all objects, in steps interleaved with the program.</summary>
+        Incremental,
+
+        /// <summary>Each cycle traverses only the objects created since the last cycle, with an occasional
+        /// full cycle when memory grows past <see cref="LuaBridgeBase.GarbageCollectorMajorIncrement"/>.
+        /// </summary>
+        Generational,
+    }
+
+    public abstract partial class LuaBridgeBase
+    {
+        /// <summary>
+        /// Performs a full garbage-collection cycle.
+        /// </summary>
+        [SecuritySafeCritical]
+        public void CollectGarbage()
+        {
+            using (var lockedL = LockedState)
+            {
+                var L = lockedL._L;
+
+                LuaWrapper.lua_gc(L, LuaGCOption.LUA_GCCOLLECT, 0);
+            }
+        }
+
+        /// <summary>
+        /// Performs a step of garbage collection.
+        /// </summary>
+        /// <param name="budgetKB">The amount of work of the step, as if this many kilobytes had been
+        ///     allocated; or 0 for the smallest step.</param>
+        /// <returns><c>true</c> if the step finished a garbage-collection cycle (as every step does in
+        ///     generational mode); otherwise, <c>false</c>.</returns>
+        /// <exception cref="ArgumentOutOfRangeException">If <paramref name="budgetKB"/> is negative.
+        ///     </exception>
+        [SecuritySafeCritical]
+        public bool StepGarbage( int budgetKB )
+        {
+            if (budgetKB < 0)
+                throw new ArgumentOutOfRangeException("budgetKB");
+
+            using (var lockedL = LockedState)
+            {
+                var L = lockedL._L;
+
+                int finished = LuaWrapper.lua_gc(L, LuaGCOption.LUA_GCSTEP, budgetKB);
+
+                // in generational mode, a step is a whole (minor or major) collection
+                return LuaWrapper.luaW_isgenerational(L) || finished != 0;
+            }
+        }
+
+        /// <summary>
+        /// Performs the smallest steps of garbage collection until a deadline passes or a garbage-collection
+        /// cycle finishes, so that idle time is spent collecting instead of pausing for full collections.
+        /// </summary>
+        /// <param name="deadline">The time by which to stop stepping.</param>
+        /// <returns><c>true</c> if a garbage-collection cycle finished; otherwise, <c>false</c>.</returns>
+        /// <remarks>
+        /// The Lua state is unlocked between steps, so that other threads are not kept waiting past a step.
+        /// A step may overrun the deadline by the time of the step.
+        /// </remarks>
+        public bool StepGarbageUntil( DateTime deadline )
+        {
+            TimeSpan remaining = deadline.ToUniversalTime() - DateTime.UtcNow;
+
+            if (remaining <= TimeSpan.Zero)
+                return false;
+
+            var watch = Stopwatch.StartNew();
+
+            do
+            {
+                if (StepGarbage(0))
+                    return true;
+            }
+            while (watch.Elapsed < remaining);
+
+            return false;
+        }
+
+        /// <summary>
+        /// Stops the garbage collector, which then runs only when explicitly collecting or stepping.
+        /// </summary>
+        [SecuritySafeCritical]
+        public void StopGarbageCollector()
+        {
+            using (var lockedL = LockedState)
+            {
+                var L = lockedL._L;
+
+                LuaWrapper.lua_gc(L, LuaGCOption.LUA_GCSTOP, 0);
+            }
+        }
+
+        /// <summary>
+        /// Restarts the garbage collector after <see cref="StopGarbageCollector"/>.
+        /// </summary>
+        [SecuritySafeCritical]
+        public void RestartGarbageCollector()
+        {
+            using (var lockedL = LockedState)
+            {
+                var L = lockedL._L;
+
+                LuaWrapper.lua_gc(L, LuaGCOption.LUA_GCRESTART, 0);
+            }
+        }
+
+        /// <summary>
+        /// Gets whether the garbage collector is running (i.e., not stopped).
+        /// </summary>
+        public bool IsGarbageCollectorRunning
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    var L = lockedL._L;
+
+                    return LuaWrapper.lua_gc(L, LuaGCOption.LUA_GCISRUNNING, 0) != 0;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets or sets the mode of the garbage collector.
+        /// </summary>
+        /// <exception cref="ArgumentOutOfRangeException">If the value set is not a mode.</exception>
+        public GarbageCollectorMode GarbageCollectorMode
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    var L = lockedL._L;
+
+                    return LuaWrapper.luaW_isgenerational(L) ? GarbageCollectorMode.Generational : GarbageCollectorMode.Incremental;
+                }
+            }
+
+            [SecuritySafeCritical]
+            set
+            {
+                LuaGCOption option;
+
+                switch (value)
+                {
+                    case GarbageCollectorMode.Incremental:
+                        option = LuaGCOption.LUA_GCINC;
+                        break;
+                    case GarbageCollectorMode.Generational:
+                        option = LuaGCOption.LUA_GCGEN;
+                        break;
+                    default:
+                        throw new ArgumentOutOfRangeException("value");
+                }
+
+                using (var lockedL = LockedState)
+                {
+                    var L = lockedL._L;
+
+                    LuaWrapper.lua_gc(L, option, 0);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets or sets how long the garbage collector waits before starting a new cycle, as a percentage of
+        /// the memory in use after the last cycle (e.g., 200 waits for memory to double).
+        /// </summary>
+        /// <exception cref="ArgumentOutOfRangeException">If the value set is negative.</exception>
+        public int GarbageCollectorPause
+        {
+            get { return GetGarbageCollectorParameter(LuaGCOption.LUA_GCSETPAUSE); }
+            set { SetGarbageCollectorParameter(LuaGCOption.LUA_GCSETPAUSE, value); }
+        }
+
+        /// <summary>
+        /// Gets or sets the speed of the incremental garbage collector relative to allocation, as a
+        /// percentage (e.g., 200 collects twice as fast as memory is allocated).
+        /// </summary>
+        /// <exception cref="ArgumentOutOfRangeException">If the value set is negative.</exception>
+        public int GarbageCollectorStepMultiplier
+        {
+            get { return GetGarbageCollectorParameter(LuaGCOption.LUA_GCSETSTEPMUL); }
+            set { SetGarbageCollectorParameter(LuaGCOption.LUA_GCSETSTEPMUL, value); }
+        }
+
+        /// <summary>
+        /// Gets or sets how much memory must grow, as a percentage of the memory in use after the last full
+        /// cycle, before the generational garbage collector performs a full cycle.
+        /// </summary>
+        /// <exception cref="ArgumentOutOfRangeException">If the value set is negative.</exception>
+        public int GarbageCollectorMajorIncrement
+        {
+            get { return GetGarbageCollectorParameter(LuaGCOption.LUA_GCSETMAJORINC); }
+            set { SetGarbageCollectorParameter(LuaGCOption.LUA_GCSETMAJORINC, value); }
+        }
+
+        /// <summary>
+        /// Breaks cycles of references between CLI objects referenced by the Lua state and Lua objects
+        /// referenced by the CLR (e.g., a CLI object that holds a <see cref="LuaFunction"/> whose closure
+        /// holds the CLI object), which neither garbage collector can collect on its own.
+        /// </summary>
+        /// <returns>The number of CLI objects released by the Lua state.</returns>
+        /// <remarks>
+        /// <para>This locks the Lua state for a full, blocking CLR garbage collection.  The CLI objects of a
+        /// broken cycle are collected by it; the Lua objects of the cycle are collected by later Lua garbage
+        /// collection, once the finalizers of the <see cref="LuaBase"/> objects of the cycle have run.</para>
+        /// <para>A Lua object referenced by a <see cref="LuaBase"/> that is being finalized must not be used by
+        /// another finalizer.</para>
+        /// </remarks>
+        [SecuritySafeCritical]
+        public int CollectCrossHeapCycles()
+        {
+            using (var lockedL = LockedState)
+            {
+                return _state._objectTranslator.CollectCrossHeapCycles();
+            }
+        }
+
+        /// <summary>
+        /// Gets or sets the number of CLI objects referenced by the Lua state at which
+        /// <see cref="CollectCrossHeapCycles"/> runs automatically when the Lua state is next unlocked; or 0
+        /// (the default) if it does not.
+        /// </summary>
+        /// <exception cref="ArgumentOutOfRangeException">If the value set is negative.</exception>
+        /// <remarks>
+        /// After each collection, the next one runs once the number of CLI objects is the greater of the
+        /// threshold and twice the number that survived.
+        /// </remarks>
+        public int CrossHeapCollectionThreshold
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    return _state._objectTranslator.CrossHeapCollectionThreshold;
+                }
+            }
+
+            [SecuritySafeCritical]
+            set
+            {
+                if (value < 0)
+                    throw new ArgumentOutOfRangeException("value");
+
+                using (var lockedL = LockedState)
+                {
+                    _state._objectTranslator.CrossHeapCollectionThreshold = value;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the number of CLI objects referenced by the Lua state, including those released by
+        /// <see cref="CollectCrossHeapCycles"/> whose userdata Lua has not yet collected.
+        /// </summary>
+        public int CLIObjectCount
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    return _state._objectTranslator.ObjectCount;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Unreferences Lua objects whose <see cref="LuaBase"/> objects were released (usually by their
+        /// finalizers) while the Lua state was in use, so that the Lua garbage collector may collect them.
+        /// </summary>
+        /// <param name="maxCount">The most Lua objects to unreference.</param>
+        /// <returns>The number of Lua objects unreferenced.</returns>
+        /// <exception cref="ArgumentOutOfRangeException">If <paramref name="maxCount"/> is negative.
+        ///     </exception>
+        /// <remarks>
+        /// This is a maintenance call for when <see cref="DeferredUnrefBudget"/> is too small to keep up, e.g.,
+        /// during idle time.  The Lua objects are unreferenced in batches of one native call each.
+        /// </remarks>
+        [SecuritySafeCritical]
+        public int DrainDeferredUnrefs( int maxCount )
+        {
+            if (maxCount < 0)
+                throw new ArgumentOutOfRangeException("maxCount");
+
+            using (var lockedL = LockedState)
+            {
+                return _state._objectTranslator.DrainDeferredUnrefs(maxCount);
+            }
+        }
+
+        /// <summary>
+        /// Gets or sets the most Lua objects waiting to be unreferenced (see <see cref="DrainDeferredUnrefs"/>)
+        /// that are unreferenced each time the Lua state is unlocked, or 0 if they are unreferenced only by
+        /// <see cref="DrainDeferredUnrefs"/>.
+        /// </summary>
+        /// <exception cref="ArgumentOutOfRangeException">If the value set is negative.</exception>
+        /// <remarks>
+        /// The budget bounds the pause of the thread that unlocks the Lua state after a burst of finalizers.
+        /// </remarks>
+        public int DeferredUnrefBudget
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    return _state._objectTranslator.DeferredUnrefBudget;
+                }
+            }
+
+            [SecuritySafeCritical]
+            set
+            {
+                if (value < 0)
+                    throw new ArgumentOutOfRangeException("value");
+
+                using (var lockedL = LockedState)
+                {
+                    _state._objectTranslator.DeferredUnrefBudget = value;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the number of Lua objects waiting to be unreferenced (see <see cref="DrainDeferredUnrefs"/>).
+        /// </summary>
+        /// <remarks>
+        /// This may be read while the Lua state is in use on other threads.
+        /// </remarks>
+        public int DeferredUnrefCount
+        {
+            [SecuritySafeCritical]
+            get { return _state._objectTranslator.DeferredUnrefCount; }
+        }
+
+        /// <summary>
+        /// Gets the most Lua objects that have been waiting to be unreferenced at once.
+        /// </summary>
+        /// <remarks>
+        /// This may be read while the Lua state is in use on other threads.
+        /// </remarks>
+        public int PeakDeferredUnrefCount
+        {
+            [SecuritySafeCritical]
+            get { return _state._objectTranslator.PeakDeferredUnrefCount; }
+        }
+
+        /// <summary>
+        /// Gets the number of Lua objects that have waited to be unreferenced.
+        /// </summary>
+        /// <remarks>
+        /// This may be read while the Lua state is in use on other threads.
+        /// </remarks>
+        public long TotalDeferredUnrefCount
+        {
+            [SecuritySafeCritical]
+            get { return _state._objectTranslator.TotalDeferredUnrefCount; }
+        }
+
+        /// <summary>
+        /// Gets the number of <see cref="LuaBase"/> objects that reference Lua objects and have not been
+        /// released (by being disposed or finalized).
+        /// </summary>
+        /// <remarks>
+        /// A count that keeps growing points to <see cref="LuaBase"/> objects that are leaked.  Objects
+        /// released while the Lua state was in use are counted until they are unreferenced (see
+        /// <see cref="DeferredUnrefCount"/>).
+        /// </remarks>
+        public int LuaReferenceCount
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    return _state._objectTranslator.RefCount;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the number of distinct Lua objects referenced by <see cref="LuaBase"/> objects, which share the
+        /// reference to the same Lua object.
+        /// </summary>
+        public int ReferencedLuaObjectCount
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    return _state._objectTranslator.RefSlotCount;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the number of Lua objects that may be referenced by <see cref="LuaBase"/> objects before the
+        /// table of references grows.
+        /// </summary>
+        public int LuaReferenceCapacity
+        {
+            [SecuritySafeCritical]
+            get
+            {
+                using (var lockedL = LockedState)
+                {
+                    return _state._objectTranslator.RefCapacity;
+                }
+            }
+        }
+
+        [SecuritySafeCritical]
+        private int GetGarbageCollectorParameter( LuaGCOption option )
+        {
+            using (var lockedL = LockedState)
+            {
+                var L = lockedL._L;
+
+                // lua_gc only reports a parameter while setting it, so it is restored at once
+                int value = LuaWrapper.lua_gc(L, option, 0);
+                LuaWrapper.lua_gc(L, option, value);
+
+                return value;
+            }
+        }
+
+        [SecuritySafeCritical]
+        private void SetGarbageCollectorParameter( LuaGCOption option, int value )
+        {
+            if (value < 0)
+                throw new ArgumentOutOfRangeException("value");
+
+            using (var lockedL = LockedState)
+            {
+                var L = lockedL._L;
+
+                LuaWrapper.lua_gc(L, option, value);
+            }
+        }
+    }
+}
@@ -0,0 +1,57 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Threading;
+
+    /// <summary>
+    /// Represents the use of a Lua state of a <see cref="LuaBridgePool"/> by one thread.
+    /// </summary>
+    public sealed class LuaBridgeLease : IDisposable
+    {
+        private readonly LuaBridgePool _pool;
+
+        private readonly int _index;
+
+        private int _released = 0;
+
+        internal LuaBridgeLease( LuaBridgePool pool, int index )
+        {
+            this._pool = pool;
+            this._index = index;
+        }
+
+        /// <summary>
+        /// Gets the leased Lua state.
+        /// </summary>
+        /// <exception cref="ObjectDisposedException">The <see cref="LuaBridgeLease"/> has been disposed.
+        ///     </exception>
+        public LuaBridge Bridge
+        {
+            get
+            {
+                if (_released != 0)
+                    throw new ObjectDisposedException(GetType().FullName);
+
+                return _pool.GetBridge(_index);
+            }
+        }
+
+        /// <summary>
+        /// Returns the leased Lua state to the pool.
+        /// </summary>
+        public void Dispose()
+        {
+            if (Interlocked.Exchange(ref _released, 1) == 0)
+                _pool.Release(_index);
+        }
+    }
+}
@@ -0,0 +1,264 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Threading;
+
+    /// <summary>
+    /// Represents a fixed number of independent Lua states that are leased to one thread at a time.
+    /// </summary>
+    /// <remarks>
+    /// <para>Each Lua state is locked while any thread uses it, so a single <see cref="LuaBridge"/> runs Lua
+    /// code on only one thread at a time.  A <see cref="LuaBridgePool"/> owns several Lua states, each with
+    /// its own objects and lock, so that as many threads as there are Lua states run Lua code
+    /// concurrently.</para>
+    /// <para>Every Lua state is initialized identically (e.g., by loading the same chunks and setting the
+    /// same globals) when the pool is created.  Lua objects must not be transferred between the Lua states
+    /// of a pool.</para>
+    /// <para>A thread is leased the Lua state that it last leased if that is not leased, so that it tends to
+    /// find the objects of the Lua state still in the cache of its core; otherwise, it takes the next Lua state
+    /// that is not leased.</para>
+    /// </remarks>
+    public sealed class LuaBridgePool : IDisposable
+    {
+        private volatile bool _disposed = false;
+
+        private readonly LuaBridge[] _bridges;
+
+        /// <summary>
+        /// For each Lua state, 1 if it is leased; otherwise, 0.
+        /// </summary>
+        private readonly int[] _leased;
+
+        /// <summary>
+        /// Counts the Lua states that are not leased.
+        /// </summary>
+        private readonly SemaphoreSlim _available;
+
+        /// <summary>
+        /// Canceled when the pool is disposed, to wake the threads waiting in <see cref="Acquire"/>.
+        /// </summary>
+        private readonly CancellationTokenSource _disposing = new CancellationTokenSource();
+
+        /// <summary>
+        /// The number of threads waiting in <see cref="Acquire"/>, which must leave before
+        /// <see cref="_available"/> is disposed.
+        /// </summary>
+        private int _waiting = 0;
+
+        /// <summary>
+        /// The index of the Lua state that the current thread last leased.
+        /// </summary>
+        private readonly ThreadLocal<int> _lastLeased;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LuaBridgePool"/> class with new Lua states.
+        /// </summary>
+        /// <param name="size">The number of Lua states.</param>
+        /// <param name="initialize">The action that initializes each Lua state, or <c>null</c>.</param>
+        /// <exception cref="ArgumentOutOfRangeException">If <paramref name="size"/> is not positive.
+        ///     </exception>
+        public LuaBridgePool( int size, Action<LuaBridge> initialize )
+            : this(size, () => new LuaBridge(), initialize)
+        {
+        }
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LuaBridgePool"/> class with Lua states created by a
+        /// specified function.
+        /// </summary>
+        /// <param name="size">The number of Lua states.</param>
+        /// <param name="createBridge">The function that creates each Lua state.</param>
+        /// <param name="initialize">The action that initializes each Lua state, or <c>null</c>.</param>
+        /// <exception cref="ArgumentOutOfRangeException">If <paramref name="size"/> is not positive.
+        ///     </exception>
+        /// <exception cref="ArgumentNullException">If <paramref name="createBridge"/> is <c>null</c>.
+        ///     </exception>
+        public LuaBridgePool( int size, Func<LuaBridge> createBridge, Action<LuaBridge> initialize )
+        {
+            if (size <= 0)
+                throw new ArgumentOutOfRangeException("size");
+            if (createBridge == null)
+                throw new ArgumentNullException("createBridge");
+
+            _bridges = new LuaBridge[size];
+            _leased = new int[size];
+
+            try
+            {
+                for (int i = 0; i < size; ++i)
+                {
+                    _bridges[i] = createBridge();
+
+                    if (initialize != null)
+                        initialize(_bridges[i]);
+                }
+            }
+            catch
+            {
+                foreach (LuaBridge bridge in _bridges)
+                    if (bridge != null)
+                        bridge.Dispose();
+
+                throw;
+            }
+
+            _available = new SemaphoreSlim(size, size);
+
+            // threads first lease distinct Lua states so that concurrent leases seldom contend
+            _lastLeased = new ThreadLocal<int>(() => Thread.CurrentThread.ManagedThreadId % size);
+        }
+
+        /// <summary>
+        /// Gets the number of Lua states in the pool.
+        /// </summary>
+        public int Size
+        {
+            get { return _bridges.Length; }
+        }
+
+        /// <summary>
+        /// Leases a Lua state from the pool, waiting until one is not leased.
+        /// </summary>
+        /// <returns>The lease, which must be disposed to return the Lua state to the pool.</returns>
+        /// <exception cref="ObjectDisposedException">The <see cref="LuaBridgePool"/> has been disposed.
+        ///     </exception>
+        public LuaBridgeLease Acquire()
+        {
+            if (_disposed)
+                throw new ObjectDisposedException(GetType().FullName);
+
+            Interlocked.Increment(ref _waiting);
+            try
+            {
+                _available.Wait(_disposing.Token);
+            }
+            catch (OperationCanceledException)
+            {
+                throw new ObjectDisposedException(GetType().FullName);
+            }
+            finally
+            {
+                Interlocked.Decrement(ref _waiting);
+            }
+
+            // the pool may have been disposed while this thread waited
+            if (_disposed)
+                throw new ObjectDisposedException(GetType().FullName);
+
+            return new LuaBridgeLease(this, TakeBridge());
+        }
+
+        /// <summary>
+        /// Leases a Lua state from the pool if one is not leased.
+        /// </summary>
+        /// <param name="lease">The lease, which must be disposed to return the Lua state to the pool; or
+        ///     <c>null</c> if every Lua state is leased.</param>
+        /// <returns><c>true</c> if a Lua state was leased; otherwise, <c>false</c>.</returns>
+        /// <exception cref="ObjectDisposedException">The <see cref="LuaBridgePool"/> has been disposed.
+        ///     </exception>
+        public bool TryAcquire( out LuaBridgeLease lease )
+        {
+            if (_disposed)
+                throw new ObjectDisposedException(GetType().FullName);
+
+            if (!_available.Wait(0))
+            {
+                lease = null;
+                return false;
+            }
+
+            if (_disposed)
+                throw new ObjectDisposedException(GetType().FullName);
+
+            lease = new LuaBridgeLease(this, TakeBridge());
+            return true;
+        }
+
+        /// <summary>
+        /// Marks a Lua state as leased, preferring the one that the current thread last leased.
+        /// </summary>
+        /// <returns>The index of the Lua state.</returns>
+        /// <remarks>
+        /// The caller must have already decremented <see cref="_available"/>, so some Lua state is not leased.
+        /// </remarks>
+        private int TakeBridge()
+        {
+            int size = _bridges.Length;
+
+            int first = _lastLeased.Value;
+
+            for (int i = first; ; i = (i + 1) % size)
+            {
+                if (Interlocked.CompareExchange(ref _leased[i], 1, 0) == 0)
+                {
+                    _lastLeased.Value = i;
+                    return i;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Returns a leased Lua state to the pool.
+        /// </summary>
+        /// <param name="index">The index of the Lua state.</param>
+        internal void Release( int index )
+        {
+            Interlocked.Exchange(ref _leased[index], 0);
+
+            if (_disposed)
+                return;
+
+            try
+            {
+                _available.Release();
+            }
+            catch (ObjectDisposedException)
+            {
+                // the pool was disposed meanwhile
+            }
+        }
+
+        internal LuaBridge GetBridge( int index )
+        {
+            return _bridges[index];
+        }
+
+        /// <summary>
+        /// Releases all the resources used by the <see cref="LuaBridgePool"/>, closing all its Lua states.
+        /// </summary>
+        /// <remarks>
+        /// Lua states that are leased are also closed; each waits until it is not in use by another thread.
+        /// Threads waiting in <see cref="Acquire"/> throw <see cref="ObjectDisposedException"/>.
+        /// </remarks>
+        public void Dispose()
+        {
+            if (_disposed)
+                return;
+
+            _disposed = true;
+
+            _disposing.Cancel();
+
+            foreach (LuaBridge bridge in _bridges)
+                bridge.Dispose();
+
+            // the waiting threads were woken by the cancellation, but must leave the semaphore before it is disposed
+            var spinWait = new SpinWait();
+            while (Thread.VolatileRead(ref _waiting) != 0)
+                spinWait.SpinOnce();
+
+            _available.Dispose();
+            _disposing.Dispose();
+            _lastLeased.Dispose();
+        }
+    }
+}
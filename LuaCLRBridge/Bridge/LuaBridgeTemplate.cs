@@ -0,0 +1,139 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Generic;
+    using System.IO;
+    using System.Text;
+
+    /// <summary>
+    /// Represents a recipe for Lua states that are initialized identically, which creates each Lua state
+    /// without compiling its chunks again.
+    /// </summary>
+    /// <remarks>
+    /// <para>The steps of the template (loading built-in libraries, executing chunks, and setting global
+    /// variables) are recorded in order and replayed into each new Lua state.  Chunks are compiled once,
+    /// when they are added, and replayed from their binary form, so creating a Lua state does not parse any
+    /// Lua text.</para>
+    /// <para>A Lua heap cannot be copied between Lua states because CLI objects and the bridge's own
+    /// metatables and weak tables are referenced from it; those are created anew for each Lua state by
+    /// <see cref="CreateBridge"/>.</para>
+    /// <para>Steps must not be added while other threads are creating Lua states.</para>
+    /// </remarks>
+    public sealed class LuaBridgeTemplate
+    {
+        private readonly string _clrBridge;
+
+        private readonly Encoding _encoding;
+
+        private readonly List<Action<LuaBridge>> _steps = new List<Action<LuaBridge>>();
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LuaBridgeTemplate"/> class with no steps.
+        /// </summary>
+        /// <param name="clrBridge">The global variable that will be set to the interface used in Lua to
+        ///     access the CLR; see <see cref="LuaBridge(string, Encoding)"/>.</param>
+        /// <param name="encoding">The character encoding to use when translating between
+        ///     <see cref="String"/> and strings in Lua; see <see cref="LuaBridge(string, Encoding)"/>.
+        ///     </param>
+        public LuaBridgeTemplate( string clrBridge = null, Encoding encoding = null )
+        {
+            _clrBridge = clrBridge;
+            _encoding = encoding;
+        }
+
+        /// <summary>
+        /// Adds a step that loads a Lua built-in library.
+        /// </summary>
+        /// <param name="name">The name of the library; "_G" for the base library.</param>
+        /// <exception cref="ArgumentNullException">If <paramref name="name"/> is <c>null</c>.</exception>
+        public void AddLib( string name )
+        {
+            if (name == null)
+                throw new ArgumentNullException("name");
+
+            _steps.Add(bridge => bridge.LoadLib(name));
+        }
+
+        /// <summary>
+        /// Adds a step that executes a Lua text chunk, compiling the chunk now.
+        /// </summary>
+        /// <param name="buff">The Lua chunk.</param>
+        /// <param name="name">The name of the chunk (used in error messages).</param>
+        /// <exception cref="ArgumentNullException">If <paramref name="buff"/> is <c>null</c>.</exception>
+        /// <exception cref="LuaCompilerException">If there was a Lua error while compiling the chunk.
+        ///     </exception>
+        public void AddChunk( string buff, string name = "<string>" )
+        {
+            if (buff == null)
+                throw new ArgumentNullException("buff");
+
+            byte[] chunk;
+
+            using (var compiler = new LuaBridge(String.Empty, _encoding))
+            using (var function = compiler.Load(buff, name))
+            using (var stream = new MemoryStream())
+            {
+                function.Dump(stream);
+                chunk = stream.ToArray();
+            }
+
+            _steps.Add(bridge =>
+            {
+                using (var function = bridge.Load(new MemoryStream(chunk, false), name, "b"))
+                    function.Call(bridge);
+            });
+        }
+
+        /// <summary>
+        /// Adds a step that sets a global Lua variable.
+        /// </summary>
+        /// <param name="global">The global variable name.</param>
+        /// <param name="value">The value of the global variable; the same value is set in every Lua state.
+        ///     </param>
+        /// <exception cref="ArgumentNullException">If <paramref name="global"/> is <c>null</c>.</exception>
+        /// <exception cref="ArgumentException">If <paramref name="value"/> is a Lua value, which exists
+        ///     only within its own Lua state.</exception>
+        public void AddGlobal( string global, object value )
+        {
+            if (global == null)
+                throw new ArgumentNullException("global");
+            if (value is LuaBase)
+                throw new ArgumentException("Lua values cannot be shared between Lua states.", "value");
+
+            _steps.Add(bridge => bridge[global] = value);
+        }
+
+        /// <summary>
+        /// Creates a new Lua state and replays the steps of the template into it.
+        /// </summary>
+        /// <returns>The new Lua state.</returns>
+        /// <exception cref="LuaRuntimeException">If there was a Lua error while executing a chunk.
+        ///     </exception>
+        public LuaBridge CreateBridge()
+        {
+            var bridge = new LuaBridge(_clrBridge, _encoding);
+
+            try
+            {
+                foreach (Action<LuaBridge> step in _steps)
+                    step(bridge);
+            }
+            catch
+            {
+                bridge.Dispose();
+                throw;
+            }
+
+            return bridge;
+        }
+    }
+}
@@ -0,0 +1,368 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Generic;
+    using System.IO;
+    using System.IO.MemoryMappedFiles;
+    using System.Security;
+    using System.Security.Cryptography;
+    using System.Text;
+
+    /// <summary>
+    /// Represents a file of many named Lua chunks that is mapped into memory, from which the chunks are loaded
+    /// without copying them.
+    /// </summary>
+    /// <remarks>
+    /// <para>A bundle starts with an index: the signature "LuaBndl2", the number of chunks as a 32-bit
+    /// integer, and for each chunk the length of its UTF-8 name as a 32-bit integer, its name, the offset
+    /// and length of the chunk as 64-bit integers, and the SHA-256 digest of the name, a zero byte, and the
+    /// chunk.  The chunks (usually dumped by <see cref="LuaFunction.Dump"/>) follow the index.  All integers
+    /// are little-endian.</para>
+    /// <para>Lua does not verify binary chunks, and loading a corrupt one can crash the process, so each
+    /// chunk is checked against its digest when it is first loaded.  The digest detects a bundle that was
+    /// damaged or only partly written, but not one that was altered deliberately; a bundle must come from a
+    /// trusted source, just as the code that it contains must.</para>
+    /// <para>A bundle may be used by many Lua states at once, but must not be disposed while any of them is
+    /// loading from it.</para>
+    /// </remarks>
+    public sealed class LuaChunkBundle : IDisposable
+    {
+        private static readonly byte[] _signature = Encoding.ASCII.GetBytes("LuaBndl2");
+
+        private const int _digestSize = 32;
+
+        private sealed class Entry
+        {
+            internal long _offset;
+
+            internal long _length;
+
+            internal byte[] _digest;
+
+            /// <summary>
+            /// Whether the chunk has been checked against its digest; checking it again is harmless.
+            /// </summary>
+            internal volatile bool _verified;
+        }
+
+        private bool _disposed = false;
+
+        private readonly MemoryMappedFile _file;
+
+        private readonly MemoryMappedViewAccessor _view;
+
+        [SecurityCritical]
+        private readonly IntPtr _base;
+
+        private readonly Dictionary<string, Entry> _entries = new Dictionary<string, Entry>(StringComparer.Ordinal);
+
+        private readonly List<string> _names = new List<string>();
+
+        [SecuritySafeCritical]
+        private LuaChunkBundle( MemoryMappedFile file, long length )
+        {
+            _file = file;
+            _view = file.CreateViewAccessor(0, length, MemoryMappedFileAccess.Read);
+            _base = _view.SafeMemoryMappedViewHandle.DangerousGetHandle();
+
+            try
+            {
+                ReadIndex(length);
+            }
+            catch
+            {
+                _view.Dispose();
+                throw;
+            }
+        }
+
+        /// <summary>
+        /// Opens a bundle by mapping its file into memory.
+        /// </summary>
+        /// <param name="path">The path of the bundle.</param>
+        /// <returns>The bundle, which must be disposed to unmap its file.</returns>
+        /// <exception cref="ArgumentNullException">If <paramref name="path"/> is <c>null</c>.</exception>
+        /// <exception cref="InvalidDataException">If the file is not a valid bundle.</exception>
+        public static LuaChunkBundle Open( string path )
+        {
+            if (path == null)
+                throw new ArgumentNullException("path");
+
+            long length = new FileInfo(path).Length;
+
+            if (length < _signature.Length + sizeof(int))
+                throw new InvalidDataException("File is too short to be a bundle of Lua chunks");
+
+            var file = MemoryMappedFile.CreateFromFile(path, FileMode.Open, null, 0, MemoryMappedFileAccess.Read);
+
+            try
+            {
+                return new LuaChunkBundle(file, length);
+            }
+            catch
+            {
+                file.Dispose();
+                throw;
+            }
+        }
+
+        /// <summary>
+        /// Writes a bundle of named Lua chunks.
+        /// </summary>
+        /// <param name="stream">The stream into which to write the bundle.</param>
+        /// <param name="chunks">The names and contents of the chunks.</param>
+        /// <exception cref="ArgumentNullException">If <paramref name="stream"/> or
+        ///     <paramref name="chunks"/> is <c>null</c>, or if any name or content is <c>null</c>.</exception>
+        /// <exception cref="ArgumentException">If a name occurs more than once.</exception>
+        public static void Write( Stream stream, IEnumerable<KeyValuePair<string, byte[]>> chunks )
+        {
+            if (stream == null)
+                throw new ArgumentNullException("stream");
+            if (chunks == null)
+                throw new ArgumentNullException("chunks");
+
+            var names = new List<byte[]>();
+            var contents = new List<byte[]>();
+            var seen = new HashSet<string>(StringComparer.Ordinal);
+
+            long indexLength = _signature.Length + sizeof(int);
+
+            foreach (KeyValuePair<string, byte[]> chunk in chunks)
+            {
+                if (chunk.Key == null || chunk.Value == null)
+                    throw new ArgumentNullException("chunks");
+                if (!seen.Add(chunk.Key))
+                    throw new ArgumentException(String.Format("'{0}' names more than one chunk", chunk.Key), "chunks");
+
+                byte[] name = Encoding.UTF8.GetBytes(chunk.Key);
+
+                names.Add(name);
+                contents.Add(chunk.Value);
+
+                indexLength += sizeof(int) + name.Length + sizeof(long) + sizeof(long) + _digestSize;
+            }
+
+            var writer = new BinaryWriter(stream);
+
+            writer.Write(_signature);
+            writer.Write(names.Count);
+
+            long offset = indexLength;
+
+            for (int i = 0; i < names.Count; ++i)
+            {
+                writer.Write(names[i].Length);
+                writer.Write(names[i]);
+                writer.Write(offset);
+                writer.Write((long)contents[i].Length);
+
+                using (var sha = SHA256.Create())
+                {
+                    sha.TransformBlock(names[i], 0, names[i].Length, null, 0);
+                    sha.TransformBlock(new byte[1], 0, 1, null, 0);
+                    sha.TransformFinalBlock(contents[i], 0, contents[i].Length);
+
+                    writer.Write(sha.Hash);
+                }
+
+                offset += contents[i].Length;
+            }
+
+            foreach (byte[] content in contents)
+                writer.Write(content);
+
+            writer.Flush();
+        }
+
+        private void ReadIndex( long length )
+        {
+            var signature = new byte[_signature.Length];
+            _view.ReadArray(0, signature, 0, signature.Length);
+
+            for (int i = 0; i < signature.Length; ++i)
+                if (signature[i] != _signature[i])
+                    throw new InvalidDataException("File is not a bundle of Lua chunks");
+
+            long position = signature.Length;
+
+            int count = _view.ReadInt32(position);
+            position += sizeof(int);
+
+            for (int i = 0; i < count; ++i)
+            {
+                if (position + sizeof(int) > length)
+                    throw new InvalidDataException("Index of bundle of Lua chunks is truncated");
+
+                int nameLength = _view.ReadInt32(position);
+                position += sizeof(int);
+
+                if (nameLength < 0 || position + nameLength + sizeof(long) + sizeof(long) + _digestSize > length)
+                    throw new InvalidDataException("Index of bundle of Lua chunks is truncated");
+
+                var name = new byte[nameLength];
+                _view.ReadArray(position, name, 0, nameLength);
+                position += nameLength;
+
+                var entry = new Entry();
+                entry._offset = _view.ReadInt64(position);
+                position += sizeof(long);
+                entry._length = _view.ReadInt64(position);
+                position += sizeof(long);
+                entry._digest = new byte[_digestSize];
+                _view.ReadArray(position, entry._digest, 0, _digestSize);
+                position += _digestSize;
+
+                if (entry._offset < 0 || entry._length < 0 || entry._offset > length - entry._length)
+                    throw new InvalidDataException("Chunk lies outside bundle of Lua chunks");
+
+                string nameString = Encoding.UTF8.GetString(name);
+
+                if (_entries.ContainsKey(nameString))
+                    throw new InvalidDataException(String.Format("'{0}' names more than one chunk of bundle", nameString));
+
+                _entries.Add(nameString, entry);
+                _names.Add(nameString);
+            }
+        }
+
+        /// <summary>
+        /// Gets the names of the chunks in the bundle, in order.
+        /// </summary>
+        public IList<string> Names
+        {
+            get { return _names.AsReadOnly(); }
+        }
+
+        /// <summary>
+        /// Determines whether the bundle contains a named chunk.
+        /// </summary>
+        /// <param name="name">The name of the chunk.</param>
+        /// <returns><c>true</c> if the bundle contains the chunk; otherwise, <c>false</c>.</returns>
+        public bool Contains( string name )
+        {
+            return name != null && _entries.ContainsKey(name);
+        }
+
+        /// <summary>
+        /// Loads a named chunk of the bundle into a Lua state.
+        /// </summary>
+        /// <param name="bridge">The Lua state into which to load the chunk.</param>
+        /// <param name="name">The name of the chunk.</param>
+        /// <returns>The Lua function that will execute the chunk.</returns>
+        /// <exception cref="ArgumentNullException">If <paramref name="bridge"/> or <paramref name="name"/>
+        ///     is <c>null</c>.</exception>
+        /// <exception cref="KeyNotFoundException">If the bundle does not contain the chunk.</exception>
+        /// <exception cref="ObjectDisposedException">The <see cref="LuaChunkBundle"/> has been disposed.
+        ///     </exception>
+        /// <exception cref="InvalidDataException">If the chunk does not match its digest.</exception>
+        /// <exception cref="LuaCompilerException">If there was a Lua error while loading the chunk.
+        ///     </exception>
+        [SecuritySafeCritical]
+        public LuaFunction Load( LuaBridgeBase bridge, string name )
+        {
+            if (bridge == null)
+                throw new ArgumentNullException("bridge");
+            if (name == null)
+                throw new ArgumentNullException("name");
+            if (_disposed)
+                throw new ObjectDisposedException(GetType().FullName);
+
+            Entry entry;
+            if (!_entries.TryGetValue(name, out entry))
+                throw new KeyNotFoundException(String.Format("'{0}' is not a chunk of the bundle", name));
+
+            if (!entry._verified)
+                Verify(name, entry);
+
+            return bridge.Load(new IntPtr(_base.ToInt64() + entry._offset), entry._length, "=" + name);
+        }
+
+        /// <summary>
+        /// Checks a chunk against its digest, reading it from the mapped file.
+        /// </summary>
+        private void Verify( string name, Entry entry )
+        {
+            byte[] digest;
+
+            using (var sha = SHA256.Create())
+            using (var stream = _file.CreateViewStream(entry._offset, entry._length, MemoryMappedFileAccess.Read))
+            {
+                byte[] prefix = Encoding.UTF8.GetBytes(name + "\0");
+                sha.TransformBlock(prefix, 0, prefix.Length, null, 0);
+
+                var buffer = new byte[Math.Min(entry._length, 64 * 1024)];
+                long remaining = entry._length;
+
+                while (remaining > 0)
+                {
+                    int read = stream.Read(buffer, 0, (int)Math.Min(remaining, buffer.Length));
+                    if (read == 0)
+                        throw new InvalidDataException(String.Format("Chunk '{0}' of bundle is truncated", name));
+
+                    sha.TransformBlock(buffer, 0, read, null, 0);
+                    remaining -= read;
+                }
+
+                sha.TransformFinalBlock(buffer, 0, 0);
+                digest = sha.Hash;
+            }
+
+            for (int i = 0; i < _digestSize; ++i)
+                if (digest[i] != entry._digest[i])
+                    throw new InvalidDataException(String.Format("Chunk '{0}' of bundle does not match its digest", name));
+
+            entry._verified = true;
+        }
+
+        /// <summary>
+        /// Loads every chunk of the bundle into a Lua state as a loader in package.preload, so that
+        /// <c>require</c> executes the chunk of a module.
+        /// </summary>
+        /// <param name="bridge">The Lua state into which to load the chunks.</param>
+        /// <exception cref="ArgumentNullException">If <paramref name="bridge"/> is <c>null</c>.</exception>
+        /// <exception cref="InvalidOperationException">If the package library is not loaded.</exception>
+        /// <exception cref="ObjectDisposedException">The <see cref="LuaChunkBundle"/> has been disposed.
+        ///     </exception>
+        /// <exception cref="LuaCompilerException">If there was a Lua error while loading a chunk.
+        ///     </exception>
+        public void Preload( LuaBridgeBase bridge )
+        {
+            if (bridge == null)
+                throw new ArgumentNullException("bridge");
+
+            using (var package = bridge["package"] as LuaTable)
+            using (var preload = package != null ? package["preload"] as LuaTable : null)
+            {
+                if (preload == null)
+                    throw new InvalidOperationException("The package library is not loaded");
+
+                foreach (string name in _names)
+                    using (LuaFunction function = Load(bridge, name))
+                        preload[name] = function;
+            }
+        }
+
+        /// <summary>
+        /// Unmaps the file of the bundle.  Lua functions loaded from the bundle remain valid.
+        /// </summary>
+        public void Dispose()
+        {
+            if (_disposed)
+                return;
+
+            _disposed = true;
+
+            _view.Dispose();
+            _file.Dispose();
+        }
+    }
+}
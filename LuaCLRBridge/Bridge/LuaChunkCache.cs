@@ -0,0 +1,416 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Concurrent;
+    using System.IO;
+    using System.Security;
+    using System.Security.Cryptography;
+    using System.Text;
+    using System.Threading;
+    using Lua;
+
+    /// <summary>
+    /// Represents a cache of compiled Lua text chunks, which may be shared by many Lua states.
+    /// </summary>
+    /// <remarks>
+    /// <para>When a Lua state has a <see cref="LuaBridgeBase.ChunkCache"/>, each text chunk that it loads is
+    /// compiled once and dumped as a binary chunk, keyed by a hash of its content and name; loading the same
+    /// chunk again loads the binary chunk instead of parsing the text.</para>
+    /// <para>A binary chunk whose header does not match this Lua runtime (e.g., one persisted by a different
+    /// version or build) is discarded and the text chunk is compiled again.</para>
+    /// <para>Each persisted chunk ends with a digest of its key and content, so a chunk that is truncated,
+    /// corrupted, or copied from another key is also discarded.  Lua does not verify binary chunks, and
+    /// malformed ones can crash the process; the digest does not stop deliberate tampering by someone who can
+    /// write to the directory, so the directory must be trusted as much as the code that uses the cache.</para>
+    /// <para>At most <see cref="Capacity"/> compiled chunks are kept in memory; when more are added, others
+    /// are evicted, and are read again from the directory (or compiled again) when next loaded.</para>
+    /// </remarks>
+    public sealed class LuaChunkCache
+    {
+        /// <summary>
+        /// The size of the header of a Lua 5.2 binary chunk: the signature, the version and format, the sizes
+        /// of native types, and the tail that detects conversion of line endings.
+        /// </summary>
+        private const int _headerSize = 18;
+
+        /// <summary>
+        /// The size of the SHA-256 digest at the end of each persisted chunk.
+        /// </summary>
+        private const int _digestSize = 32;
+
+        private const int _defaultCapacity = 1024;
+
+        private const string _extension = ".luac";
+
+        private readonly string _directory;
+
+        private readonly int _capacity;
+
+        private readonly ConcurrentDictionary<string, byte[]> _chunks = new ConcurrentDictionary<string, byte[]>(StringComparer.Ordinal);
+
+        /// <summary>
+        /// The header of binary chunks dumped by this Lua runtime; determined when first needed.
+        /// </summary>
+        private byte[] _header;
+
+        private long _hits = 0;
+
+        private long _misses = 0;
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LuaChunkCache"/> class that keeps compiled chunks in
+        /// memory.
+        /// </summary>
+        public LuaChunkCache()
+            : this(null)
+        {
+        }
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LuaChunkCache"/> class that keeps compiled chunks in
+        /// memory and persists them to a directory.
+        /// </summary>
+        /// <param name="directory">The directory in which compiled chunks are persisted, which is created if
+        ///     it does not exist; or <c>null</c> to keep compiled chunks only in memory.</param>
+        public LuaChunkCache( string directory )
+            : this(directory, _defaultCapacity)
+        {
+        }
+
+        /// <summary>
+        /// Initializes a new instance of the <see cref="LuaChunkCache"/> class that keeps a limited number of
+        /// compiled chunks in memory and persists them to a directory.
+        /// </summary>
+        /// <param name="directory">The directory in which compiled chunks are persisted, which is created if
+        ///     it does not exist; or <c>null</c> to keep compiled chunks only in memory.</param>
+        /// <param name="capacity">The most compiled chunks kept in memory.</param>
+        /// <exception cref="ArgumentOutOfRangeException">If <paramref name="capacity"/> is not positive.
+        ///     </exception>
+        public LuaChunkCache( string directory, int capacity )
+        {
+            if (capacity <= 0)
+                throw new ArgumentOutOfRangeException("capacity");
+
+            if (directory != null)
+                System.IO.Directory.CreateDirectory(directory);
+
+            _directory = directory;
+            _capacity = capacity;
+        }
+
+        /// <summary>
+        /// Gets the directory in which compiled chunks are persisted, or <c>null</c>.
+        /// </summary>
+        public string Directory
+        {
+            get { return _directory; }
+        }
+
+        /// <summary>
+        /// Gets the most compiled chunks kept in memory.
+        /// </summary>
+        public int Capacity
+        {
+            get { return _capacity; }
+        }
+
+        /// <summary>
+        /// Gets the number of compiled chunks in memory.
+        /// </summary>
+        public int Count
+        {
+            get { return _chunks.Count; }
+        }
+
+        /// <summary>
+        /// Gets the number of chunks that were loaded without compiling.
+        /// </summary>
+        public long Hits
+        {
+            get { return Interlocked.Read(ref _hits); }
+        }
+
+        /// <summary>
+        /// Gets the number of chunks that were compiled.
+        /// </summary>
+        public long Misses
+        {
+            get { return Interlocked.Read(ref _misses); }
+        }
+
+        /// <summary>
+        /// Removes the compiled chunks from memory.  Persisted chunks are not deleted.
+        /// </summary>
+        public void Clear()
+        {
+            _chunks.Clear();
+        }
+
+        /// <summary>
+        /// Loads a Lua text chunk, from its compiled chunk if one is cached.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="buff">The Lua chunk.</param>
+        /// <param name="name">The name of the chunk (used in error messages).</param>
+        /// <param name="encoding">The character encoding of the Lua state.</param>
+        /// <returns>The status of loading the chunk; as with lua_load, the function or error message is
+        ///     pushed onto the Lua stack.</returns>
+        [SecurityCritical]
+        internal LuaStatus Load( IntPtr L, string buff, string name, Encoding encoding )
+        {
+            byte[] source = encoding.GetBytes(buff);
+            string key = ComputeKey(source, name, "t");
+
+            byte[] chunk = Find(key);
+
+            if (chunk != null)
+            {
+                if (HasHeader(L, chunk, encoding))
+                {
+                    if (LuaWrapper.luaW_loadbufferx(L, chunk, name, "b", encoding) == LuaStatus.LUA_OK)
+                    {
+                        Interlocked.Increment(ref _hits);
+                        return LuaStatus.LUA_OK;
+                    }
+
+                    LuaWrapper.lua_pop(L, 1); // error
+                }
+
+                Remove(key);
+            }
+
+            Interlocked.Increment(ref _misses);
+
+            LuaStatus status = LuaWrapper.luaW_loadbufferx(L, source, name, "t", encoding);
+
+            if (status == LuaStatus.LUA_OK)
+                Store(key, Dump(L));
+
+            return status;
+        }
+
+        /// <summary>
+        /// Computes the key of a chunk from its content, name, and mode.
+        /// </summary>
+        private static string ComputeKey( byte[] source, string name, string mode )
+        {
+            using (var sha = SHA256.Create())
+            {
+                byte[] prefix = Encoding.UTF8.GetBytes(name + "\0" + mode + "\0");
+
+                sha.TransformBlock(prefix, 0, prefix.Length, null, 0);
+                sha.TransformFinalBlock(source, 0, source.Length);
+
+                var key = new StringBuilder(sha.Hash.Length * 2);
+
+                foreach (byte b in sha.Hash)
+                    key.Append(b.ToString("x2"));
+
+                return key.ToString();
+            }
+        }
+
+        /// <summary>
+        /// Computes the digest that ends a persisted chunk from its key and content.
+        /// </summary>
+        private static byte[] ComputeDigest( string key, byte[] chunk, int length )
+        {
+            using (var sha = SHA256.Create())
+            {
+                byte[] prefix = Encoding.UTF8.GetBytes(key + "\0");
+
+                sha.TransformBlock(prefix, 0, prefix.Length, null, 0);
+                sha.TransformFinalBlock(chunk, 0, length);
+
+                return sha.Hash;
+            }
+        }
+
+        /// <summary>
+        /// Dumps the function at the top of the Lua stack as a binary chunk.
+        /// </summary>
+        [SecurityCritical]
+        private static byte[] Dump( IntPtr L )
+        {
+            using (var stream = new MemoryStream())
+            {
+                var streamWriter = new LuaStreamWriter(stream);
+
+                LuaWrapper.lua_dump(L, streamWriter.Writer, IntPtr.Zero);
+
+                return stream.ToArray();
+            }
+        }
+
+        /// <summary>
+        /// Checks that a binary chunk has the header of binary chunks dumped by this Lua runtime.
+        /// </summary>
+        [SecurityCritical]
+        private bool HasHeader( IntPtr L, byte[] chunk, Encoding encoding )
+        {
+            byte[] header = _header;
+
+            if (header == null)
+            {
+                // the header of any dumped chunk is that of this Lua runtime
+                ObjectTranslator.CheckStack(L, 1);
+
+                LuaWrapper.luaW_loadbufferx(L, new byte[0], "=header", "t", encoding);
+                header = Dump(L);
+                LuaWrapper.lua_pop(L, 1); // function
+
+                Array.Resize(ref header, _headerSize);
+                _header = header;
+            }
+
+            if (chunk.Length < _headerSize)
+                return false;
+
+            for (int i = 0; i < _headerSize; ++i)
+                if (chunk[i] != header[i])
+                    return false;
+
+            return true;
+        }
+
+        private byte[] Find( string key )
+        {
+            byte[] chunk;
+
+            if (_chunks.TryGetValue(key, out chunk))
+                return chunk;
+
+            if (_directory == null)
+                return null;
+
+            string path = Path.Combine(_directory, key + _extension);
+
+            if (!File.Exists(path))
+                return null;
+
+            byte[] persisted;
+
+            try
+            {
+                persisted = File.ReadAllBytes(path);
+            }
+            catch (IOException)
+            {
+                return null;
+            }
+            catch (UnauthorizedAccessException)
+            {
+                return null;
+            }
+
+            int length = persisted.Length - _digestSize;
+
+            if (length < 0 || !HasDigest(persisted, length, ComputeDigest(key, persisted, length)))
+            {
+                TryDelete(path);
+                return null;
+            }
+
+            chunk = new byte[length];
+            Buffer.BlockCopy(persisted, 0, chunk, 0, length);
+
+            MakeRoom();
+            return _chunks.GetOrAdd(key, chunk);
+        }
+
+        private static bool HasDigest( byte[] persisted, int length, byte[] digest )
+        {
+            for (int i = 0; i < _digestSize; ++i)
+                if (persisted[length + i] != digest[i])
+                    return false;
+
+            return true;
+        }
+
+        /// <summary>
+        /// Evicts compiled chunks from memory until there is room for another.
+        /// </summary>
+        private void MakeRoom()
+        {
+            // the chunks evicted are arbitrary; persisted ones are read again when next loaded
+            while (_chunks.Count >= _capacity)
+            {
+                foreach (string evicted in _chunks.Keys)
+                {
+                    byte[] chunk;
+                    _chunks.TryRemove(evicted, out chunk);
+                    break;
+                }
+            }
+        }
+
+        private void Store( string key, byte[] chunk )
+        {
+            MakeRoom();
+            _chunks[key] = chunk;
+
+            if (_directory == null)
+                return;
+
+            // written to a temporary file and then renamed, so that readers never see a partial chunk
+            string path = Path.Combine(_directory, key + _extension);
+            string temporaryPath = Path.Combine(_directory, key + "." + Guid.NewGuid().ToString("N") + ".tmp");
+
+            try
+            {
+                using (var stream = File.Create(temporaryPath))
+                {
+                    stream.Write(chunk, 0, chunk.Length);
+
+                    byte[] digest = ComputeDigest(key, chunk, chunk.Length);
+                    stream.Write(digest, 0, digest.Length);
+                }
+
+                if (File.Exists(path))
+                    File.Delete(path);
+
+                File.Move(temporaryPath, path);
+            }
+            catch (IOException)
+            {
+                TryDelete(temporaryPath);  // another Lua state persisted the chunk first
+            }
+            catch (UnauthorizedAccessException)
+            {
+                TryDelete(temporaryPath);
+            }
+        }
+
+        private void Remove( string key )
+        {
+            byte[] chunk;
+            _chunks.TryRemove(key, out chunk);
+
+            if (_directory != null)
+                TryDelete(Path.Combine(_directory, key + _extension));
+        }
+
+        private static void TryDelete( string path )
+        {
+            try
+            {
+                File.Delete(path);
+            }
+            catch (IOException)
+            {
+            }
+            catch (UnauthorizedAccessException)
+            {
+            }
+        }
+    }
+}
@@ -25,6 +25,11 @@ namespace LuaCLRBridge
     /// </summary>
     public class LuaFunctionBase : LuaBase
     {
+        /// <summary>
+        /// Where the function is defined, for timing calls of it; computed when first needed.
+        /// </summary>
+        private string _timingName;
+
         [SecurityCritical]
         internal LuaFunctionBase( ObjectTranslator objectTranslator, IntPtr L, int index )
             : base(objectTranslator, L, index)
@@ -293,6 +298,180 @@ namespace LuaCLRBridge
             }
         }
 
+        /// <summary>
+        /// Calls the function in the main Lua thread once for each of a sequence of argument lists.
+        /// </summary>
+        /// <param name="resultCount">The number of values returned from each call of the function.</param>
+        /// <param name="argumentLists">The arguments to each call of the function.</param>
+        /// <returns>The return values from the calls of the function, in order; the return values from call
+        ///     <c>i</c> start at index <c>i * resultCount</c>.</returns>
+        /// <exception cref="LuaRuntimeException">If there was a Lua error while executing the function.
+        ///     </exception>
+        /// <remarks>
+        /// The Lua state is locked and the error handler is set up once for all the calls.  If a call fails,
+        /// the remaining calls are not made.
+        /// </remarks>
+        public object[] CallBatch( int resultCount, IList<object[]> argumentLists )
+        {
+            if (argumentLists == null)
+                throw new ArgumentNullException("argumentLists");
+            if (resultCount < 0)
+                throw new ArgumentOutOfRangeException("resultCount");
+
+            var results = new object[checked(argumentLists.Count * resultCount)];
+
+            CallBatch(resultCount, argumentLists, results);
+
+            return results;
+        }
+
+        /// <summary>
+        /// Calls the function in the main Lua thread once for each of a sequence of argument lists, storing
+        /// the return values in a specified array.
+        /// </summary>
+        /// <param name="resultCount">The number of values returned from each call of the function.</param>
+        /// <param name="argumentLists">The arguments to each call of the function.</param>
+        /// <param name="results">The array in which to store the return values from the calls of the function,
+        ///     in order; the return values from call <c>i</c> are stored starting at index
+        ///     <c>i * resultCount</c>.</param>
+        /// <exception cref="LuaRuntimeException">If there was a Lua error while executing the function.
+        ///     </exception>
+        /// <remarks>
+        /// <para>The Lua state is locked and the error handler is set up once for all the calls.  If a call
+        /// fails, the remaining calls are not made, but the return values of the calls already made have been
+        /// stored.</para>
+        /// <para>If the function is accessed from another application domain, <paramref name="results"/> is
+        /// copied into this application domain and the return values are not seen by the caller; use <see
+        /// cref="CallBatch(int, IList{object[]})"/> instead.</para>
+        /// </remarks>
+        [SecuritySafeCritical]
+        public void CallBatch( int resultCount, IList<object[]> argumentLists, object[] results )
+        {
+            CheckCallBatchArguments(resultCount, argumentLists, results);
+
+            using (var lockedMainL = _objectTranslator.LockedMainState)
+            {
+                var L = lockedMainL._L;
+
+                CallBatch(_objectTranslator, L, resultCount, argumentLists, results);
+            }
+        }
+
+        /// <summary>
+        /// Calls the function in the thread represented by a specified Lua bridge once for each of a sequence
+        /// of argument lists, storing the return values in a specified array.
+        /// </summary>
+        /// <param name="bridge">The bridge of the Lua thread.</param>
+        /// <param name="resultCount">The number of values returned from each call of the function.</param>
+        /// <param name="argumentLists">The arguments to each call of the function.</param>
+        /// <param name="results">The array in which to store the return values from the calls of the function,
+        ///     in order; the return values from call <c>i</c> are stored starting at index
+        ///     <c>i * resultCount</c>.</param>
+        /// <exception cref="LuaRuntimeException">If there was a Lua error while executing the function.
+        ///     </exception>
+        /// <remarks>
+        /// See <see cref="CallBatch(int, IList{object[]}, object[])"/>.
+        /// </remarks>
+        [SecuritySafeCritical]
+        public void CallBatch( LuaBridgeBase bridge, int resultCount, IList<object[]> argumentLists, object[] results )
+        {
+            CheckCallBatchArguments(resultCount, argumentLists, results);
+
+            using (var lockedL = bridge.LockedState)
+            {
+                var L = lockedL._L;
+                var objectTranslator = lockedL._objectTranslator;
+
+                CallBatch(objectTranslator, L, resultCount, argumentLists, results);
+            }
+        }
+
+        private static void CheckCallBatchArguments( int resultCount, IList<object[]> argumentLists, object[] results )
+        {
+            if (argumentLists == null)
+                throw new ArgumentNullException("argumentLists");
+            if (results == null)
+                throw new ArgumentNullException("results");
+            if (resultCount < 0)
+                throw new ArgumentOutOfRangeException("resultCount");
+            if ((long)argumentLists.Count * resultCount > results.Length)
+                throw new ArgumentException("Array is too small for the results of all calls", "results");
+        }
+
+        /// <summary>
+        /// Calls the function in a specified Lua thread once for each of a sequence of argument lists.
+        /// </summary>
+        /// <param name="objectTranslator">The object translator for the Lua state that the function exists
+        ///     within.</param>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="retCount">The number of values returned from each call of the function.</param>
+        /// <param name="argumentLists">The arguments to each call of the function.</param>
+        /// <param name="results">The array in which to store the return values.</param>
+        /// <exception cref="LuaRuntimeException">If there was a Lua error while executing the function.
+        ///     </exception>
+        [SecurityCritical]
+        internal void CallBatch( ObjectTranslator objectTranslator, IntPtr L, int retCount, IList<object[]> argumentLists, object[] results )
+        {
+            ObjectTranslator.CheckStack(L, 3);  // stackCollector + self + metamethod
+
+            int oldTop = LuaWrapper.lua_gettop(L);
+
+            _objectTranslator.PushStackCollector(L);
+
+            int top = LuaWrapper.lua_gettop(L);
+
+            try
+            {
+                Push(L); // self
+
+                if (!LuaWrapper.lua_isfunction(L, -1))
+                    if (LuaWrapper.luaL_getmetafield(L, -1, "__call", _objectTranslator.Encoding))
+                        LuaWrapper.lua_remove(L, -2); // self
+
+                // each call is timed as a call by Call would be
+                BoundaryTiming timing = _objectTranslator._boundaryTiming;
+
+                if (timing != null && _timingName == null)
+                    _timingName = LuaHelper.luaH_describefunction(L, -1, _objectTranslator.Encoding);
+
+                int resultIndex = 0;
+
+                foreach (object[] args in argumentLists)
+                {
+                    int argCount = args == null ? 0 : args.Length;
+
+                    ObjectTranslator.CheckStack(L, Math.Max(argCount + 1, retCount));  // function + args; rets
+
+                    LuaWrapper.lua_pushvalue(L, top + 1); // function
+
+                    long start = timing != null ? BoundaryTiming.Now : 0;
+
+                    for (int i = 0; i < argCount; ++i)
+                        objectTranslator.PushObject(L, args[i]);
+
+                    if (LuaWrapper.lua_pcall(L, argCount, retCount, top) != LuaStatus.LUA_OK)
+                    {
+                        object error = objectTranslator.PopObject(L);
+
+                        throw error as Exception ??
+                            new LuaRuntimeException(error != null ? error.ToString() : "unspecified error");
+                    }
+
+                    if (timing != null)
+                        timing.Record(BoundaryKind.LuaFunction, null, _timingName, start);
+
+                    for (int i = retCount - 1; i >= 0; --i)
+                        results[resultIndex + i] = objectTranslator.PopObject(L);
+
+                    resultIndex += retCount;
+                }
+            }
+            finally
+            {
+                LuaWrapper.lua_settop(L, oldTop); // stackCollector, function
+            }
+        }
+
         /// <summary>
         /// Calls the function in a specified Lua thread.
         /// </summary>
@@ -309,8 +488,7 @@ namespace LuaCLRBridge
         {
             ObjectTranslator.CheckStack(L, args.Length + 3);  // stackCollector + self + metamethod + args
 
-            LuaWrapper.lua_pushinteger(L, LuaWrapper.luaW_countlevels(L));
-            LuaWrapper.lua_pushcclosure(L, _objectTranslator._stackCollector, 1);
+            _objectTranslator.PushStackCollector(L);
 
             int top = LuaWrapper.lua_gettop(L);
 
@@ -323,6 +501,17 @@ namespace LuaCLRBridge
             if (retCount != LuaWrapper.LUA_MULTRET && retCount > 0)
                 ObjectTranslator.CheckStack(L, retCount - 1);  // -self + rets
 
+            BoundaryTiming timing = _objectTranslator._boundaryTiming;
+            long start = 0;
+
+            if (timing != null)
+            {
+                if (_timingName == null)
+                    _timingName = LuaHelper.luaH_describefunction(L, -1, _objectTranslator.Encoding);
+
+                start = BoundaryTiming.Now;
+            }
+
             foreach (object arg in args)
                 objectTranslator.PushObject(L, arg);
 
@@ -336,6 +525,9 @@ namespace LuaCLRBridge
                     new LuaRuntimeException(error != null ? error.ToString() : "unspecified error");
             }
 
+            if (timing != null)
+                timing.Record(BoundaryKind.LuaFunction, null, _timingName, start);
+
             object[] results = PopFunctionCallResults(objectTranslator, L, top);
 
             LuaWrapper.lua_pop(L, 1); // stackCollector
@@ -349,8 +541,19 @@ namespace LuaCLRBridge
             int nresults = LuaWrapper.lua_gettop(L) - top;
             object[] results = new object[nresults];
 
-            for (int i = nresults - 1; i >= 0; --i)
-                results[i] = objectTranslator.PopObject(L);
+            // the Lua objects among the results are referenced in one native call
+            objectTranslator.BeginBulkRefs();
+            try
+            {
+                for (int i = 0; i < nresults; ++i)
+                    results[i] = objectTranslator.ToObject(L, top + 1 + i);
+            }
+            finally
+            {
+                objectTranslator.EndBulkRefs(L);
+            }
+
+            LuaWrapper.lua_settop(L, top);
 
             return results;
         }
@@ -12,7 +12,6 @@ namespace LuaCLRBridge
     using System;
     using System.Collections;
     using System.Collections.Generic;
-    using System.Diagnostics;
     using System.Diagnostics.CodeAnalysis;
     using System.Security;
     using Lua;
@@ -23,6 +22,11 @@ namespace LuaCLRBridge
     [SuppressMessage("Microsoft.Naming", "CA1710:IdentifiersShouldHaveCorrectSuffix", Justification = "Unreasonable.")]
     public class LuaTable : LuaTableBase, IEnumerable<KeyValuePair<object, object>>
     {
+        /// <summary>
+        /// The most elements that <see cref="RawToArray"/> translates at once.
+        /// </summary>
+        private const int _rawToArrayChunkSize = 256;
+
         [SecurityCritical]
         internal LuaTable( ObjectTranslator objectTranslator, IntPtr L, int index )
             : base(objectTranslator, L, index)
@@ -161,32 +165,245 @@ namespace LuaCLRBridge
         }
 
         /// <summary>
-        /// Enumerates a Lua table.
+        /// Returns an enumerator, which is a value type, of the pairs of the table using raw access (i.e.
+        /// ignores metatable).
         /// </summary>
-        internal sealed class Enumerator : MarshalByRefObject, IEnumerator<KeyValuePair<object, object>>
+        /// <returns>An enumerator for the table, which can be used by <c>foreach</c> without allocation.</returns>
+        public PairEnumerator RawPairs()
         {
-            private LuaThreadBridge _threadBridge;
+            return new PairEnumerator(this);
+        }
 
-            private bool _valid = true;
+        /// <summary>
+        /// Performs an action on each pair of the table whose key and value are of the specified types, using
+        /// raw access (i.e. ignores metatable).
+        /// </summary>
+        /// <typeparam name="TKey">The type of the keys.</typeparam>
+        /// <typeparam name="TValue">The type of the values.</typeparam>
+        /// <param name="action">The action, which is passed the key and value of each pair.</param>
+        /// <remarks>
+        /// Numbers, Booleans and strings are read as the types directly, as arguments of typed methods are,
+        /// so that they are not boxed.  Pairs whose key or value is not of its type are skipped.  The Lua
+        /// state is locked for the duration.  The action may change or remove existing pairs, but if it adds
+        /// keys so that the table is rehashed, the enumeration is stopped.
+        /// </remarks>
+        /// <exception cref="ArgumentNullException"><paramref name="action"/> is <c>null</c>.</exception>
+        /// <exception cref="InvalidOperationException">The table was rehashed by the action.</exception>
+        [SecuritySafeCritical]
+        public void ForEach<TKey, TValue>( Action<TKey, TValue> action )
+        {
+            if (action == null)
+                throw new ArgumentNullException("action");
 
-            private KeyValuePair<object, object> _current;
+            using (var lockedMainL = _objectTranslator.LockedMainState)
+            {
+                var L = lockedMainL._L;
 
-            [SecuritySafeCritical]
-            public Enumerator( LuaTable table )
+                ObjectTranslator.CheckStack(L, 3);  // self + key + value
+
+                Push(L); // self
+
+                int self = LuaWrapper.lua_gettop(L);
+
+                try
+                {
+                    var cursor = new PairCursor();
+                    while (cursor.Next(L))
+                    {
+                        TKey key;
+                        TValue value = default(TValue);
+
+                        bool read = _objectTranslator.TryToValue(L, self + 1, out key) &&
+                                    _objectTranslator.TryToValue(L, self + 2, out value);
+
+                        LuaWrapper.lua_settop(L, self);  // key, value
+
+                        if (read)
+                            action(key, value);
+                    }
+                }
+                finally
+                {
+                    LuaWrapper.lua_settop(L, self - 1);  // self
+                }
+            }
+        }
+
+        /// <summary>
+        /// Performs an action on each value of the table that is of the specified type, using raw access (i.e.
+        /// ignores metatable).
+        /// </summary>
+        /// <typeparam name="TValue">The type of the values.</typeparam>
+        /// <param name="action">The action, which is passed each value.</param>
+        /// <remarks>
+        /// The keys are not translated.  Otherwise, this works like <see cref="ForEach{TKey, TValue}"/>.
+        /// </remarks>
+        /// <exception cref="ArgumentNullException"><paramref name="action"/> is <c>null</c>.</exception>
+        /// <exception cref="InvalidOperationException">The table was rehashed by the action.</exception>
+        [SecuritySafeCritical]
+        public void ForEach<TValue>( Action<TValue> action )
+        {
+            if (action == null)
+                throw new ArgumentNullException("action");
+
+            using (var lockedMainL = _objectTranslator.LockedMainState)
             {
-                using (var thread = LuaThread.Create(table._objectTranslator))
-                    _threadBridge = thread.CreateBridge();
+                var L = lockedMainL._L;
 
-                Debug.Assert(LuaWrapper.LUA_MINSTACK >= 3, "Insufficient stack.");  // table + key + value
+                ObjectTranslator.CheckStack(L, 3);  // self + key + value
+
+                Push(L); // self
 
-                using (var lockedL = _threadBridge.LockedState)
+                int self = LuaWrapper.lua_gettop(L);
+
+                try
                 {
-                    var L = lockedL._L;
+                    var cursor = new PairCursor();
+                    while (cursor.Next(L))
+                    {
+                        TValue value;
+                        bool read = _objectTranslator.TryToValue(L, self + 2, out value);
 
-                    table.Push(L);
+                        LuaWrapper.lua_settop(L, self);  // key, value
 
-                    LuaWrapper.lua_pushnil(L);
+                        if (read)
+                            action(value);
+                    }
+                }
+                finally
+                {
+                    LuaWrapper.lua_settop(L, self - 1);  // self
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the pair of the table at or after a position, using raw access (i.e. ignores metatable).
+        /// </summary>
+        /// <param name="cursor">The position, which is advanced past the pair found.</param>
+        /// <param name="key">The key of the pair.</param>
+        /// <param name="value">The value of the pair.</param>
+        /// <returns><c>true</c> if a pair was found; otherwise, <c>false</c>.</returns>
+        /// <remarks>
+        /// Unlike the 'next' function in Lua, this looks up no key, so the previous key need not be kept and
+        /// need not still be in the table.
+        /// </remarks>
+        /// <exception cref="InvalidOperationException">The table was rehashed since the first pair was
+        ///     found.</exception>
+        [SecuritySafeCritical]
+        internal bool NextPair( ref PairCursor cursor, out object key, out object value )
+        {
+            key = null;
+            value = null;
+
+            if (cursor.Done)
+                return false;
+
+            using (var lockedMainL = _objectTranslator.LockedMainState)
+            {
+                var L = lockedMainL._L;
+
+                ObjectTranslator.CheckStack(L, 3);  // self + key + value
+
+                Push(L); // self
+
+                int self = LuaWrapper.lua_gettop(L);
+
+                try
+                {
+                    if (!cursor.Next(L))
+                        return false;
+
+                    value = _objectTranslator.ToObject(L, -1);
+                    key = _objectTranslator.ToObject(L, -2);
+
+                    return true;
+                }
+                finally
+                {
+                    LuaWrapper.lua_settop(L, self - 1);  // self, key, value
+                }
+            }
+        }
+
+        /// <summary>
+        /// A position in the pairs of a table, which remembers the layout of the table when it was started and
+        /// the key of the pair last found.
+        /// </summary>
+        /// <remarks>
+        /// Changing or removing existing pairs leaves them where they are, but adding keys may rehash the
+        /// table and move them, after which a position would skip or repeat pairs.  As with the versioning of
+        /// .NET collections, this is reported rather than ignored: the layout and the key last found are
+        /// checked on each step.  A layout can recur (e.g., if the table is rehashed twice and the allocator
+        /// reuses the address), but then the key last found must also be where it was, and continuing from it
+        /// is what the 'next' function in Lua would do.  The default value is before the first pair.
+        /// </remarks>
+        internal struct PairCursor
+        {
+            private int _position;  // 0 before the first pair, -1 after the last
+
+            private IntPtr _node;
+
+            private int _sizeArray;
+
+            private int _keyType;
+
+            private long _key;
+
+            /// <summary>
+            /// Gets whether the position is after the last pair.
+            /// </summary>
+            public bool Done
+            {
+                get
+                {
+                    return _position < 0;
+                }
+            }
+
+            /// <summary>
+            /// Pushes the key and value of the pair at or after the position in the table on the top of the
+            /// stack and advances past it.
+            /// </summary>
+            /// <param name="L">The Lua state.</param>
+            /// <returns><c>true</c> if a pair was pushed; otherwise, <c>false</c>.</returns>
+            /// <exception cref="InvalidOperationException">The table was rehashed so that the pair last found
+            ///     has moved.</exception>
+            [SecurityCritical]
+            public bool Next( IntPtr L )
+            {
+                if (_position < 0)
+                    return false;
+
+                int result = LuaWrapper.luaW_nextpair(L, ref _position, ref _node, ref _sizeArray, ref _keyType, ref _key);
+
+                if (result < 0)
+                    throw new InvalidOperationException("Table was rehashed; enumeration operation may not execute.");
+
+                if (result == 0)
+                {
+                    _position = -1;
+                    return false;
                 }
+
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Enumerates a Lua table.
+        /// </summary>
+        internal sealed class Enumerator : MarshalByRefObject, IEnumerator<KeyValuePair<object, object>>
+        {
+            private LuaTable _table;
+
+            private PairCursor _cursor;
+
+            private KeyValuePair<object, object> _current;
+
+            public Enumerator( LuaTable table )
+            {
+                _table = table;
             }
 
             /// <summary>
@@ -211,22 +428,9 @@ namespace LuaCLRBridge
             /// <summary>
             /// Releases all the resources used by the <see cref="LuaTable.Enumerator"/>.
             /// </summary>
-            [SecuritySafeCritical]
             public void Dispose()
             {
-                if (_threadBridge != null)
-                {
-                    using (var lockedL = _threadBridge.LockedState)
-                    {
-                        var L = lockedL._L;
-
-                        LuaWrapper.lua_pop(L, 2);
-                    }
-
-                    _threadBridge.Dispose();
-                }
-
-                _threadBridge = null;
+                _table = null;
 
                 _current = default(KeyValuePair<object, object>);
             }
@@ -238,57 +442,123 @@ namespace LuaCLRBridge
             ///     if the enumerator has passed the end of the Lua table.</returns>
             /// <exception cref="ObjectDisposedException">The <see cref="LuaTable"/> has been disposed.
             ///     </exception>
+            /// <exception cref="InvalidOperationException">The table was rehashed (e.g., by adding keys)
+            ///     since the enumeration started.</exception>
             [SecuritySafeCritical]
             public bool MoveNext()
             {
-                if (_threadBridge == null)
+                if (_table == null)
                     throw new ObjectDisposedException(GetType().FullName);
 
-                if (!_valid)
-                    return false;
+                object key, value;
+                bool valid = _table.NextPair(ref _cursor, out key, out value);
 
-                using (var lockedL = _threadBridge.LockedState)
-                {
-                    var L = lockedL._L;
-                    var objectTranslator = lockedL._objectTranslator;
+                _current = valid ? new KeyValuePair<object, object>(key, value) : default(KeyValuePair<object, object>);
 
-                    /* stack checked in constructor */
+                return valid;
+            }
 
-                    if (LuaWrapper.lua_next(L, -2) == 0)
-                    {
-                        LuaWrapper.lua_pushnil(L);
+            /// <summary>
+            /// Sets the enumerator to its initial position, which is before the first element in the Lua table.
+            /// </summary>
+            public void Reset()
+            {
+                _cursor = new PairCursor();
+                _current = default(KeyValuePair<object, object>);
+            }
+        }
 
-                        _valid = false;
-                        _current = default(KeyValuePair<object, object>);
-                    }
-                    else
-                    {
-                        object value = objectTranslator.PopObject(L);
-                        object key = objectTranslator.ToObject(L);
+        /// <summary>
+        /// Enumerates the pairs of a Lua table using raw access (i.e. ignores metatable).
+        /// </summary>
+        /// <remarks>
+        /// The enumerator keeps its position rather than the previous key, so it needs no Lua thread, and
+        /// neither it nor the pairs it enumerates are allocated on the heap (though the values of the pairs
+        /// may be).  It can be enumerated by <c>foreach</c> directly.  Existing pairs may be changed or
+        /// removed during enumeration, but adding keys so that the table is rehashed stops it.
+        /// </remarks>
+        public struct PairEnumerator : IEnumerator<KeyValuePair<object, object>>
+        {
+            private LuaTable _table;
 
-                        _current = new KeyValuePair<object, object>(key, value);
-                    }
+            private PairCursor _cursor;
+
+            private KeyValuePair<object, object> _current;
+
+            internal PairEnumerator( LuaTable table )
+            {
+                _table = table;
+                _cursor = new PairCursor();
+                _current = default(KeyValuePair<object, object>);
+            }
+
+            /// <summary>
+            /// Gets the element in the Lua table at the current position of the enumerator.
+            /// </summary>
+            public KeyValuePair<object, object> Current
+            {
+                get
+                {
+                    return _current;
+                }
+            }
 
-                    return _valid;
+            object IEnumerator.Current
+            {
+                get
+                {
+                    return Current;
                 }
             }
 
             /// <summary>
-            /// Sets the enumerator to its initial position, which is before the first element in the Lua table.
+            /// Returns this enumerator, so that <c>foreach</c> can enumerate it.
             /// </summary>
+            /// <returns>This enumerator.</returns>
+            public PairEnumerator GetEnumerator()
+            {
+                return this;
+            }
+
+            /// <summary>
+            /// Releases all the resources used by the <see cref="LuaTable.PairEnumerator"/>.
+            /// </summary>
+            public void Dispose()
+            {
+                _table = null;
+                _current = default(KeyValuePair<object, object>);
+            }
+
+            /// <summary>
+            /// Advances the enumerator to the next element in the Lua table.
+            /// </summary>
+            /// <returns><c>true</c> if the enumerator successfully advanced to the next element; <c>false</c>
+            ///     if the enumerator has passed the end of the Lua table.</returns>
+            /// <exception cref="ObjectDisposedException">The <see cref="LuaTable"/> has been disposed.
+            ///     </exception>
+            /// <exception cref="InvalidOperationException">The table was rehashed (e.g., by adding keys)
+            ///     since the enumeration started.</exception>
             [SecuritySafeCritical]
-            public void Reset()
+            public bool MoveNext()
             {
-                using (var lockedL = _threadBridge.LockedState)
-                {
-                    var L = lockedL._L;
+                if (_table == null)
+                    return false;
 
-                    LuaWrapper.lua_pop(L, 1);
-                    LuaWrapper.lua_pushnil(L);
+                object key, value;
+                bool valid = _table.NextPair(ref _cursor, out key, out value);
 
-                    _valid = true;
-                    _current = default(KeyValuePair<object, object>);
-                }
+                _current = valid ? new KeyValuePair<object, object>(key, value) : default(KeyValuePair<object, object>);
+
+                return valid;
+            }
+
+            /// <summary>
+            /// Sets the enumerator to its initial position, which is before the first element in the Lua table.
+            /// </summary>
+            public void Reset()
+            {
+                _cursor = new PairCursor();
+                _current = default(KeyValuePair<object, object>);
             }
         }
 
@@ -304,33 +574,46 @@ namespace LuaCLRBridge
             {
                 var L = lockedMainL._L;
 
-                ObjectTranslator.CheckStack(L, 2);  // self + value
+                ObjectTranslator.CheckStack(L, 1);  // self
 
                 Push(L); // self
 
-                var length = (long)LuaWrapper.lua_rawlen(L, -1);
+                int self = LuaWrapper.lua_gettop(L);
+
+                var length = (long)LuaWrapper.lua_rawlen(L, self);
 
                 object[] array = new object[length];
 
-                for (int i = 0; i < length; ++i)
+                try
                 {
-                    LuaWrapper.lua_rawgeti(L, -1, i + 1);
+                    // the Lua objects among each chunk of elements are referenced in one native call
+                    for (long first = 0; first < length; first += _rawToArrayChunkSize)
+                    {
+                        int count = (int)Math.Min(_rawToArrayChunkSize, length - first);
 
-                    var element = _objectTranslator.PopObject(L);
+                        ObjectTranslator.CheckStack(L, count);  // values
 
-                    try
-                    {
-                        array[i] = element;
-                    }
-                    catch
-                    {
-                        LuaWrapper.lua_pop(L, 1);  // self
+                        for (int i = 0; i < count; ++i)
+                            LuaWrapper.lua_rawgeti(L, self, (int)(first + i + 1));
+
+                        _objectTranslator.BeginBulkRefs();
+                        try
+                        {
+                            for (int i = 0; i < count; ++i)
+                                array[first + i] = _objectTranslator.ToObject(L, self + 1 + i);
+                        }
+                        finally
+                        {
+                            _objectTranslator.EndBulkRefs(L);
+                        }
 
-                        throw;
+                        LuaWrapper.lua_settop(L, self);  // values
                     }
                 }
-
-                LuaWrapper.lua_pop(L, 1); // table
+                finally
+                {
+                    LuaWrapper.lua_settop(L, self - 1);  // self
+                }
 
                 return array;
             }
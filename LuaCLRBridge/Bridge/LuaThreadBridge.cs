@@ -44,12 +44,12 @@ namespace LuaCLRBridge
         {
             ObjectTranslator.CheckStack(threadL, 1);
 
-            /* Obtain a separate reference to the thread to ensure that it survives even if
-               the original reference is disposed. */
+            /* Obtain a separate LuaThread, which counts toward the reference to the thread, to ensure
+               that the thread survives even if the original LuaThread is disposed. */
             PushObject(threadL, thread);
             this.thread = PopObject(threadL) as LuaThread;
 
-            Debug.Assert(this.thread != null && !this.thread.IsSameReference(thread), "Thread bridge must have its own reference to thread.");
+            Debug.Assert(this.thread != null && this.thread != thread, "Thread bridge must have its own LuaThread.");
         }
 
         /// <summary>
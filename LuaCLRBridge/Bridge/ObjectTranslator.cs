@@ -10,8 +10,6 @@
 namespace LuaCLRBridge
 {
     using System;
-    using System.Collections.Concurrent;
-    using System.Collections.Generic;
     using System.Diagnostics;
     using System.Diagnostics.CodeAnalysis;
     using System.Runtime.InteropServices;
@@ -44,29 +42,25 @@ namespace LuaCLRBridge
         private CLRBridge _clrBridge;
 
         /// <summary>
-        /// The handles of CLI objects that are referenced by the Lua state and must not be collected by the
-        /// CLR garbage collector.
+        /// The timing of crossings between Lua and the CLR, or <c>null</c> if crossings are not timed.
         /// </summary>
-        [SecurityCritical]
-        private readonly HashSet<GCHandle> _handles = new HashSet<GCHandle>();
+        internal BoundaryTiming _boundaryTiming;
 
         /// <summary>
-        /// The Lua objects that will be unreferenced when the Lua state is not in use.
+        /// The cache of compiled text chunks, or <c>null</c> if text chunks are always compiled.
         /// </summary>
-        /// <remarks>
-        /// When a <see cref="LuaBase"/> is finalized, it must unreference the Lua object so that the Lua
-        /// object becomes eligible for collection by the Lua garbage collector.  The Lua state must be
-        /// locked in order to unreference the object.  In order to avoid blocking the CLR finalizer thread,
-        /// if the Lua state is locked when the finalizer runs then unreferencing is deferred until later
-        /// (and on some other thread).
-        /// </remarks>
-        [SecurityCritical]
-        private ConcurrentQueue<DeferredUnref> _deferredUnrefs = new ConcurrentQueue<DeferredUnref>();
+        internal LuaChunkCache _chunkCache;
 
         internal readonly LuaCFunction _atPanic;
 
         internal readonly LuaCFunction _stackCollector;
 
+        /// <summary>
+        /// The reference in the registry of the Lua function of <see cref="_stackCollector"/>.
+        /// </summary>
+        [SecurityCritical]
+        private int _stackCollectorRef;
+
         internal readonly LuaCFunction _luaEquals;
 
         internal readonly LuaCFunction _luaToString;
@@ -92,11 +86,22 @@ namespace LuaCLRBridge
 
             var L = mainL.Handle;
 
+            InitializeRefTable(L);
+
+            CheckStack(L, 1);
+
+            LuaWrapper.lua_pushcfunction(L, _stackCollector);
+            _stackCollectorRef = LuaWrapper.luaL_ref(L, LuaWrapper.LUA_REGISTRYINDEX);
+
             InitializeObjectUserDatas(L);
 
             InitializeMetamethods(L);
 
             InitializeLuaFunctionDelegates(L);
+
+            InitializePartialTargets(L);
+
+            InitializeMemberNames(L);
         }
 
         ~ObjectTranslator()
@@ -193,17 +198,13 @@ namespace LuaCLRBridge
             if (_mainL != null && !_mainL.IsClosed)
                 _mainL.Close();
 
-            if (_handles != null)
-            {
-                Debug.Assert(_handles.Count == 0, "Lua state should be closed which should release all handles.");
-
-                foreach (GCHandle handle in _handles)
-                    handle.Free();
-            }
+            Debug.Assert(_objectCount == 0, "Lua state should be closed which should release all objects.");
 
             if (_objectUserDataRefs != null)
                 Debug.Assert(_objectUserDataRefs.Count == 0, "Lua state should be closed which should release all refs.");
 
+            FreeRefOwners();
+
             if (disposeManaged)
             {
                 if (_clrBridge != null)
@@ -214,26 +215,38 @@ namespace LuaCLRBridge
 
                 if (_luaFunctionDelegates != null)
                     _luaFunctionDelegates.Dispose();
+
+                if (_partialTargets != null)
+                    _partialTargets.Dispose();
+
+                if (_memberNames != null)
+                    _memberNames.Dispose();
             }
         }
 
+        /// <summary>
+        /// Determines whether a Lua thread belongs to the Lua state that the <see cref="ObjectTranslator"/>
+        /// translates objects for.
+        /// </summary>
+        /// <param name="L">The Lua thread.</param>
+        /// <returns><c>true</c> if the Lua thread has the same main thread; otherwise, <c>false</c>.</returns>
+        /// <remarks>
+        /// This is checked on every push of a Lua object, so the main thread itself (the usual case) is
+        /// recognized by pointer comparison, and any other thread by reading the main thread from its global
+        /// state rather than from the registry.
+        /// </remarks>
         [SecurityCritical]
         internal bool HasSameMainState( IntPtr L )
         {
-            return GetMainL(L) == _mainL.Handle;
+            IntPtr mainL = _mainL.Handle;
+
+            return L == mainL || GetMainL(L) == mainL;
         }
 
         [SecurityCritical]
         internal static IntPtr GetMainL( IntPtr L )
         {
-            ObjectTranslator.CheckStack(L, 1);
-
-            LuaWrapper.lua_pushinteger(L, LuaWrapper.LUA_RIDX_MAINTHREAD);
-            LuaWrapper.lua_gettable(L, LuaWrapper.LUA_REGISTRYINDEX);
-            IntPtr mainL = LuaWrapper.lua_tothread(L, -1);
-            LuaWrapper.lua_pop(L, 1);
-
-            return mainL;
+            return LuaWrapper.luaW_mainthread(L);
         }
 
         /// <summary>
@@ -287,20 +300,19 @@ namespace LuaCLRBridge
         [SecurityCritical]
         internal void ExitLua()
         {
-            if (!_disposed)
+            try
             {
-                DeferredUnref deferredUnref;
-                while (_deferredUnrefs.TryDequeue(out deferredUnref))
-                    LuaWrapper.luaL_unref(_mainL.Handle, deferredUnref.Table, deferredUnref.Index);
-            }
-
-            Monitor.Exit(this);
-        }
+                if (!_disposed)
+                {
+                    RunDueCrossHeapCollection();
 
-        [SecurityCritical]
-        internal void DeferUnref( int table, int index )
-        {
-            _deferredUnrefs.Enqueue(new DeferredUnref(table, index));
+                    DrainDeferredUnrefs(_deferredUnrefBudget);
+                }
+            }
+            finally
+            {
+                Monitor.Exit(this);
+            }
         }
 
         [SecurityCritical]
@@ -461,11 +473,11 @@ namespace LuaCLRBridge
         [SecurityCritical]
         internal void PushUntranslatedObject( IntPtr L, object o )
         {
-            PushUntranslatedObject(L, o, _objectMetatableName);
+            PushUntranslatedObject(L, o, _objectMetatableRef);
         }
 
         [SecurityCritical]
-        private void PushUntranslatedObject( IntPtr L, object o, string metatableName )
+        private void PushUntranslatedObject( IntPtr L, object o, int metatableRef )
         {
             bool isRefType = !o.GetType().IsValueType;
 
@@ -474,13 +486,9 @@ namespace LuaCLRBridge
 
             CheckStack(L, 2);  // udata + metatable
 
-            GCHandle handle = GCHandle.Alloc(o);
-            _handles.Add(handle);
-
-            IntPtr udata = LuaWrapper.lua_newuserdata(L, (uint)Marshal.SizeOf(handle));
-            Marshal.StructureToPtr(handle, udata, false);
+            IntPtr udata = NewObjectUserData(L, o);
 
-            LuaWrapper.luaL_getmetatable(L, metatableName, _encoding);
+            LuaWrapper.lua_rawgeti(L, LuaWrapper.LUA_REGISTRYINDEX, metatableRef);
             LuaWrapper.lua_setmetatable(L, -2);
 
             if (isRefType)
@@ -496,27 +504,51 @@ namespace LuaCLRBridge
         [SecurityCritical]
         internal object ToUntranslatedObject( IntPtr L, int index )
         {
-            return ToUntranslatedObject(L, index, _objectMetatableName);
+            return ToUntranslatedObject(L, index, _objectMetatableRef);
         }
 
         [SecurityCritical]
-        private object ToUntranslatedObject( IntPtr L, int index, string metatableName )
+        private object ToUntranslatedObject( IntPtr L, int index, int metatableRef )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, index, metatableName, _encoding);
+            IntPtr udata = ToUserData(L, index, metatableRef);
             if (udata == IntPtr.Zero)
                 return null;
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
-
-            Debug.Assert(_handles.Contains(handle), "Object handle should still exist.");
+            object o = GetUserDataObject(udata);
 
             // 64-bit numbers need to be unwrapped
-            if (handle.Target is CLRInt64)
-                return ((CLRInt64)handle.Target)._value;
-            else if (handle.Target is CLRUInt64)
-                return ((CLRUInt64)handle.Target)._value;
+            if (o is CLRInt64)
+                return ((CLRInt64)o)._value;
+            else if (o is CLRUInt64)
+                return ((CLRUInt64)o)._value;
             else
-                return handle.Target;
+                return o;
+        }
+
+        /// <summary>
+        /// Gets the block of memory of a userdata if the userdata has a specified metatable.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="index">The index in the stack.</param>
+        /// <param name="metatableRef">The reference in the registry of the expected metatable.</param>
+        /// <returns>The address of the block of memory of the userdata if the value at the specified index is
+        ///     a userdata with the expected metatable; otherwise, <see cref="IntPtr.Zero"/>.</returns>
+        /// <remarks>
+        /// This is equivalent to <c>luaL_testudata</c> but compares the metatable by reference rather than by
+        /// name.  Like <c>luaL_testudata</c>, it assumes that there are two free stack slots.
+        /// </remarks>
+        [SecurityCritical]
+        private static IntPtr ToUserData( IntPtr L, int index, int metatableRef )
+        {
+            IntPtr udata = LuaWrapper.lua_touserdata(L, index);
+            if (udata == IntPtr.Zero || !LuaWrapper.lua_getmetatable(L, index))
+                return IntPtr.Zero;
+
+            LuaWrapper.lua_rawgeti(L, LuaWrapper.LUA_REGISTRYINDEX, metatableRef);
+            bool isExpected = LuaWrapper.lua_rawequal(L, -1, -2);
+            LuaWrapper.lua_pop(L, 2);
+
+            return isExpected ? udata : IntPtr.Zero;
         }
 
         /// <summary>
@@ -594,12 +626,13 @@ namespace LuaCLRBridge
         /// Lua.
         /// </summary>
         /// <param name="L">The Lua state.</param>
-        /// <param name="metatableName">The expected name of the type of object being collected.</param>
+        /// <param name="metatableRef">The reference in the registry of the expected metatable of the type of
+        ///     object being collected.</param>
         /// <returns>The number of return values on the Lua stack.</returns>
         [SecurityCritical]
-        private int GarbageCollect( IntPtr L, string metatableName )
+        private int GarbageCollect( IntPtr L, int metatableRef )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, 1, metatableName, _encoding);
+            IntPtr udata = ToUserData(L, 1, metatableRef);
             Debug.Assert(udata != IntPtr.Zero, "Should only be invoked on appropriate userdata.");
 
             /* Ensure that the userdata cannot be used after being garbage collected.  (Yes, this is possible.
@@ -612,14 +645,9 @@ namespace LuaCLRBridge
 
             // Release the CLI object reference.
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
+            object o = FreeObjectSlot(Marshal.ReadInt32(udata));
 
-            Debug.Assert(_handles.Contains(handle), "Object handle should still exist.");
-
-            ReleaseObjectUserData(handle.Target, udata);
-
-            if (_handles.Remove(handle))
-                handle.Free();
+            ReleaseObjectUserData(o, udata);
 
             return 0;
         }
@@ -654,6 +682,20 @@ namespace LuaCLRBridge
                 new LuaPanicException(error != null ? error.ToString() : "unspecified error");
         }
 
+        /// <summary>
+        /// Pushes the message handler that collects the Lua stack trace of an error onto the stack of the
+        /// specified Lua state.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <remarks>
+        /// This method assumes that there is at least one free stack slot in the stack.
+        /// </remarks>
+        [SecurityCritical]
+        internal void PushStackCollector( IntPtr L )
+        {
+            LuaWrapper.lua_rawgeti(L, LuaWrapper.LUA_REGISTRYINDEX, _stackCollectorRef);
+        }
+
         [SecurityCritical]
         private int StackCollector( IntPtr L )
         {
@@ -677,7 +719,8 @@ namespace LuaCLRBridge
                 {
                     Exception exception = error as Exception;
 
-                    int bottom = LuaWrapper.lua_tointeger(L, LuaWrapper.lua_upvalueindex(1)) + 1;
+                    // the levels below the protected call are not part of the error
+                    int bottom = LuaWrapper.luaW_protectedlevels(L);
 
                     CheckStack(L, 1);
 
@@ -734,17 +777,5 @@ namespace LuaCLRBridge
             string result = LuaWrapper.luaL_tolstring(L, 1, out len, _encoding);
             return 1;
         }
-
-        private struct DeferredUnref
-        {
-            public readonly int Table;
-            public readonly int Index;
-
-            public DeferredUnref( int table, int index )
-            {
-                this.Table = table;
-                this.Index = index;
-            }
-        }
     }
 }
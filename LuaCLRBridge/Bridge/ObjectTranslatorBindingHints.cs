@@ -10,6 +10,7 @@
 namespace LuaCLRBridge
 {
     using System;
+    using System.Collections.Concurrent;
     using System.Collections.Generic;
     using System.Reflection;
 
@@ -55,6 +56,12 @@ namespace LuaCLRBridge
             private PropertyAttributes _propertyAttributesMask = PropertyAttributes.SpecialName;
             private PropertyAttributes _propertyAttributes;
 
+            /// <summary>
+            /// The members that have been resolved under these member-binding hints.
+            /// </summary>
+            internal readonly ConcurrentDictionary<MemberResolutionKey, ResolvedMembers> _resolvedMembers =
+                new ConcurrentDictionary<MemberResolutionKey, ResolvedMembers>();
+
             private MemberBindingHints()
             {
             }
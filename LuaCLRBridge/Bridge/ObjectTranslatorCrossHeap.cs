@@ -0,0 +1,304 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Generic;
+    using System.Runtime.CompilerServices;
+    using System.Runtime.InteropServices;
+    using System.Security;
+    using Lua;
+
+    internal partial class ObjectTranslator
+    {
+        /* A CLI object referenced by Lua is held strongly by the object table, and a Lua value referenced by the
+           CLR is held strongly by the registry.  A cycle through both (e.g., a CLI object that holds a LuaFunction
+           whose closure holds the userdata of the CLI object) is garbage to neither collector.
+
+           A cross-heap collection breaks such cycles.  With the Lua state locked, the Lua objects are traversed
+           from the roots of the Lua state other than the table of references held by LuaBase objects, treating the
+           entries of weak tables as strong; the CLI objects found are kept strongly.  Every other CLI object is
+           held weakly while the CLR collects garbage, and the owner of each reference held by live LuaBase objects
+           holds strongly, for the duration, the CLI objects (and the owners of other references) that its Lua
+           value reaches.  The weak tables of the translator itself are not traced, since their owners are held by
+           the translator: the table of userdatas is only read for CLI objects that survive, and the entries of the
+           tables with weak keys are reached only through their keys.  So the CLR collects exactly
+           the CLI objects that neither the CLR nor the Lua state would keep alive if each could see through the
+           other.  A collected CLI object leaves its slot holding a marker until Lua collects its userdata, which
+           it does once the finalizers of the LuaBase objects of the cycle have unreferenced their Lua values. */
+
+        /// <summary>
+        /// The number of CLI objects at which a cross-heap collection runs automatically, or 0 if it does not.
+        /// </summary>
+        [SecurityCritical]
+        private int _crossHeapCollectionThreshold = 0;
+
+        /// <summary>
+        /// The number of CLI objects at which the next automatic cross-heap collection runs.
+        /// </summary>
+        [SecurityCritical]
+        private int _crossHeapCollectionTrigger = 0;
+
+        [SecurityCritical]
+        private bool _crossHeapCollectionDue = false;
+
+        /// <summary>
+        /// Marks a slot of the object table whose CLI object was collected by a cross-heap collection.
+        /// </summary>
+        private sealed class CollectedObject
+        {
+        }
+
+        private static readonly CollectedObject _collectedObject = new CollectedObject();
+
+        /// <summary>
+        /// The CLI objects held weakly during a cross-heap collection.
+        /// </summary>
+        private sealed class CrossHeapCollection
+        {
+            internal int[] _tracedRefs;
+
+            internal int[] _slots;
+
+            internal GCHandle[] _handles;
+
+            internal bool[] _hadUserDataRefs;
+
+            internal UserDataRef[] _userDataRefs;
+
+            /// <summary>
+            /// The number of slots that have been made weak.
+            /// </summary>
+            internal int _weakCount;
+        }
+
+        /// <summary>
+        /// Gets or sets the number of CLI objects at which a cross-heap collection runs automatically, or 0 if
+        /// it does not.
+        /// </summary>
+        internal int CrossHeapCollectionThreshold
+        {
+            [SecurityCritical]
+            get { return _crossHeapCollectionThreshold; }
+
+            [SecurityCritical]
+            set
+            {
+                _crossHeapCollectionThreshold = value;
+                _crossHeapCollectionTrigger = value;
+                _crossHeapCollectionDue = value > 0 && _objectCount >= value;
+            }
+        }
+
+        /// <summary>
+        /// Notes that the object table has grown, so that an automatic cross-heap collection runs when the
+        /// Lua state is next unlocked.
+        /// </summary>
+        [SecurityCritical]
+        private void CheckCrossHeapCollection()
+        {
+            if (_crossHeapCollectionThreshold > 0 && _objectCount >= _crossHeapCollectionTrigger)
+                _crossHeapCollectionDue = true;
+        }
+
+        /// <summary>
+        /// Runs a cross-heap collection if one is due; called while the Lua state is locked.
+        /// </summary>
+        [SecurityCritical]
+        private void RunDueCrossHeapCollection()
+        {
+            if (!_crossHeapCollectionDue)
+                return;
+
+            _crossHeapCollectionDue = false;
+
+            CollectCrossHeapCycles();
+        }
+
+        /// <summary>
+        /// Breaks the cycles of references between CLI objects referenced by the Lua state and Lua values
+        /// referenced by the CLR, by collecting the CLI objects that only such cycles keep alive.
+        /// </summary>
+        /// <returns>The number of CLI objects released.</returns>
+        /// <remarks>
+        /// The caller must have locked the Lua state.  This performs a full, blocking CLR garbage collection.
+        /// </remarks>
+        [SecurityCritical]
+        internal int CollectCrossHeapCycles()
+        {
+            // nothing here may hold a CLI object or LuaBase, lest the CLR collection see it as reachable
+            CrossHeapCollection collection = BeginCrossHeapCollection();
+
+            int released;
+
+            try
+            {
+                GC.Collect();
+            }
+            finally
+            {
+                released = EndCrossHeapCollection(collection);
+            }
+
+            int surviving = _objectCount - released;
+            _crossHeapCollectionTrigger = (int)Math.Min(int.MaxValue, Math.Max(_crossHeapCollectionThreshold, 2L * surviving));
+
+            return released;
+        }
+
+        /// <summary>
+        /// Finds which CLI objects the Lua state keeps alive, and makes the others weak.
+        /// </summary>
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        [SecurityCritical]
+        private CrossHeapCollection BeginCrossHeapCollection()
+        {
+            var L = _mainL.Handle;
+
+            var tracedRefs = new List<int>();
+
+            var ephemeronRefs = new List<int>();
+
+            // the LuaBase objects of a reference whose handle is cleared are being finalized and cannot be used
+            for (int slot = 0; slot < _usedRefSlotCount; ++slot)
+            {
+                object owner = _refOwners[slot].IsAllocated ? _refOwners[slot].Target : null;
+
+                if (owner == null || owner == _objectUserDatas._refOwner)
+                    continue;
+
+                if (owner == _luaFunctionDelegates._refOwner || owner == _partialTargets._refOwner)
+                    ephemeronRefs.Add(slot);
+                else
+                    tracedRefs.Add(slot);
+            }
+
+            var collection = new CrossHeapCollection();
+            collection._tracedRefs = tracedRefs.ToArray();
+
+            var rooted = new bool[_usedObjectSlotCount];
+
+            using (var reach = new LuaReach())
+            {
+                reach.MarkEphemerons(L, _refTableRef, ephemeronRefs.ToArray());
+                reach.MarkRoots(L, new[] { _refTableRef }, _objectMetatableRef, _partialMetatableRef);
+                reach.MarkTraced(L, _refTableRef, collection._tracedRefs);
+
+                foreach (int slot in reach.GetSlots(-1))
+                    rooted[slot] = true;
+
+                // the owner of each reference keeps alive what its Lua value reaches
+                for (int i = 0; i < collection._tracedRefs.Length; ++i)
+                {
+                    var owner = _refOwners[collection._tracedRefs[i]].Target as RefOwner;
+                    if (owner == null)
+                        continue;
+
+                    var keepAlive = new List<object>();
+
+                    foreach (int slot in reach.GetSlots(i))
+                        if (!rooted[slot] && _objects[slot] != null)
+                            keepAlive.Add(_objects[slot]);
+
+                    foreach (int index in reach.GetReferences(i))
+                    {
+                        object other = _refOwners[collection._tracedRefs[index]].Target;
+                        if (other != null)
+                            keepAlive.Add(other);
+                    }
+
+                    owner._crossHeapKeepAlive = keepAlive.Count != 0 ? keepAlive.ToArray() : null;
+                }
+            }
+
+            var slots = new List<int>();
+
+            for (int slot = 0; slot < _usedObjectSlotCount; ++slot)
+                if (!rooted[slot] && _objects[slot] != null && !(_objects[slot] is CollectedObject))
+                    slots.Add(slot);
+
+            collection._slots = slots.ToArray();
+            collection._handles = new GCHandle[slots.Count];
+            collection._hadUserDataRefs = new bool[slots.Count];
+            collection._userDataRefs = new UserDataRef[slots.Count];
+
+            try
+            {
+                for (int i = 0; i < collection._slots.Length; ++i)
+                {
+                    int slot = collection._slots[i];
+                    object o = _objects[slot];
+
+                    collection._handles[i] = GCHandle.Alloc(o, GCHandleType.Weak);
+                    collection._weakCount = i + 1;
+
+                    UserDataRef userdataRef;
+                    if (_objectUserDataRefs.TryGetValue(o, out userdataRef))
+                    {
+                        _objectUserDataRefs.Remove(o);
+                        collection._hadUserDataRefs[i] = true;
+                        collection._userDataRefs[i] = userdataRef;
+                    }
+
+                    _objects[slot] = null;
+                }
+            }
+            catch
+            {
+                EndCrossHeapCollection(collection);
+                throw;
+            }
+
+            return collection;
+        }
+
+        /// <summary>
+        /// Makes the weak CLI objects that survived strong again, and marks the slots of those that did not.
+        /// </summary>
+        /// <returns>The number of CLI objects that did not survive.</returns>
+        [MethodImpl(MethodImplOptions.NoInlining)]
+        [SecurityCritical]
+        private int EndCrossHeapCollection( CrossHeapCollection collection )
+        {
+            int released = 0;
+
+            for (int i = 0; i < collection._weakCount; ++i)
+            {
+                int slot = collection._slots[i];
+                object o = collection._handles[i].Target;
+                collection._handles[i].Free();
+
+                if (o != null)
+                {
+                    _objects[slot] = o;
+
+                    if (collection._hadUserDataRefs[i])
+                        _objectUserDataRefs[o] = collection._userDataRefs[i];
+                }
+                else
+                {
+                    _objects[slot] = _collectedObject;
+                    ++released;
+                }
+            }
+
+            collection._weakCount = 0;
+
+            foreach (int reference in collection._tracedRefs)
+            {
+                var owner = _refOwners[reference].IsAllocated ? _refOwners[reference].Target as RefOwner : null;
+                if (owner != null)
+                    owner._crossHeapKeepAlive = null;
+            }
+
+            return released;
+        }
+    }
+}
@@ -0,0 +1,195 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Concurrent;
+    using System.Security;
+    using System.Threading;
+    using Lua;
+
+    internal partial class ObjectTranslator
+    {
+        /// <summary>
+        /// The most slots of the table of references cleared by one native call.
+        /// </summary>
+        private const int _unrefBatchSize = 256;
+
+        private const int _defaultDeferredUnrefBudget = 4 * _unrefBatchSize;
+
+        /// <summary>
+        /// The slots of the Lua objects that will be unreferenced when the Lua state is not in use.
+        /// </summary>
+        /// <remarks>
+        /// When a <see cref="LuaBase"/> is finalized, it must unreference the Lua object so that the Lua
+        /// object becomes eligible for collection by the Lua garbage collector.  The Lua state must be
+        /// locked in order to unreference the object.  In order to avoid blocking the CLR finalizer thread,
+        /// if the Lua state is locked when the finalizer runs then unreferencing is deferred until later
+        /// (and on some other thread).
+        /// </remarks>
+        [SecurityCritical]
+        private ConcurrentQueue<int> _deferredUnrefs = new ConcurrentQueue<int>();
+
+        /// <summary>
+        /// The number of deferred unreferences not yet done.
+        /// </summary>
+        private int _deferredUnrefCount = 0;
+
+        private int _peakDeferredUnrefCount = 0;
+
+        private long _totalDeferredUnrefCount = 0;
+
+        /// <summary>
+        /// The most deferred unreferences done each time the Lua state is unlocked.
+        /// </summary>
+        [SecurityCritical]
+        private int _deferredUnrefBudget = _defaultDeferredUnrefBudget;
+
+        /// <summary>
+        /// The freed slots of the batch being cleared.
+        /// </summary>
+        [SecurityCritical]
+        private readonly int[] _unrefBatch = new int[_unrefBatchSize];
+
+        /// <summary>
+        /// The method called, on the thread that deferred an unreference, when a full batch of deferred
+        /// unreferences is waiting; or <c>null</c>.  It is not called again until
+        /// <see cref="DrainBackloggedDeferredUnrefs"/> has run.
+        /// </summary>
+        internal Action _deferredUnrefsBacklogged;
+
+        private int _deferredUnrefsBackloggedSignaled = 0;
+
+        /// <summary>
+        /// Gets the number of deferred unreferences not yet done.
+        /// </summary>
+        internal int DeferredUnrefCount
+        {
+            get { return Thread.VolatileRead(ref _deferredUnrefCount); }
+        }
+
+        /// <summary>
+        /// Gets the most deferred unreferences that have been waiting at once.
+        /// </summary>
+        internal int PeakDeferredUnrefCount
+        {
+            get { return Thread.VolatileRead(ref _peakDeferredUnrefCount); }
+        }
+
+        /// <summary>
+        /// Gets the number of unreferences that have been deferred.
+        /// </summary>
+        internal long TotalDeferredUnrefCount
+        {
+            get { return Interlocked.Read(ref _totalDeferredUnrefCount); }
+        }
+
+        /// <summary>
+        /// Gets or sets the most deferred unreferences done each time the Lua state is unlocked.
+        /// </summary>
+        internal int DeferredUnrefBudget
+        {
+            [SecurityCritical]
+            get { return _deferredUnrefBudget; }
+
+            [SecurityCritical]
+            set { _deferredUnrefBudget = value; }
+        }
+
+        [SecurityCritical]
+        internal void DeferUnref( int slot )
+        {
+            _deferredUnrefs.Enqueue(slot);
+
+            Interlocked.Increment(ref _totalDeferredUnrefCount);
+            int count = Interlocked.Increment(ref _deferredUnrefCount);
+
+            int peak;
+            while (count > (peak = _peakDeferredUnrefCount) &&
+                   Interlocked.CompareExchange(ref _peakDeferredUnrefCount, count, peak) != peak)
+            {
+            }
+
+            if (count >= _unrefBatchSize)
+                SignalDeferredUnrefsBacklogged();
+        }
+
+        [SecurityCritical]
+        private void SignalDeferredUnrefsBacklogged()
+        {
+            var backlogged = _deferredUnrefsBacklogged;
+
+            if (backlogged != null && Interlocked.CompareExchange(ref _deferredUnrefsBackloggedSignaled, 1, 0) == 0)
+                backlogged();
+        }
+
+        /// <summary>
+        /// Does deferred unreferences until the budget is spent or none are waiting, clearing the slots that
+        /// they free in batches of one native call each.  The caller must have locked the Lua state.
+        /// </summary>
+        /// <param name="budget">The most unreferences to do.</param>
+        /// <returns>The number of unreferences done.</returns>
+        [SecurityCritical]
+        internal int DrainDeferredUnrefs( int budget )
+        {
+            var L = _mainL.Handle;
+
+            int drained = 0;
+            int batched = 0;
+
+            try
+            {
+                int slot;
+                while (drained < budget && _deferredUnrefs.TryDequeue(out slot))
+                {
+                    ++drained;
+
+                    // a slot shared with other LuaBase objects is not freed
+                    if (!ReleaseRefSlot(slot))
+                        continue;
+
+                    _unrefBatch[batched++] = slot;
+
+                    if (batched == _unrefBatch.Length)
+                    {
+                        LuaWrapper.luaW_clearrefs(L, _refTableRef, _unrefBatch, batched);
+                        batched = 0;
+                    }
+                }
+
+                LuaWrapper.luaW_clearrefs(L, _refTableRef, _unrefBatch, batched);
+            }
+            finally
+            {
+                Interlocked.Add(ref _deferredUnrefCount, -drained);
+            }
+
+            return drained;
+        }
+
+        /// <summary>
+        /// Does a batch of deferred unreferences after <see cref="_deferredUnrefsBacklogged"/> was called,
+        /// and calls it again if a full batch is still waiting.  The caller must have locked the Lua state.
+        /// </summary>
+        [SecurityCritical]
+        internal void DrainBackloggedDeferredUnrefs()
+        {
+            Interlocked.Exchange(ref _deferredUnrefsBackloggedSignaled, 0);
+
+            if (_disposed)
+                return;
+
+            DrainDeferredUnrefs(_unrefBatchSize);
+
+            if (DeferredUnrefCount >= _unrefBatchSize)
+                SignalDeferredUnrefsBacklogged();
+        }
+    }
+}
@@ -0,0 +1,170 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Linq.Expressions;
+    using System.Reflection;
+    using System.Security;
+
+    internal partial class ObjectTranslator
+    {
+        /* Getting and setting fields and properties through FieldInfo and MethodInfo.Invoke is late-bound and
+           performs argument and access checks on every call.  Instead, strongly-typed accessors are compiled
+           once per resolved member and cached alongside the member resolution.  Members that cannot be
+           accessed safely through a compiled accessor fall back to reflection (null accessor). */
+
+        /// <summary>
+        /// Compiles a delegate that gets the value of a field or property.
+        /// </summary>
+        /// <param name="member">The field or property.</param>
+        /// <returns>The getter; or <c>null</c> if the member must be gotten through reflection.</returns>
+        [SecurityCritical]
+        private static Func<object, object> CompileGetter( MemberInfo member )
+        {
+            ParameterExpression selfExpr = Expression.Parameter(typeof(object), "self");
+
+            Expression valueExpr;
+
+            switch (member.MemberType)
+            {
+                case MemberTypes.Field:
+                    FieldInfo field = member as FieldInfo;
+
+                    if (field.IsLiteral)
+                    {
+                        // constants have no storage; the value never changes
+                        object constant = field.GetValue(null);
+                        return self => constant;
+                    }
+
+                    if (!CanCompileAccessor(field, field.FieldType))
+                        return null;
+
+                    valueExpr = Expression.Field(field.IsStatic ? null : ConvertSelf(selfExpr, field.DeclaringType), field);
+                    break;
+
+                case MemberTypes.Property:
+                    PropertyInfo property = member as PropertyInfo;
+
+                    MethodInfo getMethod = property.GetGetMethod(nonPublic: false);
+                    if (getMethod == null)
+                        return null;  // not get-accessible; reported by reflection path
+
+                    if (!CanCompileAccessor(property, property.PropertyType))
+                        return null;
+
+                    valueExpr = Expression.Call(getMethod.IsStatic ? null : ConvertSelf(selfExpr, property.DeclaringType), getMethod);
+                    break;
+
+                default:
+                    return null;
+            }
+
+            Expression body = Expression.Convert(valueExpr, typeof(object));
+
+            return Expression.Lambda<Func<object, object>>(body, selfExpr).Compile();
+        }
+
+        /// <summary>
+        /// Compiles a delegate that sets the value of a field or property.
+        /// </summary>
+        /// <param name="member">The field or property.</param>
+        /// <returns>The setter; or <c>null</c> if the member must be set through reflection.</returns>
+        /// <remarks>
+        /// The value passed to the setter must already have been changed to the type of the member.
+        /// </remarks>
+        [SecurityCritical]
+        private static Action<object, object> CompileSetter( MemberInfo member )
+        {
+            ParameterExpression selfExpr = Expression.Parameter(typeof(object), "self");
+            ParameterExpression valueExpr = Expression.Parameter(typeof(object), "value");
+
+            Expression body;
+
+            switch (member.MemberType)
+            {
+                case MemberTypes.Field:
+                    FieldInfo field = member as FieldInfo;
+
+                    if (field.IsLiteral || field.IsInitOnly)
+                        return null;
+
+                    // an instance of a value type must be modified in place in its box
+                    if (!field.IsStatic && field.DeclaringType.IsValueType)
+                        return null;
+
+                    if (!CanCompileAccessor(field, field.FieldType))
+                        return null;
+
+                    body = Expression.Assign(
+                        Expression.Field(field.IsStatic ? null : ConvertSelf(selfExpr, field.DeclaringType), field),
+                        Expression.Convert(valueExpr, field.FieldType));
+                    break;
+
+                case MemberTypes.Property:
+                    PropertyInfo property = member as PropertyInfo;
+
+                    MethodInfo setMethod = property.GetSetMethod(nonPublic: false);
+                    if (setMethod == null)
+                        return null;  // not set-accessible; reported by reflection path
+
+                    // an instance of a value type must be modified in place in its box
+                    if (!setMethod.IsStatic && property.DeclaringType.IsValueType)
+                        return null;
+
+                    if (!CanCompileAccessor(property, property.PropertyType))
+                        return null;
+
+                    body = Expression.Call(
+                        setMethod.IsStatic ? null : ConvertSelf(selfExpr, property.DeclaringType),
+                        setMethod,
+                        Expression.Convert(valueExpr, property.PropertyType));
+                    break;
+
+                default:
+                    return null;
+            }
+
+            return Expression.Lambda<Action<object, object>>(body, selfExpr, valueExpr).Compile();
+        }
+
+        /// <summary>
+        /// Determines whether a field or property can be accessed through a compiled accessor.
+        /// </summary>
+        /// <param name="member">The field or property.</param>
+        /// <param name="memberType">The type of the field or property.</param>
+        /// <returns><c>true</c> if a compiled accessor can be used; otherwise, <c>false</c>.</returns>
+        private static bool CanCompileAccessor( MemberInfo member, Type memberType )
+        {
+            Type declaringType = member.DeclaringType;
+
+            // compiled accessors are not granted access to non-visible types
+            if (!declaringType.IsVisible || !memberType.IsVisible)
+                return false;
+
+            if (declaringType.ContainsGenericParameters || memberType.IsPointer || memberType.IsByRef)
+                return false;
+
+            // fields of marshal-by-reference objects may be remote
+            if (member.MemberType == MemberTypes.Field && typeof(MarshalByRefObject).IsAssignableFrom(declaringType))
+                return false;
+
+            return true;
+        }
+
+        private static Expression ConvertSelf( ParameterExpression selfExpr, Type declaringType )
+        {
+            return declaringType.IsValueType ?
+                Expression.Unbox(selfExpr, declaringType) :
+                Expression.Convert(selfExpr, declaringType);
+        }
+    }
+}
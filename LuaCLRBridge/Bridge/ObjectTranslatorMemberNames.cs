@@ -0,0 +1,123 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Generic;
+    using System.Diagnostics;
+    using System.Security;
+    using Lua;
+
+    internal partial class ObjectTranslator
+    {
+        /* Indexing a CLI object from Lua would otherwise decode the name of the member into a new string every
+           time.  Instead, the names are kept in a Lua table that maps each Lua string to the index of the string
+           that was decoded from it the first time.  Lua strings are interned, so the lookup does not compare
+           characters, and the member-resolution caches then find the same string instance by reference.  A name
+           is kept only once it has resolved to a member, so names that are misspelled or missing (which the
+           member-resolution caches also do not keep) never take the place of the names of members. */
+
+        /// <summary>
+        /// The maximum number of member names that are kept, so that the names of arbitrarily many members
+        /// cannot grow the tables without bound.
+        /// </summary>
+        private const int _maxMemberNameCount = 4096;
+
+        /// <summary>
+        /// The Lua table that maps member names to their indices in <see cref="_memberNameStrings"/>.
+        /// </summary>
+        private LuaTable _memberNames;
+
+        /// <summary>
+        /// The member names that have been decoded from Lua strings.
+        /// </summary>
+        [SecurityCritical]
+        private readonly List<string> _memberNameStrings = new List<string>();
+
+        [SecurityCritical]
+        private void InitializeMemberNames( IntPtr L )
+        {
+            CheckStack(L, 1);
+
+            LuaWrapper.lua_newtable(L);
+            _memberNames = new LuaTable(this, L, -1);
+            LuaWrapper.lua_pop(L, 1);
+        }
+
+        /// <summary>
+        /// Gets the number of member names that are kept.
+        /// </summary>
+        internal int MemberNameCount
+        {
+            [SecurityCritical]
+            get { return _memberNameStrings.Count; }
+        }
+
+        /// <summary>
+        /// Retrieves the name of a member from a Lua string in the stack of a Lua state.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="index">The absolute index in the stack of the Lua string.</param>
+        /// <param name="kept"><c>true</c> if the name was kept; otherwise, <c>false</c>, and the name should
+        ///     be kept by <see cref="KeepMemberName"/> once it resolves to a member.</param>
+        /// <returns>The name of the member.</returns>
+        /// <remarks>
+        /// This method assumes that there are two free stack slots in the stack.
+        /// </remarks>
+        [SecurityCritical]
+        private string ToMemberName( IntPtr L, int index, out bool kept )
+        {
+            Debug.Assert(LuaWrapper.lua_type(L, index) == LuaType.LUA_TSTRING, "Member name should be a string.");
+
+            _memberNames.Push(L);
+            LuaWrapper.lua_pushvalue(L, index);
+            LuaWrapper.lua_rawget(L, -2);
+
+            if (LuaWrapper.lua_type(L, -1) == LuaType.LUA_TNUMBER)
+            {
+                int nameIndex = LuaWrapper.lua_tointeger(L, -1);
+                LuaWrapper.lua_pop(L, 2); // nameIndex, memberNames
+
+                kept = true;
+                return _memberNameStrings[nameIndex];
+            }
+
+            LuaWrapper.lua_pop(L, 2); // nil, memberNames
+
+            UIntPtr len;
+            kept = false;
+            return LuaWrapper.lua_tolstring(L, index, out len, _encoding);
+        }
+
+        /// <summary>
+        /// Keeps the name of a member, retrieved by <see cref="ToMemberName"/>, that has resolved to a member.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="index">The absolute index in the stack of the Lua string.</param>
+        /// <param name="name">The name of the member decoded from the Lua string.</param>
+        /// <remarks>
+        /// This method assumes that there are three free stack slots in the stack.
+        /// </remarks>
+        [SecurityCritical]
+        private void KeepMemberName( IntPtr L, int index, string name )
+        {
+            if (_memberNameStrings.Count >= _maxMemberNameCount)
+                return;
+
+            _memberNames.Push(L);
+            LuaWrapper.lua_pushvalue(L, index);
+            LuaWrapper.lua_pushinteger(L, _memberNameStrings.Count);
+            LuaWrapper.lua_rawset(L, -3);
+            LuaWrapper.lua_pop(L, 1); // memberNames
+
+            _memberNameStrings.Add(name);
+        }
+    }
+}
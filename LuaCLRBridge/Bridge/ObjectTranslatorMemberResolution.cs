@@ -0,0 +1,320 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Generic;
+    using System.Diagnostics;
+    using System.Linq;
+    using System.Reflection;
+    using System.Security;
+
+    internal partial class ObjectTranslator
+    {
+        /* Resolving a member by name requires a reflection scan of the type, filtering by binding hints, and
+           removal of hidden members.  The outcome depends only on the type, the name, whether the access is
+           static, whether the member is being gotten or set, and the binding hints, so it is cached per
+           binding-hints instance.  The cache of the default binding hints is shared by all Lua states. */
+
+        /// <summary>
+        /// Gets the resolution of the members of a type that may be gotten by a specified name.
+        /// </summary>
+        /// <param name="type">The type whose members are being resolved.</param>
+        /// <param name="isStatic">Whether static (<c>true</c>) or instance (<c>false</c>) members are being
+        ///     resolved.</param>
+        /// <param name="hints">The member-binding hints, or <c>null</c> for the default hints.</param>
+        /// <param name="name">The name of the members.</param>
+        /// <returns>The (possibly cached) resolution of the members.</returns>
+        [SecurityCritical]
+        private static ResolvedMembers ResolveGetMembers( Type type, bool isStatic, MemberBindingHints hints, string name )
+        {
+            if (hints == null)
+                hints = MemberBindingHints.DefaultHints;
+
+            var key = new MemberResolutionKey(type, name, isStatic, isSet: false);
+
+            ResolvedMembers resolved;
+            if (hints._resolvedMembers.TryGetValue(key, out resolved))
+                return resolved;
+
+            resolved = ResolveGetMembersUncached(type, isStatic, hints, name);
+
+            // missing members are not cached so that arbitrary index strings cannot grow the cache
+            if (resolved._resolution != MemberResolution.Missing)
+                resolved = hints._resolvedMembers.GetOrAdd(key, resolved);
+
+            return resolved;
+        }
+
+        /// <summary>
+        /// Gets the resolution of the members of a type that may be set by a specified name.
+        /// </summary>
+        /// <param name="type">The type whose members are being resolved.</param>
+        /// <param name="isStatic">Whether static (<c>true</c>) or instance (<c>false</c>) members are being
+        ///     resolved.</param>
+        /// <param name="hints">The member-binding hints, or <c>null</c> for the default hints.</param>
+        /// <param name="name">The name of the members.</param>
+        /// <returns>The (possibly cached) resolution of the members.</returns>
+        [SecurityCritical]
+        private static ResolvedMembers ResolveSetMembers( Type type, bool isStatic, MemberBindingHints hints, string name )
+        {
+            if (hints == null)
+                hints = MemberBindingHints.DefaultHints;
+
+            var key = new MemberResolutionKey(type, name, isStatic, isSet: true);
+
+            ResolvedMembers resolved;
+            if (hints._resolvedMembers.TryGetValue(key, out resolved))
+                return resolved;
+
+            resolved = ResolveSetMembersUncached(type, isStatic, hints, name);
+
+            // missing members are not cached so that arbitrary index strings cannot grow the cache
+            if (resolved._resolution != MemberResolution.Missing)
+                resolved = hints._resolvedMembers.GetOrAdd(key, resolved);
+
+            return resolved;
+        }
+
+        [SecurityCritical]
+        private static ResolvedMembers ResolveGetMembersUncached( Type type, bool isStatic, MemberBindingHints hints, string name )
+        {
+            BindingFlags bindingFlags = (isStatic ? BindingFlags.Static : BindingFlags.Instance) |
+                (LuaHideInheritedMembersAttribute.IsDefinedOn(type) ? BindingFlags.DeclaredOnly : BindingFlags.Default);
+            IEnumerable<MemberInfo> membersTemp = type.GetMember(name,
+                hints.GetMemberTypes & (isStatic ? MemberTypes.All : ~MemberTypes.NestedType),  // hide NestedTypes if instance
+                BindingFlags.Public | bindingFlags);
+
+            membersTemp = hints.SelectHintedMembers(membersTemp);
+
+            MemberInfo[] members = LuaBinder.RemoveHidden(membersTemp);
+
+            if (members.Length == 0)
+                return new ResolvedMembers(MemberResolution.Missing, String.Format("'{1}' is not a member of type '{0}'", type, name));
+
+            int partialMemberCount = members.Count(member =>
+                member.MemberType == MemberTypes.Event ||
+                member.MemberType == MemberTypes.Method ||
+                (member.MemberType == MemberTypes.Property && (member as PropertyInfo).GetIndexParameters().Length > 0));
+
+            // wrapper around partially-resolved members
+            if (partialMemberCount > 0)
+            {
+                if (partialMemberCount != members.Length)
+                    return new ResolvedMembers(MemberResolution.Ambiguous, String.Format("'{0}.{1}' designates ambiguous members", type, name));
+
+                return new ResolvedMembers(MemberResolution.Partial, members);
+            }
+
+            LuaBinder binder = LuaBinder.Instance;
+
+            MemberInfo boundMember;
+
+            try
+            {
+                int nestedTypeMemberCount = members.Count(member_ => member_.MemberType == MemberTypes.NestedType);
+
+                if (nestedTypeMemberCount > 0)
+                {
+                    if (nestedTypeMemberCount != members.Length)
+                        throw new AmbiguousMatchException();  // caught below
+
+                    if (members.Length > 1)
+                        throw new AmbiguousMatchException();  // caught below
+
+                    boundMember = members[0];
+                }
+                else
+                {
+                    object value = null;
+                    boundMember = binder.BindToFieldOrProperty(BindingFlags.GetField | BindingFlags.GetProperty, members, ref value, null);
+                }
+            }
+            catch (AmbiguousMatchException)
+            {
+                return new ResolvedMembers(MemberResolution.Ambiguous, String.Format("'{1}' designates ambiguous members of type '{0}'", type, name));
+            }
+            catch (MissingMemberException)
+            {
+                Debug.Assert(false, "Get binding should always match some member");
+                throw new InvalidOperationException("Should never happen!");
+            }
+
+            return new ResolvedMembers(MemberResolution.Gettable, new[] { boundMember });
+        }
+
+        [SecurityCritical]
+        private static ResolvedMembers ResolveSetMembersUncached( Type type, bool isStatic, MemberBindingHints hints, string name )
+        {
+            BindingFlags bindingFlags = (isStatic ? BindingFlags.Static : BindingFlags.Instance) |
+                (LuaHideInheritedMembersAttribute.IsDefinedOn(type) ? BindingFlags.DeclaredOnly : BindingFlags.Default);
+            IEnumerable<MemberInfo> membersTemp = type.GetMember(name,
+                hints.SetMemberTypes,
+                BindingFlags.Public | bindingFlags);
+
+            membersTemp = hints.SelectHintedMembers(membersTemp);
+
+            MemberInfo[] members = LuaBinder.RemoveHidden(membersTemp);
+
+            if (members.Length == 0)
+                return new ResolvedMembers(MemberResolution.Missing, String.Format("'{1}' is not a member of type '{0}'", type, name));
+
+            int partialMemberCount = members.Count(member =>
+                member.MemberType == MemberTypes.Property && (member as PropertyInfo).GetIndexParameters().Length > 0);
+
+            // if setting partially-resolved member, fail
+            // (setting indexed properties happens through getMember)
+            if (partialMemberCount > 0)
+            {
+                if (partialMemberCount != members.Length)
+                    return new ResolvedMembers(MemberResolution.Ambiguous, String.Format("'{0}.{1}' designates ambiguous members", type, name));
+
+                return new ResolvedMembers(MemberResolution.Unassignable, String.Format("'{1}' is not an assignable member of type '{0}'", type, name));
+            }
+
+            // binding depends on the type of the value being set, so it happens on each set
+            return new ResolvedMembers(MemberResolution.Settable, members);
+        }
+
+        /// <summary>
+        /// Classifies the outcome of resolving members by name.
+        /// </summary>
+        private enum MemberResolution
+        {
+            /// <summary>No member has the name.</summary>
+            Missing,
+
+            /// <summary>The name designates members that cannot be discriminated.</summary>
+            Ambiguous,
+
+            /// <summary>The name designates indexed properties, which cannot be assigned.</summary>
+            Unassignable,
+
+            /// <summary>The name designates methods, events, or indexed properties that require further
+            /// discrimination.</summary>
+            Partial,
+
+            /// <summary>The name designates a single field, property, or nested type.</summary>
+            Gettable,
+
+            /// <summary>The name designates fields or properties; binding depends on the assigned
+            /// value.</summary>
+            Settable,
+        }
+
+        /// <summary>
+        /// Represents the immutable outcome of resolving members by name.
+        /// </summary>
+        private sealed class ResolvedMembers
+        {
+            internal readonly MemberResolution _resolution;
+            internal readonly MemberInfo[] _members;
+            private readonly string _message;
+
+            /// <summary>
+            /// The compiled getter of a <see cref="MemberResolution.Gettable"/> resolution; or <c>null</c>
+            /// if the member must be gotten through reflection.
+            /// </summary>
+            internal readonly Func<object, object> _getter;
+
+            /// <summary>
+            /// The compiled setters of the members of a <see cref="MemberResolution.Settable"/> resolution;
+            /// each is <c>null</c> if the member must be set through reflection.
+            /// </summary>
+            internal readonly Action<object, object>[] _setters;
+
+            [SecurityCritical]
+            internal ResolvedMembers( MemberResolution resolution, MemberInfo[] members )
+            {
+                this._resolution = resolution;
+                this._members = members;
+
+                if (resolution == MemberResolution.Gettable)
+                    this._getter = CompileGetter(members[0]);
+                else if (resolution == MemberResolution.Settable)
+                    this._setters = Array.ConvertAll(members, CompileSetter);
+            }
+
+            internal ResolvedMembers( MemberResolution resolution, string message )
+            {
+                this._resolution = resolution;
+                this._message = message;
+            }
+
+            /// <summary>
+            /// Gets the single member designated by a <see cref="MemberResolution.Gettable"/> resolution.
+            /// </summary>
+            internal MemberInfo Member
+            {
+                get { return _members[0]; }
+            }
+
+            /// <summary>
+            /// Creates the exception that describes why the members could not be resolved.
+            /// </summary>
+            /// <returns>The exception to be thrown.</returns>
+            internal Exception CreateException()
+            {
+                switch (_resolution)
+                {
+                    case MemberResolution.Missing:
+                        return new MissingMemberException(_message);
+
+                    case MemberResolution.Ambiguous:
+                        return new AmbiguousMatchException(_message);
+
+                    case MemberResolution.Unassignable:
+                        return new TargetException(_message);
+
+                    default:
+                        return new InvalidOperationException("Should never happen!");
+                }
+            }
+        }
+
+        /// <summary>
+        /// Identifies a resolution of members by name.
+        /// </summary>
+        private struct MemberResolutionKey : IEquatable<MemberResolutionKey>
+        {
+            private readonly Type _type;
+            private readonly string _name;
+            private readonly bool _isStatic;
+            private readonly bool _isSet;
+
+            internal MemberResolutionKey( Type type, string name, bool isStatic, bool isSet )
+            {
+                this._type = type;
+                this._name = name;
+                this._isStatic = isStatic;
+                this._isSet = isSet;
+            }
+
+            public bool Equals( MemberResolutionKey other )
+            {
+                return _type == other._type &&
+                    _isStatic == other._isStatic &&
+                    _isSet == other._isSet &&
+                    String.Equals(_name, other._name, StringComparison.Ordinal);
+            }
+
+            public override bool Equals( object obj )
+            {
+                return obj is MemberResolutionKey && Equals((MemberResolutionKey)obj);
+            }
+
+            public override int GetHashCode()
+            {
+                int hash = _type.GetHashCode() * 31 + _name.GetHashCode();
+                return (hash << 2) | (_isStatic ? 2 : 0) | (_isSet ? 1 : 0);
+            }
+        }
+    }
+}
@@ -25,6 +25,24 @@ namespace LuaCLRBridge
 
         private const string _partialMetatableName = "CLI-partial";
 
+        /* The metatables are also referenced by integer in the registry so that pushing and checking a userdata
+           does not need to encode and look up the name of its metatable. */
+
+        [SecurityCritical]
+        private int _objectMetatableRef;
+
+        [SecurityCritical]
+        private int _partialMetatableRef;
+
+        /// <summary>
+        /// Gets the reference in the registry of the metatable of userdatas of CLI objects.
+        /// </summary>
+        internal int ObjectMetatableRef
+        {
+            [SecurityCritical]
+            get { return _objectMetatableRef; }
+        }
+
         /* The metamethod delegates must not be garbage collected until after the Lua state is closed.  Of
            particular importance is the GarbageCollect delegate, which releases CLI objects held by the Lua
            state while it is closing. */
@@ -74,7 +92,7 @@ namespace LuaCLRBridge
             LuaWrapper.lua_pushstring(L, "__metatable", _encoding);
             LuaWrapper.lua_pushvalue(L, -3); // empty table
             LuaWrapper.lua_rawset(L, -3); // hide metatable
-            LuaWrapper.lua_pop(L, 1);
+            _objectMetatableRef = LuaWrapper.luaL_ref(L, LuaWrapper.LUA_REGISTRYINDEX);
 
             // create metatable for CLI partially-resolved methods and indexed properties
             LuaWrapper.luaL_newmetatable(L, _partialMetatableName, _encoding);
@@ -82,7 +100,7 @@ namespace LuaCLRBridge
             LuaWrapper.lua_pushstring(L, "__metatable", _encoding);
             LuaWrapper.lua_pushvalue(L, -3); // empty table
             LuaWrapper.lua_rawset(L, -3); // hide metatable
-            LuaWrapper.lua_pop(L, 1);
+            _partialMetatableRef = LuaWrapper.luaL_ref(L, LuaWrapper.LUA_REGISTRYINDEX);
 
             LuaWrapper.lua_pop(L, 1); // empty table
         }
@@ -376,8 +394,14 @@ namespace LuaCLRBridge
                 if (members.Length == 0)
                     throw new MissingMethodException();
 
+                BoundaryTiming timing = _boundaryTiming;
+                long start = timing != null ? BoundaryTiming.Now : 0;
+
                 object[] results = ObjectTranslator.InvokeMethod(null, name, methods, null, args);
 
+                if (timing != null)
+                    timing.Record(BoundaryKind.Operator, operandType, name, start);
+
                 LuaWrapper.lua_settop(L, 0);
                 CheckStack(L, results.Length);  // results
 
@@ -449,8 +473,14 @@ namespace LuaCLRBridge
                 if (members.Length == 0)
                     throw new MissingMethodException();
 
+                BoundaryTiming timing = _boundaryTiming;
+                long start = timing != null ? BoundaryTiming.Now : 0;
+
                 object[] results = ObjectTranslator.InvokeMethod(null, name, methods, null, args);
 
+                if (timing != null)
+                    timing.Record(BoundaryKind.Operator, lhsType ?? rhsType, name, start);
+
                 LuaWrapper.lua_settop(L, 0);
                 CheckStack(L, results.Length);  // results
 
@@ -490,30 +520,50 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int ObjectIndex( IntPtr L )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, 1, _objectMetatableName, _encoding);
+            // reuse the partially-resolved member if it was already gotten from this target
+            if (LuaWrapper.lua_type(L, 2) == LuaType.LUA_TSTRING && PushCachedPartialTarget(L, 1, 2))
+                return 1;
+
+            IntPtr udata = ToUserData(L, 1, _objectMetatableRef);
             Debug.Assert(udata != IntPtr.Zero, "Should only be invoked on appropriate userdata.");
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
+            object target = GetUserDataObject(udata);
 
             object self;
             Type type;
             MemberBindingHints hints;
-            UnwrapTarget(handle.Target, out self, out type, out hints);
-            object index = ToObject(L, 2);
+            UnwrapTarget(target, out self, out type, out hints);
+            bool kept = true;
+            object index = LuaWrapper.lua_type(L, 2) == LuaType.LUA_TSTRING ? ToMemberName(L, 2, out kept) : ToObject(L, 2);
 
             try
             {
                 if (index is string) // field, property, method
                 {
+                    BoundaryTiming timing = _boundaryTiming;
+                    long start = timing != null ? BoundaryTiming.Now : 0;
+
                     object result = GetMember(type, self, hints, index as string);
 
+                    if (!kept)
+                        KeepMemberName(L, 2, index as string);
+
+                    if (result is PartialTarget)
+                    {
+                        LuaWrapper.lua_settop(L, 2);
+
+                        PushUntranslatedObject(L, result, _partialMetatableRef);
+                        StorePartialTarget(L, 1, 2);
+                        return 1;
+                    }
+
+                    if (timing != null)
+                        timing.Record(BoundaryKind.Get, type, index as string, start);
+
                     LuaWrapper.lua_settop(L, 0);
                     /* no stack check -- not more results than arguments */
 
-                    if (result is PartialTarget)
-                        PushUntranslatedObject(L, result, _partialMetatableName);
-                    else
-                        PushObject(L, result);
+                    PushObject(L, result);
                     return 1;
                 }
                 else if (self is Array) // array indexer
@@ -544,83 +594,29 @@ namespace LuaCLRBridge
         {
             Debug.Assert(self == null || type.IsInstanceOfType(self), "Type should match object.");
 
-            if (hints == null)
-                hints = MemberBindingHints.DefaultHints;
-
-            BindingFlags bindingFlags = (self == null ? BindingFlags.Static : BindingFlags.Instance) |
-                (LuaHideInheritedMembersAttribute.IsDefinedOn(type) ? BindingFlags.DeclaredOnly : BindingFlags.Default);
-            IEnumerable<MemberInfo> membersTemp = type.GetMember(name,
-                hints.GetMemberTypes & (self == null ? MemberTypes.All : ~MemberTypes.NestedType),  // hide NestedTypes if instance
-                BindingFlags.Public | bindingFlags);
-
-            membersTemp = hints.SelectHintedMembers(membersTemp);
+            ResolvedMembers resolved = ResolveGetMembers(type, self == null, hints, name);
 
-            MemberInfo[] members = LuaBinder.RemoveHidden(membersTemp);
-
-            if (members.Length == 0)
-                goto notFound;
-
-            int partialMemberCount = members.Count(member =>
-                member.MemberType == MemberTypes.Event ||
-                member.MemberType == MemberTypes.Method ||
-                (member.MemberType == MemberTypes.Property && (member as PropertyInfo).GetIndexParameters().Length > 0));
-
-            // return wrapper around partially-resolved members
-            if (partialMemberCount > 0)
+            switch (resolved._resolution)
             {
-                if (partialMemberCount != members.Length)
-                    throw new AmbiguousMatchException(String.Format("'{0}.{1}' designates ambiguous members", type, name));
-
-                return new PartialTarget(type, name, members, self);
-            }
+                case MemberResolution.Partial:
+                    // return wrapper around partially-resolved members
+                    return new PartialTarget(type, name, resolved._members, self);
 
-            return InvokeGet(type, name, members, self);
+                case MemberResolution.Gettable:
+                    return InvokeGet(type, name, resolved, self);
 
-        notFound:
-            throw new MissingMemberException(String.Format("'{1}' is not a member of type '{0}'", type, name));
+                default:
+                    throw resolved.CreateException();
+            }
         }
 
         [SecurityCritical]
-        private static object InvokeGet( Type type, string name, MemberInfo[] members, object self )
+        private static object InvokeGet( Type type, string name, ResolvedMembers resolved, object self )
         {
-            Debug.Assert(members.Length != 0, "Cannot operate on zero members.");
-
-            LuaBinder binder = LuaBinder.Instance;
-
-            MemberInfo member;
-
-            try
-            {
-                int nestedTypeMemberCount = members.Count(member_ => member_.MemberType == MemberTypes.NestedType);
+            if (resolved._getter != null)
+                return resolved._getter(self);
 
-                if (members.Length == 0)
-                    throw new MissingMemberException();  // caught below
-
-                if (nestedTypeMemberCount > 0)
-                {
-                    if (nestedTypeMemberCount != members.Length)
-                        throw new AmbiguousMatchException();  // caught below
-
-                    if (members.Length > 1)
-                        throw new AmbiguousMatchException();  // caught below
-
-                    member = members[0];
-                }
-                else
-                {
-                    object value = null;
-                    member = binder.BindToFieldOrProperty(BindingFlags.GetField | BindingFlags.GetProperty, members, ref value, null);
-                }
-            }
-            catch (AmbiguousMatchException)
-            {
-                throw new AmbiguousMatchException(String.Format("'{1}' designates ambiguous members of type '{0}'", type, name));
-            }
-            catch (MissingMemberException)
-            {
-                Debug.Assert(false, "Get binding should always match some member");
-                throw new InvalidOperationException("Should never happen!");
-            }
+            MemberInfo member = resolved.Member;
 
             switch (member.MemberType)
             {
@@ -681,24 +677,34 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int ObjectNewIndex( IntPtr L )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, 1, _objectMetatableName, _encoding);
+            IntPtr udata = ToUserData(L, 1, _objectMetatableRef);
             Debug.Assert(udata != IntPtr.Zero, "Should only be invoked on appropriate userdata.");
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
+            object target = GetUserDataObject(udata);
 
             object self;
             Type type;
             MemberBindingHints hints;
-            UnwrapTarget(handle.Target, out self, out type, out hints);
-            object index = ToObject(L, 2);
+            UnwrapTarget(target, out self, out type, out hints);
+            bool kept = true;
+            object index = LuaWrapper.lua_type(L, 2) == LuaType.LUA_TSTRING ? ToMemberName(L, 2, out kept) : ToObject(L, 2);
             object value = ToObject(L, 3);
 
             try
             {
                 if (index is string) // field, property
                 {
+                    BoundaryTiming timing = _boundaryTiming;
+                    long start = timing != null ? BoundaryTiming.Now : 0;
+
                     SetMember(type, self, hints, index as string, value);
 
+                    if (!kept)
+                        KeepMemberName(L, 2, index as string);
+
+                    if (timing != null)
+                        timing.Record(BoundaryKind.Set, type, index as string, start);
+
                     LuaWrapper.lua_settop(L, 0);
                     return 0;
                 }
@@ -727,45 +733,19 @@ namespace LuaCLRBridge
         {
             Debug.Assert(self == null || type.IsInstanceOfType(self), "Type should match object.");
 
-            if (hints == null)
-                hints = MemberBindingHints.DefaultHints;
-
-            BindingFlags bindingFlags = (self == null ? BindingFlags.Static : BindingFlags.Instance) |
-                (LuaHideInheritedMembersAttribute.IsDefinedOn(type) ? BindingFlags.DeclaredOnly : BindingFlags.Default);
-            IEnumerable<MemberInfo> membersTemp = type.GetMember(name,
-                hints.SetMemberTypes,
-                BindingFlags.Public | bindingFlags);
-
-            membersTemp = hints.SelectHintedMembers(membersTemp);
-
-            MemberInfo[] members = LuaBinder.RemoveHidden(membersTemp);
-
-            if (members.Length == 0)
-                goto notFound;
-
-            int partialMemberCount = members.Count(member =>
-                member.MemberType == MemberTypes.Property && (member as PropertyInfo).GetIndexParameters().Length > 0);
-
-            // if setting partially-resolved member, fail
-            // (setting indexed properties happens through getMember)
-            if (partialMemberCount > 0)
-            {
-                if (partialMemberCount != members.Length)
-                    throw new AmbiguousMatchException(String.Format("'{0}.{1}' designates ambiguous members", type, name));
-
-                throw new TargetException(String.Format("'{1}' is not an assignable member of type '{0}'", type, name));
-            }
+            ResolvedMembers resolved = ResolveSetMembers(type, self == null, hints, name);
 
-            InvokeSet(type, name, members, self, value);
-            return;
+            if (resolved._resolution != MemberResolution.Settable)
+                throw resolved.CreateException();
 
-        notFound:
-            throw new MissingMemberException(String.Format("'{1}' is not a member of type '{0}'", type, name));
+            InvokeSet(type, name, resolved, self, value);
         }
 
         [SecurityCritical]
-        private static void InvokeSet( Type type, string name, MemberInfo[] members, object self, object value )
+        private static void InvokeSet( Type type, string name, ResolvedMembers resolved, object self, object value )
         {
+            MemberInfo[] members = resolved._members;
+
             Debug.Assert(members.Length != 0, "Cannot operate on zero members.");
 
             LuaBinder binder = LuaBinder.Instance;
@@ -786,6 +766,13 @@ namespace LuaCLRBridge
                 throw new InvalidCastException(String.Format("'{0}.{1}' cannot be assigned a value of type '{2}'", type, name, valueType));
             }
 
+            Action<object, object> setter = resolved._setters[Array.IndexOf(members, member)];
+            if (setter != null)
+            {
+                setter(self, value);
+                return;
+            }
+
             switch (member.MemberType)
             {
                 case MemberTypes.Field:
@@ -854,15 +841,15 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int ObjectCall( IntPtr L )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, 1, _objectMetatableName, _encoding);
+            IntPtr udata = ToUserData(L, 1, _objectMetatableRef);
             Debug.Assert(udata != IntPtr.Zero, "Should only be invoked on appropriate userdata.");
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
+            object target = GetUserDataObject(udata);
 
             object self;
             Type type;
             MemberBindingHints hints;
-            UnwrapTarget(handle.Target, out self, out type, out hints);
+            UnwrapTarget(target, out self, out type, out hints);
 
             try
             {
@@ -873,7 +860,6 @@ namespace LuaCLRBridge
                 {
                     LuaTable hintTable = ToObject(L, 2) as LuaTable;
 
-                    object target = handle.Target;
                     hints = new MemberBindingHints(hintTable, ref target);
 
                     LuaWrapper.lua_settop(L, 0);
@@ -900,7 +886,7 @@ namespace LuaCLRBridge
 
                 CheckStack(L, 1);
 
-                PushUntranslatedObject(L, result, _partialMetatableName);
+                PushUntranslatedObject(L, result, _partialMetatableRef);
                 LuaWrapper.lua_replace(L, 1);
             }
             catch (SEHException)
@@ -926,15 +912,15 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int ObjectToString( IntPtr L )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, 1, _objectMetatableName, _encoding);
+            IntPtr udata = ToUserData(L, 1, _objectMetatableRef);
             Debug.Assert(udata != IntPtr.Zero, "Should only be invoked on appropriate userdata.");
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
+            object target = GetUserDataObject(udata);
 
             object self;
             Type type;
             MemberBindingHints hints;
-            UnwrapTarget(handle.Target, out self, out type, out hints);
+            UnwrapTarget(target, out self, out type, out hints);
 
             try
             {
@@ -957,7 +943,7 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int ObjectGarbageCollect( IntPtr L )
         {
-            return GarbageCollect(L, _objectMetatableName);
+            return GarbageCollect(L, _objectMetatableRef);
         }
 
         private static void UnwrapTarget( object target, out object self, out Type type, out MemberBindingHints hints )
@@ -1049,12 +1035,12 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int PartialIndex( IntPtr L )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, 1, _partialMetatableName, _encoding);
+            IntPtr udata = ToUserData(L, 1, _partialMetatableRef);
             Debug.Assert(udata != IntPtr.Zero, "Should only be invoked on appropriate userdata.");
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
+            object target = GetUserDataObject(udata);
 
-            PartialTarget self = handle.Target as PartialTarget;
+            PartialTarget self = target as PartialTarget;
 
             MethodBase[] methods;
             object index = ToObject(L, 2);
@@ -1075,8 +1061,14 @@ namespace LuaCLRBridge
                     indexes.RawToArray() :
                     new object[] { index };
 
+                BoundaryTiming timing = _boundaryTiming;
+                long start = timing != null ? BoundaryTiming.Now : 0;
+
                 object[] results = InvokeMethod(self._type, "get_" + self._name, methods, self._self, args);
 
+                if (timing != null)
+                    timing.Record(BoundaryKind.Get, self._type, self._name, start);
+
                 Debug.Assert(results.Length == 1, "Property getter should have a single result.");
 
                 LuaWrapper.lua_settop(L, 0);
@@ -1104,12 +1096,12 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int PartialNewIndex( IntPtr L )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, 1, _partialMetatableName, _encoding);
+            IntPtr udata = ToUserData(L, 1, _partialMetatableRef);
             Debug.Assert(udata != IntPtr.Zero, "Should only be invoked on appropriate userdata.");
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
+            object target = GetUserDataObject(udata);
 
-            PartialTarget self = handle.Target as PartialTarget;
+            PartialTarget self = target as PartialTarget;
 
             MethodBase[] methods;
             object index = ToObject(L, 2);
@@ -1139,8 +1131,14 @@ namespace LuaCLRBridge
                     args = new object[] { index, value };
                 }
 
+                BoundaryTiming timing = _boundaryTiming;
+                long start = timing != null ? BoundaryTiming.Now : 0;
+
                 object[] results = InvokeMethod(self._type, "set_" + self._name, methods, self._self, args);
 
+                if (timing != null)
+                    timing.Record(BoundaryKind.Set, self._type, self._name, start);
+
                 Debug.Assert(results.Length == 0, "Property setter should have no results.");
 
                 LuaWrapper.lua_settop(L, 0);
@@ -1169,14 +1167,16 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int PartialCall( IntPtr L )
         {
-            IntPtr udata = LuaWrapper.luaL_testudata(L, 1, _partialMetatableName, _encoding);
-            Debug.Assert(udata != IntPtr.Zero, "Should only be invoked on appropriate userdata.");
+            // this is the path of every method call, so the userdata is not checked by name
+            IntPtr udata = LuaWrapper.lua_touserdata(L, 1);
+            Debug.Assert(udata == ToUserData(L, 1, _partialMetatableRef), "Should only be invoked on appropriate userdata.");
 
-            GCHandle handle = (GCHandle)Marshal.PtrToStructure(udata, typeof(GCHandle));
+            object target = GetUserDataObject(udata);
 
-            PartialTarget self = handle.Target as PartialTarget;
+            PartialTarget self = target as PartialTarget;
 
             MethodBase[] methods;
+            MethodInvoker invoker;
 
             try
             {
@@ -1186,21 +1186,34 @@ namespace LuaCLRBridge
                     LuaWrapper.lua_type(L, 2) == LuaType.LUA_TTABLE)
                 {
                     LuaTable hintTable = ToObject(L, 2) as LuaTable;
-                    self._hints = new SignatureBindingHints(hintTable);
+
+                    // the partially-resolved members may be shared, so they are not modified
+                    var hinted = new PartialTarget(self._type, self._name, self._members, self._self, new SignatureBindingHints(hintTable));
 
                     LuaWrapper.lua_settop(L, 0);
                     /* no stack check -- not more results than arguments */
 
-                    PushUntranslatedObject(L, self, _partialMetatableName);
+                    PushUntranslatedObject(L, hinted, _partialMetatableRef);
                     return 1;
                 }
 
-                IEnumerable<MethodBase> methodsTemp = self._members
-                    .Select(member => member as MethodBase)
-                    .Where(member => member != null);
+                methods = self.Methods;
+                invoker = self.Invoker;
 
-                methods = self._hints.SelectHintedMethods(methodsTemp)
-                    .ToArray();
+                if (invoker != null)
+                {
+                    BoundaryTiming timing = _boundaryTiming;
+                    long start = timing != null ? BoundaryTiming.Now : 0;
+
+                    int resultCount = invoker.Invoke(this, L, self._self);
+                    if (resultCount >= 0)
+                    {
+                        if (timing != null)
+                            timing.Record(BoundaryKind.Method, self._type, self._name, start);
+
+                        return resultCount;
+                    }
+                }
             }
             catch (SEHException)
             {
@@ -1226,8 +1239,14 @@ namespace LuaCLRBridge
                 for (int i = 0; i < argCount; ++i)
                     args[i] = ToObject(L, i + 2);
 
+                BoundaryTiming timing = _boundaryTiming;
+                long start = timing != null ? BoundaryTiming.Now : 0;
+
                 object[] results = InvokeMethod(type, name, methods, self, args);
 
+                if (timing != null)
+                    timing.Record(BoundaryKind.Method, type, name, start);
+
                 LuaWrapper.lua_settop(L, 0);
                 CheckStack(L, results.Length);  // results
 
@@ -1301,7 +1320,7 @@ namespace LuaCLRBridge
         [SecurityCritical]
         private int PartialGarbageCollect( IntPtr L )
         {
-            return GarbageCollect(L, _partialMetatableName);
+            return GarbageCollect(L, _partialMetatableRef);
         }
 
         [SecuritySafeCritical]
@@ -1316,7 +1335,7 @@ namespace LuaCLRBridge
                 CheckStack(L, 1);
 
                 eventUserData.Push(L);
-                partialTarget = ToUntranslatedObject(L, -1, _partialMetatableName) as PartialTarget;
+                partialTarget = ToUntranslatedObject(L, -1, _partialMetatableRef) as PartialTarget;
                 LuaWrapper.lua_pop(L, 1);
             }
 
@@ -1355,7 +1374,7 @@ namespace LuaCLRBridge
                 CheckStack(L, 1);
 
                 methodGroupUserData.Push(L);
-                partialTarget = ToUntranslatedObject(L, -1, _partialMetatableName) as PartialTarget;
+                partialTarget = ToUntranslatedObject(L, -1, _partialMetatableRef) as PartialTarget;
                 LuaWrapper.lua_pop(L, 1);
             }
 
@@ -1413,14 +1432,69 @@ namespace LuaCLRBridge
             internal readonly IEnumerable<MemberInfo> _members;
             internal readonly object _self;
 
-            internal SignatureBindingHints _hints;
+            internal readonly SignatureBindingHints _hints;
+
+            private MethodBase[] _methods;
+
+            private MethodInvoker _invoker;
+            private bool _isInvokerCreated;
 
             public PartialTarget( Type type, string name, IEnumerable<MemberInfo> members, object self )
+                : this(type, name, members, self, default(SignatureBindingHints))
+            {
+            }
+
+            public PartialTarget( Type type, string name, IEnumerable<MemberInfo> members, object self, SignatureBindingHints hints )
             {
                 this._type = type;
                 this._name = name;
                 this._members = members;
                 this._self = self;
+                this._hints = hints;
+            }
+
+            /// <summary>
+            /// Gets the methods of the partially-resolved members that are selected by the signature-binding
+            /// hints.
+            /// </summary>
+            internal MethodBase[] Methods
+            {
+                get
+                {
+                    // benign race; the selection is the same on every thread
+                    if (_methods == null)
+                    {
+                        IEnumerable<MethodBase> methodsTemp = _members
+                            .Select(member => member as MethodBase)
+                            .Where(member => member != null);
+
+                        _methods = _hints.SelectHintedMethods(methodsTemp)
+                            .ToArray();
+                    }
+
+                    return _methods;
+                }
+            }
+
+            /// <summary>
+            /// Gets the typed invoker of the single method of the partially-resolved members; or <c>null</c>
+            /// if the methods must be invoked through the binder.
+            /// </summary>
+            internal MethodInvoker Invoker
+            {
+                [SecurityCritical]
+                get
+                {
+                    // benign race; the invoker of a method is cached
+                    if (!_isInvokerCreated)
+                    {
+                        MethodBase[] methods = Methods;
+                        _invoker = methods.Length == 1 ? GetMethodInvoker(methods[0]) : null;
+                        _isInvokerCreated = true;
+                    }
+
+                    return _invoker;
+                }
             }
         }
     }
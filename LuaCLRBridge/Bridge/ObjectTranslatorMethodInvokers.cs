@@ -0,0 +1,808 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Concurrent;
+    using System.Linq;
+    using System.Linq.Expressions;
+    using System.Reflection;
+    using System.Security;
+    using Lua;
+
+    internal partial class ObjectTranslator
+    {
+        /* Invoking a method through the binder translates every argument to an object (boxing Lua numbers as
+           doubles), changes each argument to the type of its parameter (boxing it again), and calls the method
+           through reflection.  When a method group has a single method with a simple signature, a typed invoker
+           is instead created once per method.  The invoker reads the arguments from the Lua stack directly into
+           typed locals and calls a compiled delegate.  If the arguments on the stack are not ones that the typed
+           invoker can pass unchanged, the call falls back to the binder, which produces the same result or
+           error as it always has. */
+
+        private const int _maxInvokerArity = 4;
+
+        private static readonly ConcurrentDictionary<MethodBase, MethodInvoker> _methodInvokers =
+            new ConcurrentDictionary<MethodBase, MethodInvoker>();
+
+        /// <summary>
+        /// Gets the typed invoker of a method.
+        /// </summary>
+        /// <param name="method">The method.</param>
+        /// <returns>The (possibly cached) invoker; or <c>null</c> if the method must be invoked through the
+        ///     binder.</returns>
+        [SecurityCritical]
+        private static MethodInvoker GetMethodInvoker( MethodBase method )
+        {
+            MethodInvoker invoker;
+            if (_methodInvokers.TryGetValue(method, out invoker))
+                return invoker;
+
+            return _methodInvokers.GetOrAdd(method, CreateMethodInvoker(method));
+        }
+
+        [SecurityCritical]
+        private static MethodInvoker CreateMethodInvoker( MethodBase method )
+        {
+            MethodInfo methodInfo = method as MethodInfo;
+            if (methodInfo == null || !CanCreateMethodInvoker(methodInfo))
+                return null;
+
+            ParameterInfo[] parameters = methodInfo.GetParameters();
+            Type[] paramTypes = parameters.Select(param => param.ParameterType).ToArray();
+
+            // (self, arg1, ..., argN) => ((DeclaringType)self).Method(arg1, ..., argN)
+            ParameterExpression selfExpr = Expression.Parameter(typeof(object), "self");
+            ParameterExpression[] argExprs = paramTypes.Select(( paramType, i ) => Expression.Parameter(paramType, "arg" + (i + 1))).ToArray();
+
+            Expression body = Expression.Call(
+                methodInfo.IsStatic ? null : Expression.Convert(selfExpr, methodInfo.DeclaringType),
+                methodInfo,
+                argExprs);
+
+            bool isAction = methodInfo.ReturnType == typeof(void);
+
+            Type[] delegateTypeArgs = new[] { typeof(object) }
+                .Concat(paramTypes)
+                .Concat(isAction ? Type.EmptyTypes : new[] { methodInfo.ReturnType })
+                .ToArray();
+            Type delegateType = isAction ?
+                Expression.GetActionType(delegateTypeArgs) :
+                Expression.GetFuncType(delegateTypeArgs);
+
+            Delegate compiled = Expression.Lambda(delegateType, body, new[] { selfExpr }.Concat(argExprs)).Compile();
+
+            Type[] invokerTypeArgs = delegateTypeArgs.Skip(1).ToArray();
+            Type invokerType = isAction ? _actionInvokerTypes[paramTypes.Length] : _funcInvokerTypes[paramTypes.Length];
+            if (invokerType.IsGenericTypeDefinition)
+                invokerType = invokerType.MakeGenericType(invokerTypeArgs);
+
+            return Activator.CreateInstance(invokerType, compiled) as MethodInvoker;
+        }
+
+        private static bool CanCreateMethodInvoker( MethodInfo method )
+        {
+            Type declaringType = method.DeclaringType;
+
+            // compiled invokers are not granted access to non-visible members
+            if (!method.IsPublic || !declaringType.IsVisible)
+                return false;
+
+            if (method.ContainsGenericParameters || declaringType.ContainsGenericParameters)
+                return false;
+
+            // an instance of a value type must be invoked in place in its box
+            if (!method.IsStatic && declaringType.IsValueType)
+                return false;
+
+            Type returnType = method.ReturnType;
+            if (returnType != typeof(void) && (!returnType.IsVisible || returnType.IsPointer || returnType.IsByRef))
+                return false;
+
+            ParameterInfo[] parameters = method.GetParameters();
+            if (parameters.Length > _maxInvokerArity)
+                return false;
+
+            // by-reference parameters have results and parameter arrays have an expanded form
+            foreach (ParameterInfo param in parameters)
+            {
+                Type paramType = param.ParameterType;
+
+                if (!paramType.IsVisible || paramType.IsPointer || paramType.IsByRef || param.IsParams())
+                    return false;
+            }
+
+            return true;
+        }
+
+        private static readonly Type[] _actionInvokerTypes = new[]
+            {
+                typeof(ActionInvoker),
+                typeof(ActionInvoker<>),
+                typeof(ActionInvoker<,>),
+                typeof(ActionInvoker<,,>),
+                typeof(ActionInvoker<,,,>),
+            };
+
+        private static readonly Type[] _funcInvokerTypes = new[]
+            {
+                typeof(FuncInvoker<>),
+                typeof(FuncInvoker<,>),
+                typeof(FuncInvoker<,,>),
+                typeof(FuncInvoker<,,,>),
+                typeof(FuncInvoker<,,,,>),
+            };
+
+        /// <summary>
+        /// Invokes a method with arguments read directly from the stack of a Lua state.
+        /// </summary>
+        private abstract class MethodInvoker
+        {
+            /// <summary>
+            /// Invokes the method with the arguments on the stack of a Lua state (above the called value) and
+            /// replaces the stack with the results.
+            /// </summary>
+            /// <param name="translator">The object translator of the Lua state.</param>
+            /// <param name="L">The Lua state.</param>
+            /// <param name="self">The target of an instance method; ignored for a static method.</param>
+            /// <returns>The number of results on the stack; or <c>-1</c> if the arguments must be bound by
+            ///     the binder, in which case the stack is unchanged.</returns>
+            [SecurityCritical]
+            internal abstract int Invoke( ObjectTranslator translator, IntPtr L, object self );
+        }
+
+        private sealed class ActionInvoker : MethodInvoker
+        {
+            private readonly Action<object> _method;
+
+            public ActionInvoker( Action<object> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                if (LuaWrapper.lua_gettop(L) != 1)
+                    return -1;
+
+                _method(self);
+
+                LuaWrapper.lua_settop(L, 0);
+                return 0;
+            }
+        }
+
+        private sealed class ActionInvoker<T1> : MethodInvoker
+        {
+            private readonly Action<object, T1> _method;
+
+            public ActionInvoker( Action<object, T1> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                T1 arg1;
+
+                if (LuaWrapper.lua_gettop(L) != 2 ||
+                    !Argument<T1>.Read(translator, L, 2, out arg1))
+                {
+                    return -1;
+                }
+
+                _method(self, arg1);
+
+                LuaWrapper.lua_settop(L, 0);
+                return 0;
+            }
+        }
+
+        private sealed class ActionInvoker<T1, T2> : MethodInvoker
+        {
+            private readonly Action<object, T1, T2> _method;
+
+            public ActionInvoker( Action<object, T1, T2> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                T1 arg1;
+                T2 arg2;
+
+                if (LuaWrapper.lua_gettop(L) != 3 ||
+                    !Argument<T1>.Read(translator, L, 2, out arg1) ||
+                    !Argument<T2>.Read(translator, L, 3, out arg2))
+                {
+                    return -1;
+                }
+
+                _method(self, arg1, arg2);
+
+                LuaWrapper.lua_settop(L, 0);
+                return 0;
+            }
+        }
+
+        private sealed class ActionInvoker<T1, T2, T3> : MethodInvoker
+        {
+            private readonly Action<object, T1, T2, T3> _method;
+
+            public ActionInvoker( Action<object, T1, T2, T3> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                T1 arg1;
+                T2 arg2;
+                T3 arg3;
+
+                if (LuaWrapper.lua_gettop(L) != 4 ||
+                    !Argument<T1>.Read(translator, L, 2, out arg1) ||
+                    !Argument<T2>.Read(translator, L, 3, out arg2) ||
+                    !Argument<T3>.Read(translator, L, 4, out arg3))
+                {
+                    return -1;
+                }
+
+                _method(self, arg1, arg2, arg3);
+
+                LuaWrapper.lua_settop(L, 0);
+                return 0;
+            }
+        }
+
+        private sealed class ActionInvoker<T1, T2, T3, T4> : MethodInvoker
+        {
+            private readonly Action<object, T1, T2, T3, T4> _method;
+
+            public ActionInvoker( Action<object, T1, T2, T3, T4> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                T1 arg1;
+                T2 arg2;
+                T3 arg3;
+                T4 arg4;
+
+                if (LuaWrapper.lua_gettop(L) != 5 ||
+                    !Argument<T1>.Read(translator, L, 2, out arg1) ||
+                    !Argument<T2>.Read(translator, L, 3, out arg2) ||
+                    !Argument<T3>.Read(translator, L, 4, out arg3) ||
+                    !Argument<T4>.Read(translator, L, 5, out arg4))
+                {
+                    return -1;
+                }
+
+                _method(self, arg1, arg2, arg3, arg4);
+
+                LuaWrapper.lua_settop(L, 0);
+                return 0;
+            }
+        }
+
+        private sealed class FuncInvoker<TResult> : MethodInvoker
+        {
+            private readonly Func<object, TResult> _method;
+
+            public FuncInvoker( Func<object, TResult> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                if (LuaWrapper.lua_gettop(L) != 1)
+                    return -1;
+
+                TResult result = _method(self);
+
+                LuaWrapper.lua_settop(L, 0);
+                /* no stack check -- not more results than arguments */
+
+                Result<TResult>.Push(translator, L, result);
+                return 1;
+            }
+        }
+
+        private sealed class FuncInvoker<T1, TResult> : MethodInvoker
+        {
+            private readonly Func<object, T1, TResult> _method;
+
+            public FuncInvoker( Func<object, T1, TResult> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                T1 arg1;
+
+                if (LuaWrapper.lua_gettop(L) != 2 ||
+                    !Argument<T1>.Read(translator, L, 2, out arg1))
+                {
+                    return -1;
+                }
+
+                TResult result = _method(self, arg1);
+
+                LuaWrapper.lua_settop(L, 0);
+                /* no stack check -- not more results than arguments */
+
+                Result<TResult>.Push(translator, L, result);
+                return 1;
+            }
+        }
+
+        private sealed class FuncInvoker<T1, T2, TResult> : MethodInvoker
+        {
+            private readonly Func<object, T1, T2, TResult> _method;
+
+            public FuncInvoker( Func<object, T1, T2, TResult> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                T1 arg1;
+                T2 arg2;
+
+                if (LuaWrapper.lua_gettop(L) != 3 ||
+                    !Argument<T1>.Read(translator, L, 2, out arg1) ||
+                    !Argument<T2>.Read(translator, L, 3, out arg2))
+                {
+                    return -1;
+                }
+
+                TResult result = _method(self, arg1, arg2);
+
+                LuaWrapper.lua_settop(L, 0);
+                /* no stack check -- not more results than arguments */
+
+                Result<TResult>.Push(translator, L, result);
+                return 1;
+            }
+        }
+
+        private sealed class FuncInvoker<T1, T2, T3, TResult> : MethodInvoker
+        {
+            private readonly Func<object, T1, T2, T3, TResult> _method;
+
+            public FuncInvoker( Func<object, T1, T2, T3, TResult> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                T1 arg1;
+                T2 arg2;
+                T3 arg3;
+
+                if (LuaWrapper.lua_gettop(L) != 4 ||
+                    !Argument<T1>.Read(translator, L, 2, out arg1) ||
+                    !Argument<T2>.Read(translator, L, 3, out arg2) ||
+                    !Argument<T3>.Read(translator, L, 4, out arg3))
+                {
+                    return -1;
+                }
+
+                TResult result = _method(self, arg1, arg2, arg3);
+
+                LuaWrapper.lua_settop(L, 0);
+                /* no stack check -- not more results than arguments */
+
+                Result<TResult>.Push(translator, L, result);
+                return 1;
+            }
+        }
+
+        private sealed class FuncInvoker<T1, T2, T3, T4, TResult> : MethodInvoker
+        {
+            private readonly Func<object, T1, T2, T3, T4, TResult> _method;
+
+            public FuncInvoker( Func<object, T1, T2, T3, T4, TResult> method )
+            {
+                this._method = method;
+            }
+
+            [SecurityCritical]
+            internal override int Invoke( ObjectTranslator translator, IntPtr L, object self )
+            {
+                T1 arg1;
+                T2 arg2;
+                T3 arg3;
+                T4 arg4;
+
+                if (LuaWrapper.lua_gettop(L) != 5 ||
+                    !Argument<T1>.Read(translator, L, 2, out arg1) ||
+                    !Argument<T2>.Read(translator, L, 3, out arg2) ||
+                    !Argument<T3>.Read(translator, L, 4, out arg3) ||
+                    !Argument<T4>.Read(translator, L, 5, out arg4))
+                {
+                    return -1;
+                }
+
+                TResult result = _method(self, arg1, arg2, arg3, arg4);
+
+                LuaWrapper.lua_settop(L, 0);
+                /* no stack check -- not more results than arguments */
+
+                Result<TResult>.Push(translator, L, result);
+                return 1;
+            }
+        }
+
+        #region Typed Arguments
+
+        /// <summary>
+        /// Reads an argument from the stack of a Lua state as a particular type.
+        /// </summary>
+        /// <returns><c>true</c> if the value on the stack is passed to a parameter of the type unchanged by the
+        ///     binder; otherwise, <c>false</c>.</returns>
+        private delegate bool ArgumentReader<T>( ObjectTranslator translator, IntPtr L, int index, out T value );
+
+        [SecurityCritical]
+        private static class Argument<T>
+        {
+            internal static readonly ArgumentReader<T> Read = CreateArgumentReader(typeof(T)) as ArgumentReader<T> ?? ReadObject<T>;
+        }
+
+        /// <summary>
+        /// Reads a value from the stack of a Lua state as a particular type, without boxing it if the type is
+        /// primitive or <see cref="String"/>.
+        /// </summary>
+        /// <returns><c>true</c> if the value is of the type; otherwise, <c>false</c>.</returns>
+        [SecurityCritical]
+        internal bool TryToValue<T>( IntPtr L, int index, out T value )
+        {
+            return Argument<T>.Read(this, L, index, out value);
+        }
+
+        [SecurityCritical]
+        private static Delegate CreateArgumentReader( Type type )
+        {
+            if (type == typeof(string))
+                return new ArgumentReader<String>(ReadString);
+
+            // excludes enumerations, whose type codes are those of their underlying types
+            if (!type.IsPrimitive)
+                return null;
+
+            switch (Type.GetTypeCode(type))
+            {
+                case TypeCode.Boolean:
+                    return new ArgumentReader<Boolean>(ReadBoolean);
+
+                case TypeCode.Double:
+                    return new ArgumentReader<Double>(ReadDouble);
+                case TypeCode.Single:
+                    return new ArgumentReader<Single>(ReadSingle);
+                case TypeCode.Int64:
+                    return new ArgumentReader<Int64>(ReadInt64);
+                case TypeCode.UInt64:
+                    return new ArgumentReader<UInt64>(ReadUInt64);
+                case TypeCode.Int32:
+                    return new ArgumentReader<Int32>(ReadInt32);
+                case TypeCode.UInt32:
+                    return new ArgumentReader<UInt32>(ReadUInt32);
+                case TypeCode.Int16:
+                    return new ArgumentReader<Int16>(ReadInt16);
+                case TypeCode.UInt16:
+                    return new ArgumentReader<UInt16>(ReadUInt16);
+                case TypeCode.SByte:
+                    return new ArgumentReader<SByte>(ReadSByte);
+                case TypeCode.Byte:
+                    return new ArgumentReader<Byte>(ReadByte);
+
+                case TypeCode.Char:
+                    return new ArgumentReader<Char>(ReadChar);
+
+                default:  // IntPtr, UIntPtr
+                    return null;
+            }
+        }
+
+        [SecurityCritical]
+        private static bool ReadObject<T>( ObjectTranslator translator, IntPtr L, int index, out T value )
+        {
+            object arg = translator.ToObject(L, index);
+
+            if (arg is T)
+            {
+                value = (T)arg;
+                return true;
+            }
+
+            value = default(T);
+
+            // non-nullable value type cannot be assigned null
+            return arg == null && !typeof(T).IsValueType;
+        }
+
+        [SecurityCritical]
+        private static bool ReadString( ObjectTranslator translator, IntPtr L, int index, out String value )
+        {
+            switch (LuaWrapper.lua_type(L, index))
+            {
+                case LuaType.LUA_TNIL:
+                    value = null;
+                    return true;
+
+                case LuaType.LUA_TSTRING:
+                    UIntPtr len;
+                    value = LuaWrapper.lua_tolstring(L, index, out len, translator._encoding);
+                    return true;
+
+                default:
+                    value = null;
+                    return false;
+            }
+        }
+
+        [SecurityCritical]
+        private static bool ReadBoolean( ObjectTranslator translator, IntPtr L, int index, out Boolean value )
+        {
+            bool isBoolean = LuaWrapper.lua_type(L, index) == LuaType.LUA_TBOOLEAN;
+            value = isBoolean && LuaWrapper.lua_toboolean(L, index);
+            return isBoolean;
+        }
+
+        /// <summary>
+        /// Reads a Lua number that the binder can coerce to a particular numeric type.
+        /// </summary>
+        [SecurityCritical]
+        private static bool ReadLuaNumeric( IntPtr L, int index, Type targetType, out double value )
+        {
+            if (LuaWrapper.lua_type(L, index) != LuaType.LUA_TNUMBER)
+            {
+                value = 0;
+                return false;
+            }
+
+            value = LuaWrapper.lua_tonumber(L, index);
+            return LuaBinder.CanCoerceLuaNumeric(value, targetType);
+        }
+
+        [SecurityCritical]
+        private static bool ReadDouble( ObjectTranslator translator, IntPtr L, int index, out Double value )
+        {
+            return ReadLuaNumeric(L, index, typeof(Double), out value);
+        }
+
+        [SecurityCritical]
+        private static bool ReadSingle( ObjectTranslator translator, IntPtr L, int index, out Single value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(Single), out number);
+            value = (Single)number;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadInt64( ObjectTranslator translator, IntPtr L, int index, out Int64 value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(Int64), out number);
+            value = isNumber ? (Int64)number : 0;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadUInt64( ObjectTranslator translator, IntPtr L, int index, out UInt64 value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(UInt64), out number);
+            value = isNumber ? (UInt64)number : 0;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadInt32( ObjectTranslator translator, IntPtr L, int index, out Int32 value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(Int32), out number);
+            value = isNumber ? (Int32)number : 0;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadUInt32( ObjectTranslator translator, IntPtr L, int index, out UInt32 value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(UInt32), out number);
+            value = isNumber ? (UInt32)number : 0;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadInt16( ObjectTranslator translator, IntPtr L, int index, out Int16 value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(Int16), out number);
+            value = isNumber ? (Int16)number : (Int16)0;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadUInt16( ObjectTranslator translator, IntPtr L, int index, out UInt16 value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(UInt16), out number);
+            value = isNumber ? (UInt16)number : (UInt16)0;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadSByte( ObjectTranslator translator, IntPtr L, int index, out SByte value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(SByte), out number);
+            value = isNumber ? (SByte)number : (SByte)0;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadByte( ObjectTranslator translator, IntPtr L, int index, out Byte value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(Byte), out number);
+            value = isNumber ? (Byte)number : (Byte)0;
+            return isNumber;
+        }
+
+        [SecurityCritical]
+        private static bool ReadChar( ObjectTranslator translator, IntPtr L, int index, out Char value )
+        {
+            double number;
+            bool isNumber = ReadLuaNumeric(L, index, typeof(Char), out number);
+            value = isNumber ? (Char)number : (Char)0;
+            return isNumber;
+        }
+
+        #endregion
+
+        #region Typed Results
+
+        /// <summary>
+        /// Pushes a result of a particular type onto the stack of a Lua state.
+        /// </summary>
+        private delegate void ResultPusher<T>( ObjectTranslator translator, IntPtr L, T value );
+
+        [SecurityCritical]
+        private static class Result<T>
+        {
+            internal static readonly ResultPusher<T> Push = CreateResultPusher(typeof(T)) as ResultPusher<T> ?? PushResultObject<T>;
+        }
+
+        [SecurityCritical]
+        private static Delegate CreateResultPusher( Type type )
+        {
+            // excludes enumerations, whose type codes are those of their underlying types
+            if (!type.IsPrimitive)
+                return null;
+
+            // must agree with PushObject
+            switch (Type.GetTypeCode(type))
+            {
+                case TypeCode.Boolean:
+                    return new ResultPusher<Boolean>(PushBoolean);
+
+                case TypeCode.Double:
+                    return new ResultPusher<Double>(PushDouble);
+                case TypeCode.Single:
+                    return new ResultPusher<Single>(PushSingle);
+                case TypeCode.Int32:
+                    return new ResultPusher<Int32>(PushInt32);
+                case TypeCode.UInt32:
+                    return new ResultPusher<UInt32>(PushUInt32);
+                case TypeCode.Int16:
+                    return new ResultPusher<Int16>(PushInt16);
+                case TypeCode.UInt16:
+                    return new ResultPusher<UInt16>(PushUInt16);
+                case TypeCode.SByte:
+                    return new ResultPusher<SByte>(PushSByte);
+                case TypeCode.Byte:
+                    return new ResultPusher<Byte>(PushByte);
+
+                case TypeCode.Char:
+                    return new ResultPusher<Char>(PushChar);
+
+                default:  // 64-bit integers, IntPtr, UIntPtr
+                    return null;
+            }
+        }
+
+        [SecurityCritical]
+        private static void PushResultObject<T>( ObjectTranslator translator, IntPtr L, T value )
+        {
+            translator.PushObject(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushBoolean( ObjectTranslator translator, IntPtr L, Boolean value )
+        {
+            LuaWrapper.lua_pushboolean(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushDouble( ObjectTranslator translator, IntPtr L, Double value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushSingle( ObjectTranslator translator, IntPtr L, Single value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushInt32( ObjectTranslator translator, IntPtr L, Int32 value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushUInt32( ObjectTranslator translator, IntPtr L, UInt32 value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushInt16( ObjectTranslator translator, IntPtr L, Int16 value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushUInt16( ObjectTranslator translator, IntPtr L, UInt16 value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushSByte( ObjectTranslator translator, IntPtr L, SByte value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushByte( ObjectTranslator translator, IntPtr L, Byte value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        [SecurityCritical]
+        private static void PushChar( ObjectTranslator translator, IntPtr L, Char value )
+        {
+            LuaWrapper.lua_pushnumber(L, value);
+        }
+
+        #endregion
+    }
+}
@@ -0,0 +1,194 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Diagnostics;
+    using System.Runtime.InteropServices;
+    using System.Security;
+    using Lua;
+
+    internal partial class ObjectTranslator
+    {
+        /* The CLI objects referenced by userdatas are kept in a table of slots rather than each behind its own
+           GCHandle.  The userdata holds only the index of its slot, so getting the object is an array access,
+           and the slot of a collected userdata is reused by the next object pushed.  Slots that are free are
+           linked together through _nextFreeSlots. */
+
+        private const int _initialObjectSlotCount = 64;
+
+        /// <summary>
+        /// The CLI objects that are referenced by the Lua state and must not be collected by the CLR garbage
+        /// collector, indexed by slot.  Free slots are <c>null</c>.
+        /// </summary>
+        [SecurityCritical]
+        private object[] _objects = new object[_initialObjectSlotCount];
+
+        /// <summary>
+        /// For each free slot, the index of the next free slot; or <c>-1</c> if it is the last free slot.
+        /// </summary>
+        [SecurityCritical]
+        private int[] _nextFreeSlots = new int[_initialObjectSlotCount];
+
+        /// <summary>
+        /// The index of the first free slot; or <c>-1</c> if there are no free slots below <see
+        /// cref="_usedObjectSlotCount"/>.
+        /// </summary>
+        [SecurityCritical]
+        private int _firstFreeSlot = -1;
+
+        /// <summary>
+        /// The number of slots that have ever been used.  Slots at and above this index are free but not
+        /// linked.
+        /// </summary>
+        [SecurityCritical]
+        private int _usedObjectSlotCount = 0;
+
+        /// <summary>
+        /// The number of slots that hold objects.
+        /// </summary>
+        [SecurityCritical]
+        private int _objectCount = 0;
+
+        /// <summary>
+        /// The method called with the new <see cref="ObjectTableSize"/> whenever the object table grows; or
+        /// <c>null</c>.
+        /// </summary>
+        [SecurityCritical]
+        internal Action<long> _objectTableResized;
+
+        /// <summary>
+        /// Gets the number of slots that hold objects.
+        /// </summary>
+        internal int ObjectCount
+        {
+            [SecurityCritical]
+            get { return _objectCount; }
+        }
+
+        /// <summary>
+        /// Gets the size in bytes of the arrays of the object table, which is memory used on behalf of the Lua
+        /// state but outside of it.
+        /// </summary>
+        internal long ObjectTableSize
+        {
+            [SecurityCritical]
+            get { return (long)_objects.Length * (IntPtr.Size + sizeof(int)); }
+        }
+
+        /// <summary>
+        /// Stores a CLI object in a free slot of the object table.
+        /// </summary>
+        /// <param name="o">The object.</param>
+        /// <returns>The index of the slot.</returns>
+        [SecurityCritical]
+        private int AllocateObjectSlot( object o )
+        {
+            Debug.Assert(o != null, "Null is never stored in the object table.");
+
+            int slot;
+
+            if (_firstFreeSlot >= 0)
+            {
+                slot = _firstFreeSlot;
+                _firstFreeSlot = _nextFreeSlots[slot];
+            }
+            else
+            {
+                if (_usedObjectSlotCount == _objects.Length)
+                {
+                    int length = checked(_objects.Length * 2);
+                    Array.Resize(ref _objects, length);
+                    Array.Resize(ref _nextFreeSlots, length);
+
+                    if (_objectTableResized != null)
+                        _objectTableResized(ObjectTableSize);
+                }
+
+                slot = _usedObjectSlotCount++;
+            }
+
+            _objects[slot] = o;
+            ++_objectCount;
+
+            CheckCrossHeapCollection();
+
+            return slot;
+        }
+
+        /// <summary>
+        /// Removes the CLI object from a slot of the object table and makes the slot free.
+        /// </summary>
+        /// <param name="slot">The index of the slot.</param>
+        /// <returns>The object that was in the slot.</returns>
+        [SecurityCritical]
+        private object FreeObjectSlot( int slot )
+        {
+            object o = _objects[slot];
+
+            Debug.Assert(o != null, "Object slot should not already be free.");
+
+            _objects[slot] = null;
+            _nextFreeSlots[slot] = _firstFreeSlot;
+            _firstFreeSlot = slot;
+            --_objectCount;
+
+            return o;
+        }
+
+        /// <summary>
+        /// Stores a CLI object in the object table and records its slot in a new userdata.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="o">The object.</param>
+        /// <returns>The address of the block of memory of the userdata.</returns>
+        [SecurityCritical]
+        private IntPtr NewObjectUserData( IntPtr L, object o )
+        {
+            IntPtr udata = LuaWrapper.lua_newuserdata(L, sizeof(int));
+            Marshal.WriteInt32(udata, AllocateObjectSlot(o));
+            return udata;
+        }
+
+        /// <summary>
+        /// Gets the CLI object referenced by a userdata.
+        /// </summary>
+        /// <param name="udata">The address of the block of memory of the userdata.</param>
+        /// <returns>The object.</returns>
+        [SecurityCritical]
+        private object GetUserDataObject( IntPtr udata )
+        {
+            object o = _objects[Marshal.ReadInt32(udata)];
+
+            Debug.Assert(o != null, "Object slot should still be in use.");
+            Debug.Assert(!(o is CollectedObject), "Userdata of a CLI object collected by a cross-heap collection should be unreachable.");
+
+            return o;
+        }
+
+        /// <summary>
+        /// Gets the CLI delegate of a cfunction from the slot of its proxy, without allocating.
+        /// </summary>
+        /// <param name="slot">The index of the slot of the object that is the first upvalue of the cfunction.
+        ///     </param>
+        /// <returns>The delegate if the object is the proxy of a cfunction created from a delegate;
+        ///     otherwise, <c>null</c>.</returns>
+        /// <remarks>
+        /// This is called from the hook of the Lua state to identify the CLR functions in its call stack.
+        /// </remarks>
+        [SecurityCritical]
+        internal object GetCFunctionDelegate( int slot )
+        {
+            var functionProxy = _objects[slot] as LuaFunction.LuaFunctionProxy;
+
+            return functionProxy != null ? functionProxy.Delegate : null;
+        }
+    }
+}
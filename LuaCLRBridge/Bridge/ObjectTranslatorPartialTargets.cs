@@ -0,0 +1,117 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Security;
+    using Lua;
+
+    internal partial class ObjectTranslator
+    {
+        /* Calling a method from Lua first gets the method group from the target, which would otherwise create a
+         * new partially-resolved member userdata (and a handle for it) on every call.  Partially-resolved members
+         * are immutable once created, so the userdata is kept for as long as the userdata of the target is alive
+         * and reused every time the same member is gotten from the same target. */
+
+        /// <summary>
+        /// The Lua table that maps the userdatas of targets (CLI objects and types) to tables that map member
+        /// names to the userdatas of partially-resolved members gotten from those targets.
+        /// </summary>
+        /// <remarks>
+        /// This table has weakly referenced keys, so an entry does not keep its target alive.
+        /// </remarks>
+        private LuaTable _partialTargets;  // weak keys
+
+        [SecurityCritical]
+        private void InitializePartialTargets( IntPtr L )
+        {
+            CheckStack(L, 4);  // table + metatable + key + value
+
+            // create cache table with weak keys
+            LuaWrapper.lua_newtable(L);
+            LuaWrapper.lua_pushvalue(L, -1);
+            LuaWrapper.lua_pushstring(L, "__mode", Encoding);
+            LuaWrapper.lua_pushstring(L, "k", Encoding);
+            LuaWrapper.lua_rawset(L, -3);
+            LuaWrapper.lua_setmetatable(L, -2);
+            _partialTargets = new LuaTable(this, L, -1);
+            LuaWrapper.lua_pop(L, 1);
+        }
+
+        /// <summary>
+        /// Pushes the userdata of a partially-resolved member previously gotten from a target onto the stack
+        /// of a Lua state.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="targetIndex">The absolute index in the stack of the userdata of the target.</param>
+        /// <param name="nameIndex">The absolute index in the stack of the name of the member.</param>
+        /// <returns><c>true</c> if the userdata of the partially-resolved member was pushed; <c>false</c> if
+        ///     nothing was pushed.</returns>
+        [SecurityCritical]
+        private bool PushCachedPartialTarget( IntPtr L, int targetIndex, int nameIndex )
+        {
+            CheckStack(L, 3);  // partialTargets + targetPartials + name
+
+            _partialTargets.Push(L);
+            LuaWrapper.lua_pushvalue(L, targetIndex);
+            LuaWrapper.lua_rawget(L, -2);
+
+            if (LuaWrapper.lua_type(L, -1) != LuaType.LUA_TTABLE)
+            {
+                LuaWrapper.lua_pop(L, 2); // targetPartials, partialTargets
+                return false;
+            }
+
+            LuaWrapper.lua_pushvalue(L, nameIndex);
+            LuaWrapper.lua_rawget(L, -2);
+
+            if (LuaWrapper.lua_type(L, -1) != LuaType.LUA_TUSERDATA)
+            {
+                LuaWrapper.lua_pop(L, 3); // partial, targetPartials, partialTargets
+                return false;
+            }
+
+            LuaWrapper.lua_replace(L, -3); // partialTargets
+            LuaWrapper.lua_pop(L, 1); // targetPartials
+            return true;
+        }
+
+        /// <summary>
+        /// Stores the userdata of a partially-resolved member, which is at the top of the stack of a Lua
+        /// state, for reuse when the same member is gotten from the same target.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="targetIndex">The absolute index in the stack of the userdata of the target.</param>
+        /// <param name="nameIndex">The absolute index in the stack of the name of the member.</param>
+        [SecurityCritical]
+        private void StorePartialTarget( IntPtr L, int targetIndex, int nameIndex )
+        {
+            CheckStack(L, 4);  // partialTargets + targetPartials + key + value
+
+            _partialTargets.Push(L);
+            LuaWrapper.lua_pushvalue(L, targetIndex);
+            LuaWrapper.lua_rawget(L, -2);
+
+            if (LuaWrapper.lua_type(L, -1) != LuaType.LUA_TTABLE)
+            {
+                LuaWrapper.lua_pop(L, 1);
+                LuaWrapper.lua_newtable(L);
+                LuaWrapper.lua_pushvalue(L, targetIndex);
+                LuaWrapper.lua_pushvalue(L, -2); // targetPartials
+                LuaWrapper.lua_rawset(L, -4);
+            }
+
+            LuaWrapper.lua_pushvalue(L, nameIndex);
+            LuaWrapper.lua_pushvalue(L, -4); // partial
+            LuaWrapper.lua_rawset(L, -3);
+            LuaWrapper.lua_pop(L, 2); // targetPartials, partialTargets
+        }
+    }
+}
@@ -0,0 +1,352 @@
+﻿/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+namespace LuaCLRBridge
+{
+    using System;
+    using System.Collections.Generic;
+    using System.Diagnostics;
+    using System.Runtime.InteropServices;
+    using System.Security;
+    using Lua;
+
+    internal partial class ObjectTranslator
+    {
+        /* The Lua values referenced by LuaBase objects are kept in the slots of a table of references rather
+           than by luaL_ref in the registry.  The array part of the table is sized to hold every slot, and
+           slots that are free are linked together through _nextFreeRefSlots, so taking or releasing a slot
+           neither walks a free list in Lua nor rehashes the table.  The LuaBase objects of the same Lua value
+           share its slot, which counts them. */
+
+        private const int _initialRefSlotCount = 256;
+
+        /// <summary>
+        /// The reference in the registry of the table of references.
+        /// </summary>
+        [SecurityCritical]
+        private int _refTableRef;
+
+        /// <summary>
+        /// The number of <see cref="LuaBase"/> objects that hold each slot, indexed by slot.  Free slots are 0.
+        /// </summary>
+        [SecurityCritical]
+        private int[] _refCounts = new int[_initialRefSlotCount];
+
+        /// <summary>
+        /// For each free slot, the index of the next free slot; or <c>-1</c> if it is the last free slot.
+        /// </summary>
+        [SecurityCritical]
+        private int[] _nextFreeRefSlots = new int[_initialRefSlotCount];
+
+        /// <summary>
+        /// The identity (from <c>lua_topointer</c>) of the Lua value in each slot, indexed by slot.
+        /// </summary>
+        [SecurityCritical]
+        private IntPtr[] _refPointers = new IntPtr[_initialRefSlotCount];
+
+        /// <summary>
+        /// Weak handles to the <see cref="RefOwner"/> of each slot, indexed by slot.  Handles of free slots
+        /// are unallocated.
+        /// </summary>
+        [SecurityCritical]
+        private GCHandle[] _refOwners = new GCHandle[_initialRefSlotCount];
+
+        /// <summary>
+        /// The slot of each Lua value that is referenced, by identity.
+        /// </summary>
+        [SecurityCritical]
+        private readonly Dictionary<IntPtr, int> _refSlots = new Dictionary<IntPtr, int>();
+
+        /// <summary>
+        /// The index of the first free slot; or <c>-1</c> if there are no free slots below <see
+        /// cref="_usedRefSlotCount"/>.
+        /// </summary>
+        [SecurityCritical]
+        private int _firstFreeRefSlot = -1;
+
+        /// <summary>
+        /// The number of slots that have ever been used.  Slots at and above this index are free but not
+        /// linked.
+        /// </summary>
+        [SecurityCritical]
+        private int _usedRefSlotCount = 0;
+
+        /// <summary>
+        /// The number of slots that hold Lua values.
+        /// </summary>
+        [SecurityCritical]
+        private int _refSlotCount = 0;
+
+        /// <summary>
+        /// The number of <see cref="LuaBase"/> objects that hold slots (i.e., the sum of
+        /// <see cref="_refCounts"/>).
+        /// </summary>
+        [SecurityCritical]
+        private int _refCount = 0;
+
+        /// <summary>
+        /// Whether new slots are being taken in bulk, and are set by <see cref="EndBulkRefs"/>.
+        /// </summary>
+        [SecurityCritical]
+        private bool _bulkRefs = false;
+
+        [SecurityCritical]
+        private int[] _pendingRefSlots = new int[_initialRefSlotCount];
+
+        /// <summary>
+        /// The (absolute) stack index of the Lua value of each pending slot.
+        /// </summary>
+        [SecurityCritical]
+        private int[] _pendingRefIndices = new int[_initialRefSlotCount];
+
+        [SecurityCritical]
+        private int _pendingRefCount = 0;
+
+        /// <summary>
+        /// The owner of a slot of the table of references, which is shared by (and kept alive by) the
+        /// <see cref="LuaBase"/> objects of the Lua value in the slot.
+        /// </summary>
+        internal sealed class RefOwner
+        {
+            /// <summary>
+            /// The CLI objects and other owners that the Lua value reaches, which are held here only during a
+            /// cross-heap collection.
+            /// </summary>
+            internal object[] _crossHeapKeepAlive;
+        }
+
+        /// <summary>
+        /// Gets the number of Lua values referenced by <see cref="LuaBase"/> objects.
+        /// </summary>
+        internal int RefSlotCount
+        {
+            [SecurityCritical]
+            get { return _refSlotCount; }
+        }
+
+        /// <summary>
+        /// Gets the number of <see cref="LuaBase"/> objects that reference Lua values and have not been
+        /// released.
+        /// </summary>
+        internal int RefCount
+        {
+            [SecurityCritical]
+            get { return _refCount; }
+        }
+
+        /// <summary>
+        /// Gets the number of slots in the table of references.
+        /// </summary>
+        internal int RefCapacity
+        {
+            [SecurityCritical]
+            get { return _refCounts.Length; }
+        }
+
+        [SecurityCritical]
+        private void InitializeRefTable( IntPtr L )
+        {
+            CheckStack(L, 1);
+
+            LuaWrapper.lua_createtable(L, _initialRefSlotCount, 0);
+            _refTableRef = LuaWrapper.luaL_ref(L, LuaWrapper.LUA_REGISTRYINDEX);
+        }
+
+        /// <summary>
+        /// References a Lua value for a <see cref="LuaBase"/>, sharing the slot of the value if it is already
+        /// referenced.
+        /// </summary>
+        /// <param name="L">The Lua state.</param>
+        /// <param name="index">The stack index of the Lua value, which must be a collectable object.</param>
+        /// <param name="owner">The owner of the slot, which the <see cref="LuaBase"/> must keep alive.</param>
+        /// <returns>The index of the slot.</returns>
+        [SecurityCritical]
+        internal int Ref( IntPtr L, int index, out RefOwner owner )
+        {
+            IntPtr pointer = LuaWrapper.lua_topointer(L, index);
+
+            int slot;
+
+            if (_refSlots.TryGetValue(pointer, out slot))
+            {
+                ++_refCounts[slot];
+
+                owner = _refOwners[slot].Target as RefOwner;
+
+                // the LuaBase objects that held the slot are being finalized
+                if (owner == null)
+                {
+                    owner = new RefOwner();
+                    _refOwners[slot].Target = owner;
+                }
+            }
+            else
+            {
+                slot = AllocateRefSlot(L);
+
+                owner = new RefOwner();
+
+                _refCounts[slot] = 1;
+                _refPointers[slot] = pointer;
+                _refOwners[slot] = GCHandle.Alloc(owner, GCHandleType.Weak);
+                _refSlots.Add(pointer, slot);
+
+                if (_bulkRefs)
+                {
+                    AddPendingRef(slot, LuaWrapper.lua_absindex(L, index));
+                }
+                else
+                {
+                    CheckStack(L, 1);
+
+                    LuaWrapper.luaW_setref(L, _refTableRef, slot, index);
+                }
+            }
+
+            ++_refCount;
+
+            return slot;
+        }
+
+        /// <summary>
+        /// Pushes the Lua value of a slot onto the stack of the specified Lua state.
+        /// </summary>
+        [SecurityCritical]
+        internal void PushRef( IntPtr L, int slot )
+        {
+            LuaWrapper.luaW_pushref(L, _refTableRef, slot);
+        }
+
+        /// <summary>
+        /// Unreferences a slot for a <see cref="LuaBase"/>, which the caller has locked the Lua state to do.
+        /// </summary>
+        [SecurityCritical]
+        internal void Unref( IntPtr L, int slot )
+        {
+            if (ReleaseRefSlot(slot))
+                LuaWrapper.luaW_clearref(L, _refTableRef, slot);
+        }
+
+        /// <summary>
+        /// Starts taking slots in bulk: the Lua values of new slots are not set until
+        /// <see cref="EndBulkRefs"/>, which sets them all in one native call, and so must stay on the stack
+        /// until then.
+        /// </summary>
+        [SecurityCritical]
+        internal void BeginBulkRefs()
+        {
+            Debug.Assert(!_bulkRefs, "Slots should not already be taken in bulk.");
+
+            _bulkRefs = true;
+        }
+
+        /// <summary>
+        /// Sets the Lua values of the slots taken since <see cref="BeginBulkRefs"/>.
+        /// </summary>
+        [SecurityCritical]
+        internal void EndBulkRefs( IntPtr L )
+        {
+            _bulkRefs = false;
+
+            int count = _pendingRefCount;
+            _pendingRefCount = 0;
+
+            if (count == 0)
+                return;
+
+            CheckStack(L, 1);
+
+            LuaWrapper.luaW_setrefs(L, _refTableRef, _pendingRefSlots, _pendingRefIndices, count);
+        }
+
+        [SecurityCritical]
+        private void AddPendingRef( int slot, int index )
+        {
+            if (_pendingRefCount == _pendingRefSlots.Length)
+            {
+                int length = checked(_pendingRefSlots.Length * 2);
+                Array.Resize(ref _pendingRefSlots, length);
+                Array.Resize(ref _pendingRefIndices, length);
+            }
+
+            _pendingRefSlots[_pendingRefCount] = slot;
+            _pendingRefIndices[_pendingRefCount] = index;
+            ++_pendingRefCount;
+        }
+
+        /// <summary>
+        /// Takes a free slot of the table of references, growing the table if there is none.
+        /// </summary>
+        [SecurityCritical]
+        private int AllocateRefSlot( IntPtr L )
+        {
+            int slot;
+
+            if (_firstFreeRefSlot >= 0)
+            {
+                slot = _firstFreeRefSlot;
+                _firstFreeRefSlot = _nextFreeRefSlots[slot];
+            }
+            else
+            {
+                if (_usedRefSlotCount == _refCounts.Length)
+                {
+                    int length = checked(_refCounts.Length * 2);
+
+                    LuaWrapper.luaW_resizerefs(L, _refTableRef, length);
+
+                    Array.Resize(ref _refCounts, length);
+                    Array.Resize(ref _nextFreeRefSlots, length);
+                    Array.Resize(ref _refPointers, length);
+                    Array.Resize(ref _refOwners, length);
+                }
+
+                slot = _usedRefSlotCount++;
+            }
+
+            ++_refSlotCount;
+
+            return slot;
+        }
+
+        /// <summary>
+        /// Releases a slot for a <see cref="LuaBase"/>, freeing it if no other <see cref="LuaBase"/> holds it.
+        /// </summary>
+        /// <returns><c>true</c> if the slot is free, and its Lua value must be cleared before the slot is
+        ///     taken again; otherwise, <c>false</c>.</returns>
+        [SecurityCritical]
+        private bool ReleaseRefSlot( int slot )
+        {
+            Debug.Assert(_refCounts[slot] > 0, "Ref slot should not already be free.");
+
+            --_refCount;
+
+            if (--_refCounts[slot] != 0)
+                return false;
+
+            _refSlots.Remove(_refPointers[slot]);
+            _refPointers[slot] = IntPtr.Zero;
+            _refOwners[slot].Free();
+
+            _nextFreeRefSlots[slot] = _firstFreeRefSlot;
+            _firstFreeRefSlot = slot;
+            --_refSlotCount;
+
+            return true;
+        }
+
+        [SecurityCritical]
+        private void FreeRefOwners()
+        {
+            for (int i = 0; i < _refOwners.Length; ++i)
+                if (_refOwners[i].IsAllocated)
+                    _refOwners[i].Free();
+        }
+    }
+}
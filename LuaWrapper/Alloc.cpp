@@ -0,0 +1,264 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "Alloc.hpp"
+#include "Hook.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+// precedes the blocks of a slab; the union keeps the blocks aligned as malloc would
+union SlabHeader
+{
+	SlabHeader* next;
+	double align;
+};
+
+static const size_t slabSize = 16 * 1024;
+
+// the size class that serves blocks of a size, or sizeClassCount if the size is not pooled
+static inline int sizeClassOf( size_t size )
+{
+	if (size > StateAllocator::sizeClassCount * StateAllocator::sizeClassGranularity)
+		return StateAllocator::sizeClassCount;
+
+	return static_cast<int>((size - 1) / StateAllocator::sizeClassGranularity);
+}
+
+// the size to allocate from malloc for a block that is not pooled; it leaves room for a slab header and the largest
+// pooled block, so that the block can shrink into a size class without allocating
+static inline size_t unpooledSize( size_t size )
+{
+	const size_t minSize = sizeof(SlabHeader) + StateAllocator::sizeClassCount * StateAllocator::sizeClassGranularity;
+
+	return size < minSize ? minSize : size;
+}
+
+StateAllocator::StateAllocator( bool pooled )
+	: _L(NULL), _allocated(0), _external(0), _limit(0), _softLimit(0), _softLimitExceeded(false),
+	  _pooled(pooled), _released(false), _slabs(NULL)
+{
+	memset(_sizeClasses, 0, sizeof _sizeClasses);
+}
+
+StateAllocator::~StateAllocator()
+{
+	releaseSlabs();
+}
+
+void StateAllocator::release( void )
+{
+	_released = true;
+
+	// nothing is allocated before the Lua state is opened or after it is closed
+	if (_allocated == 0)
+		delete this;
+}
+
+void* StateAllocator::alloc( void* ud, void* ptr, size_t osize, size_t nsize )
+{
+	StateAllocator* a = static_cast<StateAllocator*>(ud);
+
+	// for a new block, osize is the type of the object rather than a size
+	if (ptr == NULL)
+		osize = 0;
+
+	// Lua raises a memory error when an allocation fails, but a block may always shrink
+	if (nsize > osize && a->_limit != 0 && a->_allocated + a->_external + (nsize - osize) > a->_limit)
+		return NULL;
+
+	void* block = a->reallocate(ptr, osize, nsize);
+	if (block == NULL && nsize != 0)
+		return NULL;
+
+	a->_allocated += nsize - osize;
+
+	// the hook runs at the next safe point, where it can collect garbage
+	if (nsize > osize && a->_softLimit != 0 && !a->_softLimitExceeded && a->_L != NULL &&
+	    a->_allocated + a->_external > a->_softLimit)
+	{
+		a->_softLimitExceeded = true;
+		luaW_enablehook(a->_L);
+	}
+
+	// the block of the global state is the first allocated and the last freed, by lua_close
+	if (a->_allocated == 0)
+	{
+		if (a->_released)
+			delete a;
+		else
+			a->releaseSlabs();
+	}
+
+	return block;
+}
+
+void* StateAllocator::reallocate( void* ptr, size_t osize, size_t nsize )
+{
+	if (!_pooled)
+	{
+		if (nsize == 0)
+		{
+			free(ptr);
+			return NULL;
+		}
+		else
+			return realloc(ptr, nsize);
+	}
+
+	int oc = ptr == NULL ? sizeClassCount : sizeClassOf(osize);
+	int nc = nsize == 0 ? sizeClassCount : sizeClassOf(nsize);
+
+	if (oc == sizeClassCount && nc == sizeClassCount)
+	{
+		if (nsize == 0)
+		{
+			free(ptr);
+			return NULL;
+		}
+		else
+			return realloc(ptr, unpooledSize(nsize));
+	}
+
+	if (ptr != NULL && oc == nc)
+		return ptr;
+
+	void* block = NULL;
+	if (nsize != 0)
+	{
+		block = nc == sizeClassCount ? malloc(unpooledSize(nsize)) : allocateBlock(nc);
+
+		if (block == NULL)
+		{
+			if (nsize > osize)
+				return NULL;
+
+			// a shrinking block must not fail, so it is shrunk where it is into the smaller size class
+			if (oc == sizeClassCount)
+				return adoptBlock(nc, ptr, nsize);
+			else
+				return splitBlock(oc, nc, ptr);
+		}
+	}
+
+	if (ptr != NULL)
+	{
+		memcpy(block, ptr, osize < nsize ? osize : nsize);
+
+		if (oc == sizeClassCount)
+			free(ptr);
+		else
+			freeBlock(oc, ptr);
+	}
+
+	return block;
+}
+
+void* StateAllocator::allocateBlock( int c )
+{
+	SizeClass& sc = _sizeClasses[c];
+
+	if (sc.freeBlocks == NULL)
+	{
+		SlabHeader* slab = static_cast<SlabHeader*>(malloc(slabSize));
+		if (slab == NULL)
+			return NULL;
+
+		slab->next = static_cast<SlabHeader*>(_slabs);
+		_slabs = slab;
+		++sc.slabs;
+
+		size_t blockSize = (c + 1) * sizeClassGranularity;
+		char* first = reinterpret_cast<char*>(slab + 1);
+		size_t count = (slabSize - sizeof(SlabHeader)) / blockSize;
+
+		// link the blocks in address order so that consecutive allocations are adjacent
+		for (size_t i = count; i > 0; --i)
+		{
+			void* block = first + (i - 1) * blockSize;
+			*static_cast<void**>(block) = sc.freeBlocks;
+			sc.freeBlocks = block;
+		}
+
+		sc.blocksFree += count;
+	}
+
+	void* block = sc.freeBlocks;
+	sc.freeBlocks = *static_cast<void**>(block);
+	--sc.blocksFree;
+	++sc.blocksInUse;
+
+	return block;
+}
+
+void StateAllocator::freeBlock( int c, void* block )
+{
+	SizeClass& sc = _sizeClasses[c];
+
+	*static_cast<void**>(block) = sc.freeBlocks;
+	sc.freeBlocks = block;
+	++sc.blocksFree;
+	--sc.blocksInUse;
+}
+
+// shrinks a pooled block into a smaller size class by freeing its tail, which is a whole block of another size class
+void* StateAllocator::splitBlock( int oc, int nc, void* block )
+{
+	--_sizeClasses[oc].blocksInUse;
+	++_sizeClasses[nc].blocksInUse;
+
+	int rc = oc - nc - 1;
+	void* rest = static_cast<char*>(block) + (nc + 1) * sizeClassGranularity;
+
+	SizeClass& rsc = _sizeClasses[rc];
+	*static_cast<void**>(rest) = rsc.freeBlocks;
+	rsc.freeBlocks = rest;
+	++rsc.blocksFree;
+
+	return block;
+}
+
+// shrinks a block from malloc into a size class by making it a slab of that one block, which is then freed with the
+// other slabs
+void* StateAllocator::adoptBlock( int c, void* ptr, size_t size )
+{
+	SlabHeader* slab = static_cast<SlabHeader*>(ptr);
+	void* block = slab + 1;
+
+	// unpooledSize left room for the header
+	memmove(block, ptr, size);
+
+	slab->next = static_cast<SlabHeader*>(_slabs);
+	_slabs = slab;
+	++_sizeClasses[c].slabs;
+	++_sizeClasses[c].blocksInUse;
+
+	return block;
+}
+
+// frees every slab at once, without visiting their blocks
+void StateAllocator::releaseSlabs( void )
+{
+	SlabHeader* slab = static_cast<SlabHeader*>(_slabs);
+	while (slab != NULL)
+	{
+		SlabHeader* next = slab->next;
+		free(slab);
+		slab = next;
+	}
+
+	_slabs = NULL;
+
+	for (int c = 0; c < sizeClassCount; ++c)
+	{
+		_sizeClasses[c].freeBlocks = NULL;
+		_sizeClasses[c].blocksFree = 0;
+		_sizeClasses[c].slabs = 0;
+	}
+}
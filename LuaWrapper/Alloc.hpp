@@ -0,0 +1,94 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "lua.h"
+
+#include <cstddef>
+
+// the allocator of an instrumented Lua state; it accounts for the memory allocated, optionally fails allocations
+// beyond a hard limit, optionally enables the hook of the state beyond a soft limit, and optionally serves small
+// blocks from slabs of same-sized blocks
+private class StateAllocator
+{
+public:
+	// blocks up to sizeClassCount * sizeClassGranularity bytes are pooled
+	static const int sizeClassCount = 32;
+	static const size_t sizeClassGranularity = 8;
+
+	struct SizeClass
+	{
+		void* freeBlocks;  // linked through the first word of each free block
+		size_t blocksInUse;
+		size_t blocksFree;
+		size_t slabs;
+	};
+
+	explicit StateAllocator( bool pooled );
+
+	// the lua_Alloc function; ud is the StateAllocator
+	static void* alloc( void* ud, void* ptr, size_t osize, size_t nsize );
+
+	// relinquishes the owner's interest in the allocator, which is destroyed once its Lua state is also closed
+	void release( void );
+
+	size_t allocated( void ) const { return _allocated; }
+
+	// the Lua state, once it is opened
+	void setState( lua_State* L ) { _L = L; }
+
+	// the memory used on behalf of the Lua state outside of it, which counts toward the limits
+	size_t external( void ) const { return _external; }
+	void setExternal( size_t external ) { _external = external; }
+
+	// the most memory that may be allocated, or 0 for no limit
+	size_t limit( void ) const { return _limit; }
+	void setLimit( size_t limit ) { _limit = limit; }
+
+	// the memory beyond which an allocation enables the hook of the Lua state, or 0 for no limit
+	size_t softLimit( void ) const { return _softLimit; }
+	void setSoftLimit( size_t softLimit ) { _softLimit = softLimit; }
+
+	// whether an allocation has exceeded the soft limit since the last call
+	bool takeSoftLimitExceeded( void )
+	{
+		bool exceeded = _softLimitExceeded;
+		_softLimitExceeded = false;
+		return exceeded;
+	}
+
+	bool pooled( void ) const { return _pooled; }
+
+	const SizeClass& sizeClass( int i ) const { return _sizeClasses[i]; }
+
+private:
+	~StateAllocator();
+
+	StateAllocator( const StateAllocator& );
+	StateAllocator& operator=( const StateAllocator& );
+
+	void* reallocate( void* ptr, size_t osize, size_t nsize );
+	void* allocateBlock( int c );
+	void freeBlock( int c, void* block );
+	void* splitBlock( int oc, int nc, void* block );
+	void* adoptBlock( int c, void* ptr, size_t size );
+	void releaseSlabs( void );
+
+	lua_State* _L;
+	size_t _allocated;
+	size_t _external;
+	size_t _limit;
+	size_t _softLimit;
+	bool _softLimitExceeded;
+	bool _pooled;
+	bool _released;
+	void* _slabs;  // linked through the header of each slab
+	SizeClass _sizeClasses[sizeClassCount];
+};
@@ -0,0 +1,137 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <vcclr.h>
+
+// the first character that an encoding does not map to the byte of the same value; or 0 if the encoding does
+// not map ASCII to itself
+static inline wchar_t identityLimit( System::Text::Encoding^ e )
+{
+	switch (e->CodePage)
+	{
+		case 28591:  // ISO-8859-1
+			return 0x100;
+
+		case 1252:  // Windows-1252
+		case 20127:  // US-ASCII
+		case 65001:  // UTF-8
+			return 0x80;
+
+		default:
+			return 0;
+	}
+}
+
+// represents a C string encoded from a CLR string; short strings are held inline (on the stack)
+private class NativeString
+{
+public:
+	NativeString( System::String^ s, System::Text::Encoding^ e )
+		: _heap(NULL), _length(0), _isNull(s == nullptr)
+	{
+		if (_isNull)
+			return;
+
+		int charCount = s->Length;
+		pin_ptr<const wchar_t> pinned = PtrToStringChars(s);
+		wchar_t* chars = const_cast<wchar_t*>(static_cast<const wchar_t*>(pinned));
+
+		// narrow in place if every character maps to the byte of the same value
+		wchar_t limit = identityLimit(e);
+		if (limit != 0)
+		{
+			char* buffer = allocate(charCount);
+
+			int i = 0;
+			while (i < charCount && chars[i] < limit)
+			{
+				buffer[i] = static_cast<char>(chars[i]);
+				++i;
+			}
+
+			if (i == charCount)
+			{
+				buffer[charCount] = '\0';
+				_length = charCount;
+				return;
+			}
+		}
+
+		int byteCount = e->GetByteCount(chars, charCount);
+		char* buffer = allocate(byteCount);
+		e->GetBytes(chars, charCount, reinterpret_cast<unsigned char*>(buffer), byteCount);
+		buffer[byteCount] = '\0';
+		_length = byteCount;
+	}
+
+	~NativeString()
+	{
+		free(_heap);
+	}
+
+private:
+	NativeString( const NativeString& );
+	NativeString& operator=( const NativeString& );
+
+public:
+	NativeString( NativeString&& other )
+		: _heap(other._heap), _length(other._length), _isNull(other._isNull)
+	{
+		if (_heap == NULL && !_isNull)
+			memcpy(_inline, other._inline, _length + 1);
+
+		other._heap = NULL;
+	}
+
+	operator char*( void )
+	{
+		return _isNull ? NULL : _heap != NULL ? _heap : _inline;
+	}
+
+	// the number of bytes in the string, not including the terminator
+	size_t length( void ) const
+	{
+		return _length;
+	}
+
+private:
+	static const int _inlineCapacity = 256;
+
+	char* allocate( int length )
+	{
+		if (length < _inlineCapacity)
+			return _inline;
+
+		if (_heap == NULL)
+		{
+			_heap = static_cast<char*>(malloc(length + 1));
+		}
+		else
+		{
+			char* heap = static_cast<char*>(realloc(_heap, length + 1));
+			if (heap == NULL)
+				free(_heap);
+			_heap = heap;
+		}
+
+		if (_heap == NULL)
+			throw gcnew System::OutOfMemoryException();
+
+		return _heap;
+	}
+
+	char _inline[_inlineCapacity];
+	char* _heap;
+	size_t _length;
+	bool _isNull;
+};
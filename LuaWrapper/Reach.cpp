@@ -0,0 +1,330 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "lua.h"
+
+#include "lgc.h"
+#include "lobject.h"
+#include "lstate.h"
+#include "ltable.h"
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* Unlike the Lua collector, the traversal does not modify the objects it marks; marks are kept in a map.  It is
+   conservative: it may find an object reachable that the Lua collector would not (e.g., the entries of weak
+   tables, which are marked as if they were strong), but never the reverse.  A CLI object found only through a
+   weak table is thus kept, since Lua may still read it from the table.  The tables noted as ephemerons (the weak
+   tables internal to the bridge, which Lua cannot read) are the exception: each of their values is marked by
+   the pass that marks its key, and by no other. */
+
+static const int rootpass = 0;
+
+struct luaW_Reach
+{
+	lua_State* L;
+	Table* metatables[2];
+
+	// the pass (rootpass, or 1 + the index of a traced reference) that last marked each object
+	std::unordered_map<GCObject*, int> marks;
+
+	// the index of the traced reference of which each object is the value
+	std::unordered_map<GCObject*, int> tracedvalues;
+
+	// the values of the entries of the ephemerons, by key
+	std::unordered_multimap<GCObject*, const TValue*> ephemerons;
+
+	std::vector<GCObject*> gray;
+	int pass;
+
+	// the results of each pass, concatenated, and where the results of each pass start
+	std::vector<int> slots;
+	std::vector<size_t> slotstarts;
+	std::vector<int> refs;
+	std::vector<size_t> refstarts;
+};
+
+luaW_Reach* luaW_newreach( void )
+{
+	return new luaW_Reach();
+}
+
+void luaW_freereach( luaW_Reach* reach )
+{
+	delete reach;
+}
+
+static bool iscliobject( luaW_Reach* reach, GCObject* o )
+{
+	if (gch(o)->tt != LUA_TUSERDATA)
+		return false;
+
+	Table* mt = gco2u(o)->metatable;
+	return mt != NULL && (mt == reach->metatables[0] || mt == reach->metatables[1]);
+}
+
+static void markobject( luaW_Reach* reach, GCObject* o )
+{
+	std::unordered_map<GCObject*, int>::iterator mark = reach->marks.find(o);
+
+	if (mark != reach->marks.end())
+	{
+		// marked by the roots, or already by this pass
+		if (mark->second == rootpass || mark->second == reach->pass)
+			return;
+
+		mark->second = reach->pass;
+	}
+	else
+	{
+		reach->marks.insert(std::make_pair(o, reach->pass));
+	}
+
+	if (reach->pass != rootpass)
+	{
+		std::unordered_map<GCObject*, int>::const_iterator traced = reach->tracedvalues.find(o);
+
+		// stop at the value of another traced reference, which keeps alive what it reaches
+		if (traced != reach->tracedvalues.end() && traced->second != reach->pass - 1)
+		{
+			reach->refs.push_back(traced->second);
+			return;
+		}
+	}
+
+	reach->gray.push_back(o);
+}
+
+static void markvalue( luaW_Reach* reach, const TValue* v )
+{
+	if (iscollectable(v))
+		markobject(reach, gcvalue(v));
+}
+
+static void marktable( luaW_Reach* reach, Table* t )
+{
+	if (t != NULL)
+		markobject(reach, obj2gco(t));
+}
+
+// weak keys and values are marked like strong ones
+static void traversetable( luaW_Reach* reach, Table* h, const std::unordered_set<int>* excluded )
+{
+	marktable(reach, h->metatable);
+
+	for (int i = 0; i < h->sizearray; ++i)
+		if (excluded == NULL || excluded->count(i + 1) == 0)
+			markvalue(reach, &h->array[i]);
+
+	for (Node* n = gnode(h, 0), * limit = gnode(h, sizenode(h)); n < limit; ++n)
+	{
+		if (ttisnil(gval(n)))
+			continue;
+
+		if (excluded != NULL && ttisnumber(gkey(n)))
+		{
+			lua_Number key = nvalue(gkey(n));
+			if (key == static_cast<int>(key) && excluded->count(static_cast<int>(key)) != 0)
+				continue;
+		}
+
+		if (!ttisdeadkey(gkey(n)))
+			markvalue(reach, gkey(n));
+		markvalue(reach, gval(n));
+	}
+}
+
+static void propagate( luaW_Reach* reach )
+{
+	while (!reach->gray.empty())
+	{
+		GCObject* o = reach->gray.back();
+		reach->gray.pop_back();
+
+		typedef std::unordered_multimap<GCObject*, const TValue*>::const_iterator ephemeron;
+		std::pair<ephemeron, ephemeron> values = reach->ephemerons.equal_range(o);
+		for (ephemeron e = values.first; e != values.second; ++e)
+			markvalue(reach, e->second);
+
+		switch (gch(o)->tt)
+		{
+			case LUA_TUSERDATA:
+			{
+				Udata* u = rawgco2u(o);
+
+				if (iscliobject(reach, o))
+					reach->slots.push_back(*reinterpret_cast<int*>(u + 1));
+
+				marktable(reach, u->uv.metatable);
+				marktable(reach, u->uv.env);
+				break;
+			}
+
+			case LUA_TTABLE:
+				traversetable(reach, gco2t(o), NULL);
+				break;
+
+			case LUA_TLCL:
+			{
+				LClosure* cl = gco2lcl(o);
+				for (int i = 0; i < cl->nupvalues; ++i)
+					if (cl->upvals[i] != NULL)
+						markvalue(reach, cl->upvals[i]->v);
+				break;
+			}
+
+			case LUA_TCCL:
+			{
+				CClosure* cl = gco2ccl(o);
+				for (int i = 0; i < cl->nupvalues; ++i)
+					markvalue(reach, &cl->upvalue[i]);
+				break;
+			}
+
+			case LUA_TTHREAD:
+			{
+				lua_State* th = gco2th(o);
+				for (StkId v = th->stack; v != NULL && v < th->top; ++v)
+					markvalue(reach, v);
+				break;
+			}
+
+			default:
+				// strings and prototypes reference no tables, userdatas, functions, or threads
+				break;
+		}
+	}
+}
+
+// objects with finalizers are roots because a finalizer may resurrect them, except CLI objects, whose
+// finalizer only frees the slot
+static void markfinalizable( luaW_Reach* reach, GCObject* list )
+{
+	for (GCObject* o = list; o != NULL; o = gch(o)->next)
+		if (!iscliobject(reach, o))
+			markobject(reach, o);
+}
+
+void luaW_reachephemerons( luaW_Reach* reach, lua_State* L, int tref, const int* refs, int nrefs )
+{
+	Table* t = hvalue(luaH_getint(hvalue(&G(L)->l_registry), tref));
+
+	for (int i = 0; i < nrefs; ++i)
+	{
+		const TValue* value = luaH_getint(t, refs[i] + 1);
+		if (!ttistable(value))
+			continue;
+
+		Table* h = hvalue(value);
+
+		// the keys of interest are userdatas and functions, which are never in the array part
+		for (Node* n = gnode(h, 0), * limit = gnode(h, sizenode(h)); n < limit; ++n)
+			if (!ttisnil(gval(n)) && !ttisdeadkey(gkey(n)) && iscollectable(gkey(n)))
+				reach->ephemerons.insert(std::make_pair(gcvalue(gkey(n)), static_cast<const TValue*>(gval(n))));
+	}
+}
+
+void luaW_reachroots( luaW_Reach* reach, lua_State* L, const int* excluded, int nexcluded, int mtref1, int mtref2 )
+{
+	global_State* g = G(L);
+	Table* registry = hvalue(&g->l_registry);
+
+	reach->L = L;
+	reach->pass = rootpass;
+
+	const TValue* mt1 = luaH_getint(registry, mtref1);
+	const TValue* mt2 = luaH_getint(registry, mtref2);
+	reach->metatables[0] = ttistable(mt1) ? hvalue(mt1) : NULL;
+	reach->metatables[1] = ttistable(mt2) ? hvalue(mt2) : NULL;
+
+	std::unordered_set<int> excludedrefs(excluded, excluded + nexcluded);
+
+	reach->slotstarts.push_back(reach->slots.size());
+
+	reach->marks.insert(std::make_pair(obj2gco(registry), rootpass));
+	traversetable(reach, registry, &excludedrefs);
+
+	markobject(reach, obj2gco(g->mainthread));
+
+	for (int i = 0; i < LUA_NUMTAGS; ++i)
+		marktable(reach, g->mt[i]);
+
+	markfinalizable(reach, g->finobj);
+	markfinalizable(reach, g->tobefnz);
+
+	// threads that are running (or resuming another thread) may be referenced only from the C stack
+	for (GCObject* o = g->allgc; o != NULL; o = gch(o)->next)
+	{
+		if (gch(o)->tt == LUA_TTHREAD)
+		{
+			lua_State* th = gco2th(o);
+			if (th->status == LUA_OK && th->ci != &th->base_ci)
+				markobject(reach, o);
+		}
+	}
+
+	propagate(reach);
+}
+
+void luaW_reachtraced( luaW_Reach* reach, lua_State* L, int tref, const int* traced, int ntraced )
+{
+	Table* t = hvalue(luaH_getint(hvalue(&G(L)->l_registry), tref));
+
+	for (int i = 0; i < ntraced; ++i)
+	{
+		const TValue* value = luaH_getint(t, traced[i] + 1);
+		if (iscollectable(value))
+			reach->tracedvalues.insert(std::make_pair(gcvalue(value), i));
+	}
+
+	for (int i = 0; i < ntraced; ++i)
+	{
+		reach->pass = i + 1;
+		reach->slotstarts.push_back(reach->slots.size());
+		reach->refstarts.push_back(reach->refs.size());
+
+		const TValue* value = luaH_getint(t, traced[i] + 1);
+		if (!iscollectable(value))
+			continue;
+
+		GCObject* o = gcvalue(value);
+		std::unordered_map<GCObject*, int>::iterator mark = reach->marks.find(o);
+
+		if (mark == reach->marks.end())
+			reach->marks.insert(std::make_pair(o, reach->pass));
+		else if (mark->second != rootpass)
+			mark->second = reach->pass;
+		else
+			continue;
+
+		// the value of this reference is traversed even if it is also the value of another
+		reach->gray.push_back(o);
+		propagate(reach);
+	}
+}
+
+const int* luaW_reachslots( luaW_Reach* reach, int index, int* n )
+{
+	size_t pass = static_cast<size_t>(index + 1);
+	size_t start = reach->slotstarts[pass];
+	size_t end = pass + 1 < reach->slotstarts.size() ? reach->slotstarts[pass + 1] : reach->slots.size();
+
+	*n = static_cast<int>(end - start);
+	return reach->slots.empty() ? NULL : &reach->slots[0] + start;
+}
+
+const int* luaW_reachrefs( luaW_Reach* reach, int index, int* n )
+{
+	size_t start = reach->refstarts[index];
+	size_t end = static_cast<size_t>(index) + 1 < reach->refstarts.size() ? reach->refstarts[index + 1] : reach->refs.size();
+
+	*n = static_cast<int>(end - start);
+	return reach->refs.empty() ? NULL : &reach->refs[0] + start;
+}
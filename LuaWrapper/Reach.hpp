@@ -0,0 +1,38 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "lua.h"
+
+// a traversal of the objects of a Lua state that finds which CLI objects (userdatas with either of two
+// metatables, whose memory holds the slot of the object) are kept alive by what
+struct luaW_Reach;
+
+extern luaW_Reach* luaW_newreach( void );
+extern void luaW_freereach( luaW_Reach* reach );
+
+// notes the tables at the references (the indices, from 0, of the array part of the table at tref in the
+// registry) as ephemerons, which are not traversed but whose values are marked by whichever pass marks their keys
+extern void luaW_reachephemerons( luaW_Reach* reach, lua_State* L, int tref, const int* refs, int nrefs );
+
+// marks the objects reachable from the roots of the Lua state other than the values in the registry at the
+// excluded references; the metatables of CLI objects are in the registry at mtref1 and mtref2
+extern void luaW_reachroots( luaW_Reach* reach, lua_State* L, const int* excluded, int nexcluded, int mtref1, int mtref2 );
+
+// marks, for each traced reference in turn, the objects reachable from its value but not from the roots,
+// stopping at the values of the other traced references; the references are the indices (from 0) of the array
+// part of the table at tref in the registry
+extern void luaW_reachtraced( luaW_Reach* reach, lua_State* L, int tref, const int* traced, int ntraced );
+
+// the slots of the CLI objects reachable from the roots (index -1) or from the traced reference at index
+extern const int* luaW_reachslots( luaW_Reach* reach, int index, int* n );
+
+// the indices of the traced references whose values are reachable from the traced reference at index
+extern const int* luaW_reachrefs( luaW_Reach* reach, int index, int* n );
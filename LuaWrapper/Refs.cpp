@@ -0,0 +1,65 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "lua.h"
+
+#include "lapi.h"
+#include "lgc.h"
+#include "lobject.h"
+#include "lstate.h"
+#include "ltable.h"
+
+/* The references of the bridge are the slots of the array part of a table in the registry.  The bridge keeps
+   the list of free slots itself and sizes the array part to hold every slot, so a slot is accessed directly,
+   and the table is never rehashed, since no key is ever added to its hash part. */
+
+static Table* refstable( lua_State* L, int refsref )
+{
+	const TValue* refs = luaH_getint(hvalue(&G(L)->l_registry), refsref);
+	api_check(L, ttistable(refs), "table of references expected");
+	return hvalue(refs);
+}
+
+void luaW_resizerefs( lua_State* L, int refsref, int size )
+{
+	Table* t = refstable(L, refsref);
+
+	if (t->sizearray < size)
+		luaH_resizearray(L, t, size);
+}
+
+void luaW_pushref( lua_State* L, int refsref, int slot )
+{
+	setobj2s(L, L->top, &refstable(L, refsref)->array[slot]);
+	api_incr_top(L);
+}
+
+void luaW_setrefs( lua_State* L, int refsref, const int* slots, const int* indices, int n )
+{
+	Table* t = refstable(L, refsref);
+
+	for (int i = 0; i < n; ++i)
+	{
+		// lua_pushvalue accepts any acceptable index, including pseudo-indices
+		lua_pushvalue(L, indices[i]);
+
+		TValue* slot = &t->array[slots[i]];
+		setobj2t(L, slot, L->top - 1);
+		L->top--;
+		luaC_barrierback(L, obj2gco(t), slot);
+	}
+}
+
+void luaW_clearrefs( lua_State* L, int refsref, const int* slots, int n )
+{
+	Table* t = refstable(L, refsref);
+
+	for (int i = 0; i < n; ++i)
+		setnilvalue(&t->array[slots[i]]);
+}
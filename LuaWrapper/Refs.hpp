@@ -0,0 +1,26 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "lua.h"
+
+// the table of references is at refsref in the registry; its slots are numbered from 0
+
+// grows the array part of the table of references to hold at least size slots
+extern void luaW_resizerefs( lua_State* L, int refsref, int size );
+
+// pushes the value of a slot
+extern void luaW_pushref( lua_State* L, int refsref, int slot );
+
+// copies the value at each stack index into a slot; needs one free stack slot
+extern void luaW_setrefs( lua_State* L, int refsref, const int* slots, const int* indices, int n );
+
+// sets each slot to nil
+extern void luaW_clearrefs( lua_State* L, int refsref, const int* slots, int n );
@@ -0,0 +1,36 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "lua.h"
+
+#include "lstate.h"
+
+lua_State* luaW_mainthread( lua_State* L )
+{
+	return G(L)->mainthread;
+}
+
+// the number of stack levels below the function called by the innermost protected call that has a message
+// handler; called from the message handler, these are the levels that are not part of the error
+int luaW_protectedlevels( lua_State* L )
+{
+	int levels = 0;
+
+	for (CallInfo* ci = L->ci; ci != &L->base_ci; ci = ci->previous)
+		if (reinterpret_cast<char*>(ci->func) - reinterpret_cast<char*>(L->stack) < L->errfunc)
+			++levels;
+
+	return levels;
+}
+
+// whether the collector is in generational mode; lua_gc can change the mode but not report it
+int luaW_isgenerational( lua_State* L )
+{
+	return G(L)->gckind == KGC_GEN;
+}
@@ -0,0 +1,16 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "lua.h"
+
+extern lua_State* luaW_mainthread( lua_State* L );
+extern int luaW_protectedlevels( lua_State* L );
+extern int luaW_isgenerational( lua_State* L );
@@ -0,0 +1,194 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#include "Table.hpp"
+#include "lua.h"
+
+#include "lapi.h"
+#include "ldebug.h"
+#include "lgc.h"
+#include "lobject.h"
+#include "lstate.h"
+#include "lstring.h"
+#include "ltable.h"
+
+#include <cstdint>
+#include <cstring>
+
+// the array part of the table on the top of the stack, grown to hold the indices up to first + n
+static TValue* arraypart( lua_State* L, int n, int first )
+{
+	Table* t = hvalue(L->top - 1);
+
+	if (t->sizearray < first + n)
+		luaH_resizearray(L, t, first + n);
+
+	return t->array + first;
+}
+
+template <typename T>
+static void setarraynumbers( lua_State* L, const T* values, int n, int first )
+{
+	TValue* array = arraypart(L, n, first);
+
+	for (int i = 0; i < n; ++i)
+	{
+		setnvalue(&array[i], cast_num(values[i]));
+		luai_checknum(L, &array[i],
+			luaG_runerror(L, "C API - attempt to push a signaling NaN"));
+	}
+}
+
+void luaW_setarraynumbers( lua_State* L, const double* values, int n, int first )
+{
+	setarraynumbers(L, values, n, first);
+}
+
+void luaW_setarraynumbers( lua_State* L, const float* values, int n, int first )
+{
+	setarraynumbers(L, values, n, first);
+}
+
+void luaW_setarraynumbers( lua_State* L, const int* values, int n, int first )
+{
+	setarraynumbers(L, values, n, first);
+}
+
+void luaW_setarraynumbers( lua_State* L, const unsigned char* values, int n, int first )
+{
+	setarraynumbers(L, values, n, first);
+}
+
+void luaW_setarraybooleans( lua_State* L, const bool* values, int n, int first )
+{
+	TValue* array = arraypart(L, n, first);
+
+	for (int i = 0; i < n; ++i)
+		setbvalue(&array[i], values[i]);
+}
+
+void luaW_setarraystrings( lua_State* L, const char* buffer, const int* lengths, int n, int first )
+{
+	Table* t = hvalue(L->top - 1);
+	TValue* array = arraypart(L, n, first);
+
+	for (int i = 0; i < n; ++i)
+	{
+		if (lengths[i] < 0)
+			continue;
+
+		// no collection step runs until the check below, so each new string is referenced before then
+		setsvalue2n(L, &array[i], luaS_newlstr(L, buffer, lengths[i]));
+		luaC_barrierback(L, obj2gco(t), &array[i]);
+
+		buffer += lengths[i];
+	}
+
+	luaC_checkGC(L);
+}
+
+// identifies a key by its value, ignoring the bytes of the value that its type does not use
+static long long keyid( const TValue* key )
+{
+	if (ttisnumber(key))
+	{
+		lua_Number n = nvalue(key);
+		long long id;
+		memcpy(&id, &n, sizeof id);
+		return id;
+	}
+	else if (ttisboolean(key))
+		return bvalue(key);
+	else if (ttislightuserdata(key))
+		return reinterpret_cast<intptr_t>(pvalue(key));
+	else if (ttislcf(key))
+		return reinterpret_cast<intptr_t>(fvalue(key));
+	else if (ttisdeadkey(key))
+		return reinterpret_cast<intptr_t>(deadvalue(key));
+	else
+		return reinterpret_cast<intptr_t>(gcvalue(key));
+}
+
+// whether the pair before the position still has the key last found
+static bool haskey( Table* t, const luaW_PairCursor* cursor )
+{
+	int i = cursor->position - 1;
+
+	// a key in the array part is its position
+	if (i < t->sizearray)
+		return true;
+
+	const TValue* key = gkey(gnode(t, i - t->sizearray));
+
+	// the key of a pair whose value was removed may have been marked dead by the collector
+	if (ttisdeadkey(key))
+		return (cursor->keytt & BIT_ISCOLLECTABLE) != 0 && keyid(key) == cursor->key;
+
+	return rttype(key) == cursor->keytt && keyid(key) == cursor->key;
+}
+
+int luaW_nextpair( lua_State* L, luaW_PairCursor* cursor )
+{
+	Table* t = hvalue(L->top - 1);
+
+	/* A rehash allocates the new parts before freeing the old, so it changes the layout unless the allocator reuses
+	   the address, e.g., after another rehash; so the key last found is checked too.  If the key is where it was,
+	   continuing from it is what lua_next would do. */
+	if (cursor->position == 0)
+	{
+		cursor->node = t->node;
+		cursor->sizearray = t->sizearray;
+	}
+	else if (t->node != cursor->node || t->sizearray != cursor->sizearray || !haskey(t, cursor))
+	{
+		return -1;
+	}
+
+	int i = cursor->position;
+
+	for (; i < t->sizearray; ++i)
+	{
+		if (!ttisnil(&t->array[i]))
+		{
+			setnvalue(L->top, cast_num(i + 1));
+			api_incr_top(L);
+			setobj2s(L, L->top, &t->array[i]);
+			api_incr_top(L);
+			cursor->position = i + 1;
+			break;
+		}
+	}
+
+	// positions after the array part are those of the hash part
+	if (i >= t->sizearray)
+	{
+		for (i -= t->sizearray; i < sizenode(t); ++i)
+		{
+			Node* n = gnode(t, i);
+
+			if (!ttisnil(gval(n)))
+			{
+				setobj2s(L, L->top, gkey(n));
+				api_incr_top(L);
+				setobj2s(L, L->top, gval(n));
+				api_incr_top(L);
+				cursor->position = t->sizearray + i + 1;
+				break;
+			}
+		}
+
+		if (i >= sizenode(t))
+			return 0;
+	}
+
+	const TValue* key = L->top - 2;
+	cursor->keytt = rttype(key);
+	cursor->key = keyid(key);
+	return 1;
+}
@@ -0,0 +1,39 @@
+/* LuaCLRBridge
+ * Copyright 2014 Sandia Corporation.
+ * Under the terms of Contract DE-AC04-94AL85000 with Sandia Corporation,
+ * the U.S. Government retains certain rights in this software.
+ * 
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+#pragma once
+
+#include "lua.h"
+
+// each sets the values at indices first + 1 through first + n of the table on the top of the stack, which
+// must have no metatable, by writing them directly into its array part
+extern void luaW_setarraynumbers( lua_State* L, const double* values, int n, int first );
+extern void luaW_setarraynumbers( lua_State* L, const float* values, int n, int first );
+extern void luaW_setarraynumbers( lua_State* L, const int* values, int n, int first );
+extern void luaW_setarraynumbers( lua_State* L, const unsigned char* values, int n, int first );
+extern void luaW_setarraybooleans( lua_State* L, const bool* values, int n, int first );
+
+// the strings are consecutive in the buffer; a negative length is a nil value
+extern void luaW_setarraystrings( lua_State* L, const char* buffer, const int* lengths, int n, int first );
+
+// a position in the pairs of a table (counting the array part and then the hash part, so that no key lookup is
+// needed), with the layout of the table when the position was started and the key of the pair last found
+struct luaW_PairCursor
+{
+	int position;  // 0 before the first pair
+	const void* node;
+	int sizearray;
+	int keytt;
+	long long key;
+};
+
+// pushes the key and value of the first pair at or after the position in the table on the top of the stack and
+// advances the position past it, and returns 1; or pushes nothing and returns 0 if there is no such pair; or,
+// if the table was rehashed so that the pair last found is no longer where it was, pushes nothing and returns -1
+extern int luaW_nextpair( lua_State* L, luaW_PairCursor* cursor );
@@ -7,16 +7,22 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
+#include "Alloc.hpp"
 #include "HGlobal.hpp"
 #include "Hook.hpp"
 #include "StackTrace.hpp"
-#include "PinnedString.hpp"
+#include "NativeString.hpp"
+#include "Reach.hpp"
+#include "Refs.hpp"
+#include "State.hpp"
+#include "Table.hpp"
 
 #include "lua.h"
 #include "lualib.h"
 #include "lauxlib.h"
 
 #include <cassert>
+#include <climits>
 #include <cstdlib>
 #include <cstring>
 
@@ -31,30 +37,40 @@ extern int pmain( lua_State* L );
 namespace Lua
 {
 	// helper for converting a CLR string to a C string
-	static PinnedString toCString( String^ s, Encoding^ e )
+	static inline NativeString toCString( String^ s, Encoding^ e )
 	{
-		if (s == nullptr)
-			return PinnedString(nullptr);
-
-		array<unsigned char>^ cs = e->GetBytes(s);
-		Array::Resize(cs, cs->Length + 1);
-		return PinnedString(cs);
-	}
-
-	// helper for converting a CLR string to a fixed-length string
-	static inline array<unsigned char>^ toBytes( String^ s, Encoding^ e )
-	{
-		return s == nullptr ?
-			nullptr :
-			e->GetBytes(s);
+		return NativeString(s, e);
 	}
 
 	// helper for converting a fixed-length string to a CLR string
-	static inline String^ toCLRString( const char* s, int length, Encoding^ e )
+	static String^ toCLRString( const char* s, int length, Encoding^ e )
 	{
-		return s == NULL ?
-			nullptr :
-			gcnew String(s, 0, length, e);
+		static const int inlineCapacity = 256;
+
+		if (s == NULL)
+			return nullptr;
+
+		if (length == 0)
+			return String::Empty;
+
+		// widen without a decoder if every byte maps to the character of the same value
+		wchar_t limit = identityLimit(e);
+		if (limit != 0 && length <= inlineCapacity)
+		{
+			wchar_t chars[inlineCapacity];
+
+			int i = 0;
+			while (i < length && static_cast<unsigned char>(s[i]) < limit)
+			{
+				chars[i] = static_cast<unsigned char>(s[i]);
+				++i;
+			}
+
+			if (i == length)
+				return gcnew String(chars, 0, length);
+		}
+
+		return gcnew String(s, 0, length, e);
 	}
 
 	// helper for converting a C string to a CLR string
@@ -62,7 +78,7 @@ namespace Lua
 	{
 		return s == NULL ?
 			nullptr :
-			gcnew String(s, 0, strlen(s), e);
+			toCLRString(s, static_cast<int>(strlen(s)), e);
 	}
 
 #define UNMACRO(T, M) static T const (M##_) = (M);
@@ -270,6 +286,10 @@ namespace Lua
 	UNMACRO(int, LUA_GCSTEP)
 	UNMACRO(int, LUA_GCSETPAUSE)
 	UNMACRO(int, LUA_GCSETSTEPMUL)
+	UNMACRO(int, LUA_GCSETMAJORINC)
+	UNMACRO(int, LUA_GCISRUNNING)
+	UNMACRO(int, LUA_GCGEN)
+	UNMACRO(int, LUA_GCINC)
 #undef LUA_GCSTOP
 #undef LUA_GCRESTART
 #undef LUA_GCCOLLECT
@@ -278,6 +298,10 @@ namespace Lua
 #undef LUA_GCSTEP
 #undef LUA_GCSETPAUSE
 #undef LUA_GCSETSTEPMUL
+#undef LUA_GCSETMAJORINC
+#undef LUA_GCISRUNNING
+#undef LUA_GCGEN
+#undef LUA_GCINC
 #pragma endregion
 
 	/*
@@ -293,6 +317,10 @@ namespace Lua
 		LUA_GCSTEP = LUA_GCSTEP_,
 		LUA_GCSETPAUSE = LUA_GCSETPAUSE_,
 		LUA_GCSETSTEPMUL = LUA_GCSETSTEPMUL_,
+		LUA_GCSETMAJORINC = LUA_GCSETMAJORINC_,
+		LUA_GCISRUNNING = LUA_GCISRUNNING_,
+		LUA_GCGEN = LUA_GCGEN_,
+		LUA_GCINC = LUA_GCINC_,
 	};
 
 #pragma region LuaHookEvent_Unmacroing
@@ -693,8 +721,8 @@ namespace Lua
 
 		static IntPtr lua_pushstring( LuaStatePtr L, String^ s, Encoding^ stringEncoding )
 		{
-			array<unsigned char>^ s_bytes = toBytes(s, stringEncoding);
-			const char* ret = ::lua_pushlstring(toLuaStatePtr(L), PinnedString(s_bytes), s_bytes == nullptr ? 0 : s_bytes->Length);
+			NativeString s_(s, stringEncoding);
+			const char* ret = ::lua_pushlstring(toLuaStatePtr(L), s_, s_.length());
 			return IntPtr(const_cast<char*>(ret));
 		}
 
@@ -1093,8 +1121,8 @@ namespace Lua
 
 		static IntPtr lua_pushliteral( LuaStatePtr L, String^ s, Encoding^ stringEncoding )
 		{
-			array<unsigned char>^ s_bytes = toBytes(s, stringEncoding);
-			const char* ret = ::lua_pushlstring(toLuaStatePtr(L), PinnedString(s_bytes), s_bytes == nullptr ? 0 : s_bytes->Length);
+			NativeString s_(s, stringEncoding);
+			const char* ret = ::lua_pushlstring(toLuaStatePtr(L), s_, s_.length());
 			return IntPtr(const_cast<char*>(ret));
 		}
 
@@ -1507,9 +1535,9 @@ namespace Lua
 
 		static String^ luaL_optstring( LuaStatePtr L, int n, String^ d, Encoding^ stringEncoding )
 		{
-			PinnedString pinned_d(toCString(d, stringEncoding));  // cannot be r-value (may be returned)
-			const char* ret = ::luaL_optlstring(toLuaStatePtr(L), n, pinned_d, NULL);
-			return ret == pinned_d ? d : toCLRString(ret, stringEncoding);
+			NativeString d_(d, stringEncoding);  // cannot be r-value (may be returned)
+			const char* ret = ::luaL_optlstring(toLuaStatePtr(L), n, d_, NULL);
+			return ret == d_ ? d : toCLRString(ret, stringEncoding);
 		}
 
 #undef luaL_checkint
@@ -1586,8 +1614,8 @@ namespace Lua
 
 		static LuaStatus luaW_loadbufferx( LuaStatePtr L, String^ buff, String^ name, String^ mode, Encoding^ chunkEncoding, Encoding^ chunknameEncoding )
 		{
-			array<unsigned char>^ buff_bytes = toBytes(buff, chunkEncoding);
-			return static_cast<LuaStatus>(::luaL_loadbufferx(toLuaStatePtr(L), PinnedString(buff_bytes), buff_bytes == nullptr ? 0 : buff_bytes->Length, toCString(name, chunknameEncoding), toCString(mode, Encoding::ASCII)));
+			NativeString buff_(buff, chunkEncoding);
+			return static_cast<LuaStatus>(::luaL_loadbufferx(toLuaStatePtr(L), buff_, buff_.length(), toCString(name, chunknameEncoding), toCString(mode, Encoding::ASCII)));
 		}
 
 		static LuaStatus luaW_loadbuffer( LuaStatePtr L, String^ buff, String^ name, Encoding^ chunkEncoding, Encoding^ chunknameEncoding )
@@ -1595,6 +1623,101 @@ namespace Lua
 			return luaW_loadbufferx(L, buff, name, nullptr, chunkEncoding, chunknameEncoding);
 		}
 
+		static LuaStatus luaW_loadbufferx( LuaStatePtr L, array<unsigned char>^ buff, String^ name, String^ mode, Encoding^ chunknameEncoding )
+		{
+			pin_ptr<unsigned char> pin_buff = nullptr;
+			if (buff->Length != 0)
+				pin_buff = &buff[0];
+			return static_cast<LuaStatus>(::luaL_loadbufferx(toLuaStatePtr(L), reinterpret_cast<const char*>(pin_buff), buff->Length, toCString(name, chunknameEncoding), toCString(mode, Encoding::ASCII)));
+		}
+
+		// each sets the values of a new table on the top of the stack, starting after index first, in one call
+
+		static void luaW_setarray( LuaStatePtr L, array<double>^ values, int first )
+		{
+			pin_ptr<double> pin_values = nullptr;
+			if (values->Length != 0)
+				pin_values = &values[0];
+			::luaW_setarraynumbers(toLuaStatePtr(L), pin_values, values->Length, first);
+		}
+
+		static void luaW_setarray( LuaStatePtr L, array<float>^ values, int first )
+		{
+			pin_ptr<float> pin_values = nullptr;
+			if (values->Length != 0)
+				pin_values = &values[0];
+			::luaW_setarraynumbers(toLuaStatePtr(L), pin_values, values->Length, first);
+		}
+
+		static void luaW_setarray( LuaStatePtr L, array<int>^ values, int first )
+		{
+			pin_ptr<int> pin_values = nullptr;
+			if (values->Length != 0)
+				pin_values = &values[0];
+			::luaW_setarraynumbers(toLuaStatePtr(L), pin_values, values->Length, first);
+		}
+
+		static void luaW_setarray( LuaStatePtr L, array<unsigned char>^ values, int first )
+		{
+			pin_ptr<unsigned char> pin_values = nullptr;
+			if (values->Length != 0)
+				pin_values = &values[0];
+			::luaW_setarraynumbers(toLuaStatePtr(L), pin_values, values->Length, first);
+		}
+
+		static void luaW_setarray( LuaStatePtr L, array<bool>^ values, int first )
+		{
+			pin_ptr<bool> pin_values = nullptr;
+			if (values->Length != 0)
+				pin_values = &values[0];
+			::luaW_setarraybooleans(toLuaStatePtr(L), pin_values, values->Length, first);
+		}
+
+		// the strings are encoded into one buffer; null strings are nil values
+		static void luaW_setarray( LuaStatePtr L, array<String^>^ values, int first, Encoding^ stringEncoding )
+		{
+			array<int>^ lengths = gcnew array<int>(values->Length + 1);
+
+			int total = 0;
+			for (int i = 0; i < values->Length; ++i)
+			{
+				lengths[i] = values[i] != nullptr ? stringEncoding->GetByteCount(values[i]) : -1;
+				if (lengths[i] > 0)
+					total += lengths[i];
+			}
+
+			array<unsigned char>^ buffer = gcnew array<unsigned char>(total + 1);
+
+			int offset = 0;
+			for (int i = 0; i < values->Length; ++i)
+				if (values[i] != nullptr)
+					offset += stringEncoding->GetBytes(values[i], 0, values[i]->Length, buffer, offset);
+
+			pin_ptr<unsigned char> pin_buffer = &buffer[0];
+			pin_ptr<int> pin_lengths = &lengths[0];
+			::luaW_setarraystrings(toLuaStatePtr(L), reinterpret_cast<const char*>(pin_buffer), pin_lengths, values->Length, first);
+		}
+
+		// iterates the table on the top of the stack by position rather than by key, as lua_next would; the
+		// arguments after the position are the rest of the cursor, which are only kept between calls
+		static int luaW_nextpair( LuaStatePtr L, int% position, IntPtr% node, int% sizearray, int% keytype, Int64% key )
+		{
+			::luaW_PairCursor cursor = { position, node.ToPointer(), sizearray, keytype, key };
+			int result = ::luaW_nextpair(toLuaStatePtr(L), &cursor);
+			position = cursor.position;
+			node = IntPtr(const_cast<void*>(cursor.node));
+			sizearray = cursor.sizearray;
+			keytype = cursor.keytt;
+			key = cursor.key;
+			return result;
+		}
+
+		// the chunk is read in place as a single block, e.g., from a memory-mapped file
+		static LuaStatus luaW_loadbufferx( LuaStatePtr L, IntPtr buff, size_t sz, String^ name, String^ mode, Encoding^ chunknameEncoding )
+		{
+			return static_cast<LuaStatus>(::luaL_loadbufferx(toLuaStatePtr(L), static_cast<const char*>(buff.ToPointer()), sz, toCString(name, chunknameEncoding), toCString(mode, Encoding::ASCII)));
+		}
+
 		/*
 		** custom debug hook functions
 		*/
@@ -1620,6 +1743,72 @@ namespace Lua
 			return ::luaW_disablehook(toLuaStatePtr(L));
 		}
 
+		/*
+		** table of references functions
+		*/
+
+		static void luaW_resizerefs( LuaStatePtr L, int refsref, int size )
+		{
+			::luaW_resizerefs(toLuaStatePtr(L), refsref, size);
+		}
+
+		static void luaW_pushref( LuaStatePtr L, int refsref, int slot )
+		{
+			::luaW_pushref(toLuaStatePtr(L), refsref, slot);
+		}
+
+		static void luaW_setref( LuaStatePtr L, int refsref, int slot, int index )
+		{
+			::luaW_setrefs(toLuaStatePtr(L), refsref, &slot, &index, 1);
+		}
+
+		// sets the first n slots in the array, in one call
+		static void luaW_setrefs( LuaStatePtr L, int refsref, array<int>^ slots, array<int>^ indices, int n )
+		{
+			if (n < 0 || n > slots->Length || n > indices->Length)
+				throw gcnew ArgumentOutOfRangeException("n");
+			if (n == 0)
+				return;
+			pin_ptr<int> pin_slots = &slots[0];
+			pin_ptr<int> pin_indices = &indices[0];
+			::luaW_setrefs(toLuaStatePtr(L), refsref, pin_slots, pin_indices, n);
+		}
+
+		static void luaW_clearref( LuaStatePtr L, int refsref, int slot )
+		{
+			::luaW_clearrefs(toLuaStatePtr(L), refsref, &slot, 1);
+		}
+
+		// clears the first n slots in the array, in one call
+		static void luaW_clearrefs( LuaStatePtr L, int refsref, array<int>^ slots, int n )
+		{
+			if (n < 0 || n > slots->Length)
+				throw gcnew ArgumentOutOfRangeException("n");
+			if (n == 0)
+				return;
+			pin_ptr<int> pin_slots = &slots[0];
+			::luaW_clearrefs(toLuaStatePtr(L), refsref, pin_slots, n);
+		}
+
+		/*
+		** custom state functions
+		*/
+
+		static LuaStatePtr luaW_mainthread( LuaStatePtr L )
+		{
+			return LuaStatePtr(::luaW_mainthread(toLuaStatePtr(L)));
+		}
+
+		static int luaW_protectedlevels( LuaStatePtr L )
+		{
+			return ::luaW_protectedlevels(toLuaStatePtr(L));
+		}
+
+		static bool luaW_isgenerational( LuaStatePtr L )
+		{
+			return ::luaW_isgenerational(toLuaStatePtr(L)) != 0;
+		}
+
 		/*
 		** custom traceback functions
 		*/
@@ -1733,16 +1922,44 @@ namespace Lua
 		}
 	};
 
+	// the statistics of the blocks of one size served by a pooling allocator
+	[Serializable]
+	public value struct LuaAllocSizeClass
+	{
+	private:
+		int blockSize;
+		Int64 blocksInUse;
+		Int64 blocksFree;
+		Int64 slabs;
+
+	internal:
+		LuaAllocSizeClass( int blockSize, const StateAllocator::SizeClass& sizeClass )
+			: blockSize(blockSize),
+			  blocksInUse(static_cast<Int64>(sizeClass.blocksInUse)),
+			  blocksFree(static_cast<Int64>(sizeClass.blocksFree)),
+			  slabs(static_cast<Int64>(sizeClass.slabs))
+		{
+		}
+
+	public:
+		property int BlockSize { int get() { return blockSize; } }
+
+		property Int64 BlocksInUse { Int64 get() { return blocksInUse; } }
+
+		property Int64 BlocksFree { Int64 get() { return blocksFree; } }
+
+		property Int64 Slabs { Int64 get() { return slabs; } }
+	};
+
 	public ref class LuaAllocTracker
 	{
 	internal:
-		size_t* _allocated;
+		StateAllocator* _allocator;
 
 	internal:
-		LuaAllocTracker()
-			: _allocated(new size_t())
+		LuaAllocTracker( bool pooled )
+			: _allocator(new StateAllocator(pooled))
 		{
-			*_allocated = 0;
 		}
 
 		~LuaAllocTracker()
@@ -1752,33 +1969,342 @@ namespace Lua
 			GC::SuppressFinalize(this);
 		}
 
+		// the allocator outlives the tracker if the Lua state is not yet closed
 		!LuaAllocTracker()
 		{
-			delete _allocated;
+			if (_allocator != NULL)
+				_allocator->release();
+			_allocator = NULL;
 		}
 
 	public:
 		property UIntPtr Allocated
 		{
-			UIntPtr get() { return UIntPtr(*_allocated); }
+			UIntPtr get() { return UIntPtr(_allocator->allocated()); }
+		}
+
+		property UIntPtr External
+		{
+			UIntPtr get() { return UIntPtr(_allocator->external()); }
+			void set( UIntPtr value ) { _allocator->setExternal(static_cast<size_t>(value.ToUInt64())); }
+		}
+
+		property UIntPtr Limit
+		{
+			UIntPtr get() { return UIntPtr(_allocator->limit()); }
+			void set( UIntPtr value ) { _allocator->setLimit(static_cast<size_t>(value.ToUInt64())); }
+		}
+
+		property UIntPtr SoftLimit
+		{
+			UIntPtr get() { return UIntPtr(_allocator->softLimit()); }
+			void set( UIntPtr value ) { _allocator->setSoftLimit(static_cast<size_t>(value.ToUInt64())); }
+		}
+
+		property bool Pooled
+		{
+			bool get() { return _allocator->pooled(); }
+		}
+
+		array<LuaAllocSizeClass>^ GetSizeClasses()
+		{
+			array<LuaAllocSizeClass>^ sizeClasses = gcnew array<LuaAllocSizeClass>(StateAllocator::sizeClassCount);
+
+			for (int i = 0; i < sizeClasses->Length; ++i)
+			{
+				int blockSize = static_cast<int>((i + 1) * StateAllocator::sizeClassGranularity);
+				sizeClasses[i] = LuaAllocSizeClass(blockSize, _allocator->sizeClass(i));
+			}
+
+			return sizeClasses;
 		}
 	};
 
-	static void* LuaAllocTracker_alloc( void* ud, void* ptr, size_t osize, size_t nsize )
+	// a fixed number of samples of the call stack of a Lua state, captured by its hook and drained by another thread
+	public ref class LuaSampler
 	{
-		if (ptr == NULL)
-			*(size_t*)ud += nsize;
-		else
-			*(size_t*)ud += nsize - osize;
+	public:
+		static const int MaxDepth = 32;
+
+	private:
+		struct Frame
+		{
+			char source[LUA_IDSIZE];
+			char name[32];
+			int linedefined;
+			char what;
+		};
+
+		struct Sample
+		{
+			int depth;
+			Frame frames[MaxDepth];
+		};
+
+		Sample* samples;
+		int capacity;
+
+		// the CLI delegates of the frames that are CLR functions, in the same order as the frames
+		array<Object^>^ clrFunctions;
 
-		if (nsize == 0)
+		// the positions only increase, so they are 64-bit lest they overflow in a long-running process; they are
+		// read and written atomically even where 64-bit accesses are not
+
+		// written only by the hook
+		Int64 head;
+		Int64 dropped;
+
+		// written only by the thread that drains
+		Int64 tail;
+
+		int objectMetatableRef;
+		Func<int, Object^>^ getCFunctionDelegate;
+
+		Encoding^ encoding;
+
+	public:
+		// getCFunctionDelegate gets the delegate of a cfunction from the slot in the object table of its proxy,
+		// which is the first upvalue of the cfunction and has the metatable referenced by objectMetatableRef
+		LuaSampler( int capacity, int objectMetatableRef, Func<int, Object^>^ getCFunctionDelegate, Encoding^ encoding )
+			: samples(NULL),
+			  capacity(capacity),
+			  clrFunctions(gcnew array<Object^>(capacity * MaxDepth)),
+			  head(0),
+			  dropped(0),
+			  tail(0),
+			  objectMetatableRef(objectMetatableRef),
+			  getCFunctionDelegate(getCFunctionDelegate),
+			  encoding(encoding)
 		{
-			free(ptr);
-			return NULL;
+			samples = static_cast<Sample*>(malloc(sizeof(Sample) * capacity));
+			if (samples == NULL)
+				throw gcnew OutOfMemoryException();
 		}
-		else
-			return realloc(ptr, nsize);
-	}
+
+		~LuaSampler()
+		{
+			this->!LuaSampler();
+
+			GC::SuppressFinalize(this);
+		}
+
+		!LuaSampler()
+		{
+			free(samples);
+			samples = NULL;
+		}
+
+	public:
+		property int Capacity
+		{
+			int get() { return capacity; }
+		}
+
+		// the number of samples captured but not yet drained
+		property int Count
+		{
+			int get() { return static_cast<int>(Threading::Interlocked::Read(head) - Threading::Interlocked::Read(tail)); }
+		}
+
+		// the number of samples not captured because the samples were not drained in time
+		property Int64 Dropped
+		{
+			Int64 get() { return Threading::Interlocked::Read(dropped); }
+		}
+
+	internal:
+		// captures the call stack without allocating; called from the hook, which leaves LUA_MINSTACK free slots
+		void capture( lua_State* L )
+		{
+			Int64 position = head;
+			if (position - Threading::Interlocked::Read(tail) >= capacity)
+			{
+				Threading::Interlocked::Increment(dropped);
+				return;
+			}
+
+			int index = static_cast<int>(position % capacity);
+			Sample& sample = samples[index];
+
+			lua_Debug ar;
+			int depth = 0;
+			for (int level = 0; depth < MaxDepth && ::lua_getstack(L, level, &ar); ++level, ++depth)
+			{
+				::lua_getinfo(L, "Snf", &ar);  // function
+
+				Frame& frame = sample.frames[depth];
+				strncpy_s(frame.source, ar.short_src, _TRUNCATE);
+				strncpy_s(frame.name, ar.name != NULL ? ar.name : "", _TRUNCATE);
+				frame.linedefined = ar.linedefined;
+				frame.what = ar.what[0];
+
+				clrFunctions[index * MaxDepth + depth] = frame.what == 'C' ? toCLRFunction(L) : nullptr;
+
+				::lua_settop(L, -2);  // function
+			}
+
+			sample.depth = depth;
+
+			Threading::Interlocked::Exchange(head, position + 1);
+		}
+
+	private:
+		// the delegate of the cfunction on the top of the stack if it is a CLR function; otherwise, null
+		Object^ toCLRFunction( lua_State* L )
+		{
+			Object^ function = nullptr;
+
+			if (::lua_getupvalue(L, -1, 1) == NULL)
+				return nullptr;
+
+			if (::lua_type(L, -1) == LUA_TUSERDATA_ && ::lua_getmetatable(L, -1))
+			{
+				::lua_rawgeti(L, LUA_REGISTRYINDEX_, objectMetatableRef);
+				if (::lua_rawequal(L, -1, -2))
+					function = getCFunctionDelegate(*static_cast<int*>(::lua_touserdata(L, -3)));
+				::lua_settop(L, -3);  // metatables
+			}
+
+			::lua_settop(L, -2);  // upvalue
+			return function;
+		}
+
+		String^ frameLabel( int index, int depth )
+		{
+			Delegate^ function = dynamic_cast<Delegate^>(clrFunctions[index * MaxDepth + depth]);
+			clrFunctions[index * MaxDepth + depth] = nullptr;
+
+			if (function != nullptr)
+			{
+				Reflection::MethodInfo^ method = function->Method;
+				return method->DeclaringType != nullptr ? String::Concat(method->DeclaringType->FullName, ".", method->Name) : method->Name;
+			}
+
+			const Frame& frame = samples[index].frames[depth];
+			String^ name = frame.name[0] != '\0' ? toCLRString(frame.name, encoding) : "?";
+
+			switch (frame.what)
+			{
+				case 'm':
+					return String::Concat("main ", toCLRString(frame.source, encoding));
+
+				case 'C':
+					return String::Concat(name, " [C]");
+
+				default:
+					return String::Format("{0} {1}:{2}", name, toCLRString(frame.source, encoding), frame.linedefined);
+			}
+		}
+
+	public:
+		// removes the captured samples, each as its frames from outermost to innermost separated by semicolons
+		array<String^>^ Drain()
+		{
+			Int64 start = tail;
+			Int64 end = Threading::Interlocked::Read(head);
+			array<String^>^ stacks = gcnew array<String^>(static_cast<int>(end - start));
+
+			Text::StringBuilder^ builder = gcnew Text::StringBuilder();
+			for (int i = 0; i < stacks->Length; ++i)
+			{
+				int index = static_cast<int>((start + i) % capacity);
+
+				builder->Clear();
+				for (int depth = samples[index].depth - 1; depth >= 0; --depth)
+				{
+					builder->Append(frameLabel(index, depth)->Replace(';', ':'));
+					if (depth > 0)
+						builder->Append(';');
+				}
+
+				stacks[i] = builder->ToString();
+			}
+
+			Threading::Interlocked::Exchange(tail, end);
+			return stacks;
+		}
+	};
+
+	// finds which CLI objects a Lua state keeps alive, and through which references from the CLR
+	public ref class LuaReach
+	{
+	private:
+		luaW_Reach* reach;
+
+	public:
+		LuaReach()
+			: reach(::luaW_newreach())
+		{
+		}
+
+		~LuaReach()
+		{
+			this->!LuaReach();
+
+			GC::SuppressFinalize(this);
+		}
+
+		!LuaReach()
+		{
+			::luaW_freereach(reach);
+			reach = NULL;
+		}
+
+		// notes the tables at the slots of the table of references at tableRef in the registry as ephemerons,
+		// whose values are reachable only through their keys; must precede MarkRoots
+		void MarkEphemerons( LuaStatePtr L, int tableRef, array<int>^ ephemeronRefs )
+		{
+			pin_ptr<int> pin_ephemeronRefs = nullptr;
+			if (ephemeronRefs->Length != 0)
+				pin_ephemeronRefs = &ephemeronRefs[0];
+			::luaW_reachephemerons(reach, toLuaStatePtr(L), tableRef, pin_ephemeronRefs, ephemeronRefs->Length);
+		}
+
+		// marks what is reachable from the roots of the Lua state except the values of the excluded references
+		// in the registry; the metatables of the userdatas of CLI objects are referenced in the registry
+		void MarkRoots( LuaStatePtr L, array<int>^ excludedRefs, int objectMetatableRef, int partialMetatableRef )
+		{
+			pin_ptr<int> pin_excludedRefs = nullptr;
+			if (excludedRefs->Length != 0)
+				pin_excludedRefs = &excludedRefs[0];
+			::luaW_reachroots(reach, toLuaStatePtr(L), pin_excludedRefs, excludedRefs->Length, objectMetatableRef, partialMetatableRef);
+		}
+
+		// marks what is reachable from the value of each traced slot of the table of references at tableRef in
+		// the registry but not from the roots
+		void MarkTraced( LuaStatePtr L, int tableRef, array<int>^ tracedRefs )
+		{
+			pin_ptr<int> pin_tracedRefs = nullptr;
+			if (tracedRefs->Length != 0)
+				pin_tracedRefs = &tracedRefs[0];
+			::luaW_reachtraced(reach, toLuaStatePtr(L), tableRef, pin_tracedRefs, tracedRefs->Length);
+		}
+
+		// the slots of the CLI objects reachable from the roots (index -1) or from the traced reference at index
+		array<int>^ GetSlots( int index )
+		{
+			int n;
+			const int* slots = ::luaW_reachslots(reach, index, &n);
+			return toArray(slots, n);
+		}
+
+		// the indices of the traced references whose values are reachable from the traced reference at index
+		array<int>^ GetReferences( int index )
+		{
+			int n;
+			const int* refs = ::luaW_reachrefs(reach, index, &n);
+			return toArray(refs, n);
+		}
+
+	private:
+		static array<int>^ toArray( const int* values, int n )
+		{
+			array<int>^ result = gcnew array<int>(n);
+			for (int i = 0; i < n; ++i)
+				result[i] = values[i];
+			return result;
+		}
+	};
 
 	public ref class LuaInterjector
 	{
@@ -1794,15 +2320,25 @@ namespace Lua
 
 		LuaStatePtr L;
 
+		// the allocator whose soft limit is enforced, or NULL
+		StateAllocator* allocator;
+
+		// the sampler that captures the call stack when a sample is requested, or null
+		LuaSampler^ sampler;
+		bool sampleRequested;
+
 	internal:
 		LuaHook^ hookDelegate;
 
 	internal:
-		LuaInterjector( LuaStatePtr L )
+		LuaInterjector( LuaStatePtr L, StateAllocator* allocator )
 			: message(nullptr),
 			  cancelled(false),
 			  interjections(gcnew System::Collections::Concurrent::ConcurrentQueue<Interjection^>()),
-			  L(L)
+			  L(L),
+			  allocator(allocator),
+			  sampler(nullptr),
+			  sampleRequested(false)
 		{
 			hookDelegate = gcnew LuaHook(this, &LuaInterjector::hook);
 		}
@@ -1830,6 +2366,20 @@ namespace Lua
 			LuaWrapper::luaW_enablehook(L);
 		}
 
+		property LuaSampler^ Sampler
+		{
+			LuaSampler^ get() { return sampler; }
+			void set( LuaSampler^ value ) { sampler = value; }
+		}
+
+		// captures the call stack into the sampler at the next instruction
+		void RequestSample()
+		{
+			sampleRequested = true;
+
+			LuaWrapper::luaW_enablehook(L);
+		}
+
 	internal:
 		void hook( lua_State* L, lua_Debug* ar )
 		{
@@ -1844,11 +2394,34 @@ namespace Lua
 			{
 				luaW_disablehook(L);
 
+				if (sampleRequested && sampler != nullptr)
+				{
+					sampleRequested = false;
+					sampler->capture(L);
+				}
+
 				Interjection^ interjection;
 				while (interjections->TryDequeue(interjection))
 					interjection(this->L);
+
+				if (allocator != NULL && allocator->takeSoftLimitExceeded())
+					collectOverSoftLimit(L);
 			}
 		}
+
+	private:
+		// does an emergency step of garbage collection with work in proportion to the memory over the soft limit
+		void collectOverSoftLimit( lua_State* L )
+		{
+			size_t used = allocator->allocated() + allocator->external();
+			size_t softLimit = allocator->softLimit();
+
+			if (softLimit == 0 || used <= softLimit)
+				return;
+
+			size_t over = (used - softLimit) / 1024 + 1;
+			::lua_gc(L, LUA_GCSTEP_, over > INT_MAX ? INT_MAX : static_cast<int>(over));
+		}
 	};
 
 	public ref class LuaHelper
@@ -1857,17 +2430,53 @@ namespace Lua
 		// allocation tracker is necessary because lua_gc isn't thread-safe
 		static LuaStatePtr luaH_newstate( [Out] LuaAllocTracker^% memoryStats )
 		{
-			memoryStats = gcnew LuaAllocTracker();
-			return LuaWrapper::lua_newstate(LuaAllocPtr(LuaAllocTracker_alloc), IntPtr(memoryStats->_allocated));
+			return luaH_newstate(false, memoryStats);
+		}
+
+		// a pooled allocator serves small blocks from slabs of same-sized blocks
+		static LuaStatePtr luaH_newstate( bool pooled, [Out] LuaAllocTracker^% memoryStats )
+		{
+			memoryStats = gcnew LuaAllocTracker(pooled);
+			LuaStatePtr L = LuaWrapper::lua_newstate(LuaAllocPtr(StateAllocator::alloc), IntPtr(memoryStats->_allocator));
+			memoryStats->_allocator->setState(toLuaStatePtr(L));
+			return L;
 		}
 
 		static LuaInterjector^ luaH_setnewinterjectionhook( LuaStatePtr L )
 		{
-			LuaInterjector^ interjector = gcnew LuaInterjector(L);
+			return luaH_setnewinterjectionhook(L, nullptr);
+		}
+
+		// the interjection hook also collects garbage when the soft limit of the tracked allocator is exceeded
+		static LuaInterjector^ luaH_setnewinterjectionhook( LuaStatePtr L, LuaAllocTracker^ memoryStats )
+		{
+			LuaInterjector^ interjector = gcnew LuaInterjector(L, memoryStats != nullptr ? memoryStats->_allocator : NULL);
 
 			LuaWrapper::luaW_presethook(L, interjector->hookDelegate);
 
 			return interjector;
 		}
+
+		// describes the function at the index by where it is defined, without calling it
+		static String^ luaH_describefunction( LuaStatePtr L, int index, Encoding^ encoding )
+		{
+			lua_State* L_ = toLuaStatePtr(L);
+			lua_Debug ar;
+
+			::lua_pushvalue(L_, index);
+			::lua_getinfo(L_, ">S", &ar);  // function
+
+			switch (ar.what[0])
+			{
+				case 'm':
+					return String::Concat("main ", toCLRString(ar.short_src, encoding));
+
+				case 'C':
+					return "[C]";
+
+				default:
+					return String::Format("{0}:{1}", toCLRString(ar.short_src, encoding), ar.linedefined);
+			}
+		}
 	};
 }